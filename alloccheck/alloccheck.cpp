@@ -0,0 +1,86 @@
+#include <iostream> // std::cout
+#include <memory> // std::unique_ptr<T>
+#include <string> // std::string, std::to_string, std::stoi, std::stoull
+
+#include "../src/game.h" // Game instance class
+#include "../src/mylib.h" // getRandomSeed()
+#include "../src/rng.h" // GameRng, randomBelow()
+#include "alloccount.h" // GetThreadAllocations()
+
+// Usage: alloccheck [ticks] [width] [height] [seed]
+// Checks ticking never allocates once a game is reset, on every grid that promises it, exit code 1 if anything
+// allocated. Built as its own executable, so the counting operator new never ships in the game
+
+// Play a game with random turns and fruit respawns, and count heap allocations made while ticking, turning and
+// spawning fruit, and separately while restarting after game over
+template <typename Game>
+bool checkAllocations(const std::string& name, Game& game, int ticks, uint64_t seed, bool trackChanges) {
+    game.TrackChangedTiles(trackChanges);
+    game.Seed(seed);
+    game.Reset();
+
+    GameRng prng = GameRng(seed);
+    uint64_t tickAllocations = 0;
+    uint64_t resetAllocations = 0;
+    int games = 1;
+
+    for (int i = 0; i < ticks; i++) {
+        uint64_t before = GetThreadAllocations();
+        if (randomBelow(prng, 4) == 0) game.ChangeDirection((SnakeTypes::Direction)(randomBelow(prng, 4) + 1));
+        if (randomBelow(prng, 64) == 0) game.RespawnFruit();
+        game.Tick();
+        tickAllocations += GetThreadAllocations() - before;
+
+        if (game.IsGameOver()) {
+            before = GetThreadAllocations();
+            game.Reset();
+            resetAllocations += GetThreadAllocations() - before;
+            games++;
+        }
+    }
+
+    std::cout << name << (trackChanges ? ", tracking changes" : "") << ": "
+    << ticks << " ticks over " << games << " games, "
+    << tickAllocations << " allocations ticking, "
+    << resetAllocations << " restarting\n";
+
+    return tickAllocations == 0;
+}
+
+int main(int argc, char* argv[]) {
+    int ticks = argc > 1 ? std::stoi(argv[1]) : 1000000;
+    int width = argc > 2 ? std::stoi(argv[2]) : 31;
+    int height = argc > 3 ? std::stoi(argv[3]) : 15;
+    uint64_t seed = argc > 4 ? std::stoull(argv[4]) : getRandomSeed();
+
+    std::cout << "Seed " << seed << '\n';
+
+    bool clean = true;
+    for (int track = 0; track < 2; track++) {
+        uint64_t before = GetThreadAllocations();
+        SnakeGame flat = SnakeGame(width, height, seed);
+        PackedSnakeGame packed = PackedSnakeGame(width, height, seed);
+
+        // Creating games allocates their grids, not seeing that means allocations aren't being counted
+        if (GetThreadAllocations() == before) {
+            std::cout << "Allocations aren't being counted\n";
+            return 1;
+        }
+
+        // Fixed grids are over-aligned, so creating one on the heap takes the aligned operator new
+        before = GetThreadAllocations();
+        std::unique_ptr<FixedSnakeGame<31, 15>> fixedGame = std::unique_ptr<FixedSnakeGame<31, 15>>(new FixedSnakeGame<31, 15>());
+        FixedSnakeGame<31, 15>& fixed = *fixedGame;
+        if (GetThreadAllocations() == before) {
+            std::cout << "Aligned allocations aren't being counted\n";
+            return 1;
+        }
+
+        clean &= checkAllocations("SnakeGame " + std::to_string(width) + 'x' + std::to_string(height), flat, ticks, seed, track == 1);
+        clean &= checkAllocations("PackedSnakeGame " + std::to_string(width) + 'x' + std::to_string(height), packed, ticks, seed, track == 1);
+        clean &= checkAllocations("FixedSnakeGame<31, 15>", fixed, ticks, seed, track == 1);
+    }
+
+    std::cout << (clean ? "No allocations while ticking\n" : "Ticking allocated\n");
+    return clean ? 0 : 1;
+}
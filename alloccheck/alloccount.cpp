@@ -0,0 +1,77 @@
+#include <cstddef> // std::size_t
+#include <cstdlib> // std::malloc, std::free
+#include <new> // std::bad_alloc, std::get_new_handler, std::new_handler, std::align_val_t
+
+#ifndef _WIN32
+#include <stdlib.h> // posix_memalign()
+#else // _WIN32
+#include <malloc.h> // _aligned_malloc(), _aligned_free()
+#endif // _WIN32
+
+#include "alloccount.h" // Function declaration
+
+// Counted per thread, so counting costs no more than an increment and threads don't share a cache line
+static thread_local uint64_t threadAllocations = 0;
+
+uint64_t GetThreadAllocations() {
+    return threadAllocations;
+}
+
+// Global allocation functions, malloc with a count
+// Array and nothrow forms call this one by default
+void* operator new(std::size_t size) {
+    threadAllocations++;
+    if (size == 0) size = 1;
+
+    while (true) {
+        void* memory = std::malloc(size);
+        if (memory != nullptr) return memory;
+
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+// Over-aligned types (e.g. FixedSnakeGame, see GRID_ALIGNMENT) take these instead, array and nothrow aligned
+// forms call them by default
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    threadAllocations++;
+    if (size == 0) size = 1;
+
+    while (true) {
+#ifndef _WIN32
+        // posix_memalign() takes no alignment below a pointer's
+        std::size_t bytes = (std::size_t)alignment < sizeof(void*) ? sizeof(void*) : (std::size_t)alignment;
+        void* memory = nullptr;
+        if (posix_memalign(&memory, bytes, size) != 0) memory = nullptr;
+#else // _WIN32
+        void* memory = _aligned_malloc(size, (std::size_t)alignment);
+#endif // _WIN32
+        if (memory != nullptr) return memory;
+
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+#ifndef _WIN32
+    std::free(memory);
+#else // _WIN32
+    _aligned_free(memory);
+#endif // _WIN32
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t alignment) noexcept {
+    operator delete(memory, alignment);
+}
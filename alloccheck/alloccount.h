@@ -0,0 +1,11 @@
+#ifndef __ALLOCCOUNT_INCLUDED__
+#define __ALLOCCOUNT_INCLUDED__
+
+#include <cstdint> // uint64_t
+
+// Heap allocations made by the calling thread since it started
+// Counted by replacement global operator new in alloccount.cpp, which is only linked into the allocation check,
+// so the game and libraries built from its sources keep the host program's allocator
+uint64_t GetThreadAllocations();
+
+#endif // __ALLOCCOUNT_INCLUDED__
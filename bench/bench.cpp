@@ -0,0 +1,476 @@
+#include <iostream> // std::cout, std::cerr
+#include <chrono> // std::chrono::steady_clock, std::chrono::duration_cast, std::chrono::nanoseconds
+#include <functional> // std::function<T>
+#include <sstream> // std::ostringstream
+#include <string> // std::string, std::to_string
+#include <utility> // std::pair<T1, T2>
+#include <vector> // std::vector<T>
+
+#include "../src/arena.h" // SnakeArena
+#include "../src/autopilot.h" // Autopilot
+#include "../src/batch.h" // SnakeBatch
+#include "../src/game.h" // Game instance class
+#include "../src/latency.h" // LatencyHistogram
+#include "../src/mylib.h" // Helper functions
+#include "../src/render.h" // FrameRenderer, DrawGame()
+#include "../src/stats.h" // StreamingStats
+#include "../src/zobrist.h" // TranspositionTable, ZobristKeys
+
+// Usage: bench [--csv | --json] [filter]
+// Default output is a readable table, --csv and --json are for comparing runs between builds
+// Only benchmarks whose name contains filter are run
+
+// Single benchmark measurement
+struct BenchResult {
+    std::string name;
+    uint64_t iterations;
+    double nsPerOp;
+    // Tail of the per-op times, only measured by measureEach() (0 otherwise)
+    uint64_t p99NsPerOp;
+    uint64_t maxNsPerOp;
+};
+
+// Written to by benchmarks, so the compiler can't drop the measured work
+volatile uint64_t benchSink = 0;
+
+// Time iterations of op, after a short warm-up
+BenchResult measure(const std::string& name, uint64_t iterations, const std::function<void()>& op) {
+    for (uint64_t i = 0; i < iterations / 10 + 1; i++) op();
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; i++) op();
+    int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    return {name, iterations, (double)ns / (double)iterations, 0, 0};
+}
+
+// Time every iteration of op on its own, for ops with a latency bound, after a short warm-up
+// Includes reading the clock around every op, so only for ops well above the clock's own cost
+BenchResult measureEach(const std::string& name, uint64_t iterations, const std::function<void()>& op) {
+    for (uint64_t i = 0; i < iterations / 10 + 1; i++) op();
+
+    LatencyHistogram histogram;
+    int64_t total = 0;
+    for (uint64_t i = 0; i < iterations; i++) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        op();
+        int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+        histogram.Record(ns);
+        total += ns;
+    }
+
+    return {name, iterations, (double)total / (double)iterations, histogram.Percentile(0.99), histogram.GetMax()};
+}
+
+// Direction that makes the snake sweep the whole wrapping grid row by row without hitting itself,
+// as long as the snake is shorter than (width - 1) * height
+template <typename Game>
+SnakeGame::Direction sweepDirection(Game& game, uint64_t tick) {
+    uint64_t width = game.GetGridSizeHorizontal();
+    return tick % width == width - 1 ? SnakeGame::Direction::Down : SnakeGame::Direction::Right;
+}
+
+// Grow the snake to the given length by sweeping the grid, returns ticks played
+template <typename Game>
+uint64_t growSnake(Game& game, uint16_t length) {
+    game.SetSnakeLength(length);
+
+    uint64_t tick = 0;
+    for (; tick < length; tick++) {
+        game.ChangeDirection(sweepDirection(game, tick));
+        game.Tick();
+    }
+
+    return tick;
+}
+
+// Tick() with a snake of the given length
+template <typename Game>
+BenchResult benchTick(const std::string& name, int width, int height, uint16_t length, uint64_t ticks) {
+    Game game = Game(width, height, 1);
+    uint64_t tick = growSnake(game, length);
+
+    BenchResult result = measure(name, ticks, [&game, &tick]() {
+        game.ChangeDirection(sweepDirection(game, tick));
+        game.Tick();
+        tick++;
+    });
+
+    if (game.IsGameOver()) {
+        std::cerr << "warning: snake died during " << name << '\n';
+    }
+
+    return result;
+}
+
+// Fruit spawning with the given share of the grid taken by the snake
+template <typename Game>
+BenchResult benchSpawn(const std::string& name, int width, int height, double fill, uint64_t spawns) {
+    Game game = Game(width, height, 1);
+    growSnake(game, (uint16_t)(width * height * fill));
+
+    return measure(name, spawns, [&game]() {
+        benchSink += game.RespawnFruit();
+    });
+}
+
+// Draw the whole board into a fresh frame, and send it to an in-memory stream instead of the terminal
+BenchResult benchRender(const std::string& name, int width, int height, uint64_t frames) {
+    SnakeGame game = SnakeGame(width, height, 1);
+    growSnake(game, (uint16_t)(width * height / 4));
+
+    FrameRenderer frame = FrameRenderer(width + 2, height + 3);
+    std::ostringstream stream;
+
+    return measure(name, frames, [&game, &frame, &stream]() {
+        frame.Invalidate();
+        DrawGame(frame, game, 0);
+        stream << frame.BuildDiff();
+
+        // Don't let the stream grow for the whole run
+        stream.str("");
+    });
+}
+
+// Autopilot decision followed by the tick it steers, starting new games whenever one ends
+// Timed one decision at a time, the budget bounds the slowest decision rather than the average
+BenchResult benchAutopilot(const std::string& name, int width, int height, uint64_t ticks) {
+    SnakeGame game = SnakeGame(width, height, 1);
+    Autopilot autopilot;
+
+    return measureEach(name, ticks, [&game, &autopilot]() {
+        if (game.IsGameOver()) game.Reset();
+
+        game.ChangeDirection(autopilot.Decide(game));
+        game.Tick();
+        benchSink += game.GetScore();
+    });
+}
+
+// Arena tick with snakes turning at random, dead snakes come back right away so the snake count stays up
+BenchResult benchArena(const std::string& name, int size, int snakeCount, int fruitCount, uint64_t ticks) {
+    SnakeArena arena = SnakeArena(size, size, snakeCount, fruitCount, 1);
+    GameRng prng = GameRng(2);
+
+    return measure(name, ticks, [&arena, &prng]() {
+        for (int i = 0; i < arena.GetSnakeCount(); i++) {
+            if (!arena.IsAlive(i)) arena.RespawnSnake(i);
+            if (arena.GetSnakeDirection(i) == SnakeTypes::Direction::None || randomBelow(prng, 8) == 0) {
+                arena.ChangeDirection(i, (SnakeTypes::Direction)(randomBelow(prng, 4) + 1));
+            }
+        }
+
+        arena.Tick();
+        benchSink += arena.GetAliveCount();
+    });
+}
+
+// Turns for batch benchmarks, one per game per tick for 64 ticks: usually keep going, sometimes turn
+std::vector<uint8_t> batchActions(int games) {
+    GameRng prng = GameRng(2);
+    std::vector<uint8_t> actions = std::vector<uint8_t>((size_t)games * 64);
+    for (size_t i = 0; i < actions.size(); i++) {
+        actions[i] = randomBelow(prng, 4) == 0 ? (uint8_t)(randomBelow(prng, 4) + 1) : 0;
+    }
+
+    return actions;
+}
+
+// One tick of every game in a SnakeBatch, finished games restart
+BenchResult benchBatch(const std::string& name, int games, int size, SnakeBatch::Kernel kernel, uint64_t steps) {
+    SnakeBatch batch = SnakeBatch(games, size, size, 1);
+    batch.SetKernel(kernel);
+    std::vector<uint8_t> actions = batchActions(games);
+    uint64_t step = 0;
+
+    return measure(name, steps, [&batch, &actions, &step, games]() {
+        batch.Step(actions.data() + (step++ % 64) * games);
+        batch.ResetFinished();
+    });
+}
+
+// Same turns and restarts on separate SnakeGame objects, for comparison
+BenchResult benchBatchObjects(const std::string& name, int games, int size, uint64_t steps) {
+    std::vector<SnakeGame> objects;
+    for (int i = 0; i < games; i++) objects.push_back(SnakeGame(size, size, 1 + i));
+    std::vector<uint8_t> actions = batchActions(games);
+    uint64_t step = 0;
+
+    return measure(name, steps, [&objects, &actions, &step, games]() {
+        const uint8_t* tickActions = actions.data() + (step++ % 64) * games;
+        for (int i = 0; i < games; i++) {
+            if (tickActions[i] != 0) objects[i].ChangeDirection((SnakeTypes::Direction)tickActions[i]);
+            objects[i].Tick();
+            if (objects[i].IsGameOver()) objects[i].Reset();
+        }
+    });
+}
+
+// Ways of cloning a game state
+enum class CloneMethod { Copy, Snapshot, Fork, ForkAndTick };
+
+// Clone a game with a snake filling a quarter of the grid
+BenchResult benchClone(const std::string& name, int size, CloneMethod method, uint64_t clones) {
+    SnakeGame game = SnakeGame(size, size, 1);
+    growSnake(game, (uint16_t)(size * size / 4));
+
+    CowSnakeGame cowGame = CowSnakeGame(size, size, 1);
+    growSnake(cowGame, (uint16_t)(size * size / 4));
+
+    std::vector<uint8_t> buffer = std::vector<uint8_t>(game.GetSnapshotSize());
+    SnakeGame restored = SnakeGame(size, size, 2);
+
+    switch (method) {
+        case CloneMethod::Copy:
+            return measure(name, clones, [&game]() {
+                SnakeGame copy = game;
+                benchSink += copy.GetScore();
+            });
+        case CloneMethod::Snapshot:
+            return measure(name, clones, [&game, &buffer, &restored]() {
+                size_t size = game.SaveSnapshot(buffer.data());
+                benchSink += restored.RestoreSnapshot(buffer.data(), size);
+            });
+        case CloneMethod::Fork:
+            return measure(name, clones, [&cowGame]() {
+                CowSnakeGame fork = cowGame.Fork();
+                benchSink += fork.GetScore();
+            });
+        default:
+            // Forks only pay for copying pages once they write to them
+            return measure(name, clones, [&cowGame]() {
+                CowSnakeGame fork = cowGame.Fork();
+                fork.Tick();
+                benchSink += fork.GetScore();
+            });
+    }
+}
+
+// Store or probe states spread over a table bigger than the caches, half of the probes finding nothing
+BenchResult benchTable(const std::string& name, bool store, uint64_t ops) {
+    TranspositionTable table = TranspositionTable((size_t)64 << 20);
+    uint64_t i = 0;
+
+    if (store) {
+        return measure(name, ops, [&table, &i]() {
+            table.Store(ZobristKeys::mix(i), {(int32_t)i, (uint16_t)(i & 63), (uint8_t)(i & 3), 0});
+            i++;
+        });
+    }
+
+    for (uint64_t j = 0; j < ops; j += 2) table.Store(ZobristKeys::mix(j), {(int32_t)j, 1, 0, 0});
+    return measure(name, ops, [&table, &i]() {
+        TranspositionTable::Entry entry;
+        benchSink += table.Probe(ZobristKeys::mix(i++), entry) ? entry.value : 0;
+    });
+}
+
+int main(int argc, char* argv[]) {
+    std::string format = "table";
+    std::string filter = "";
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--csv") format = "csv";
+        else if (arg == "--json") format = "json";
+        else filter = arg;
+    }
+
+    // Benchmarks by name, run in this order
+    std::vector<std::pair<std::string, std::function<BenchResult(const std::string&)>>> benchmarks;
+
+    // Tick cost should stay flat from starting length up to a snake filling the 255x255 grid
+    // Snake keeps eating while sweeping, so the longest case stays below the full grid to leave room to grow
+    std::vector<uint16_t> lengths = {4, 64, 1024, 16384, 32768, 60000};
+    for (size_t i = 0; i < lengths.size(); i++) {
+        uint16_t length = lengths[i];
+        benchmarks.push_back({"tick/255x255/length" + std::to_string(length), [length](const std::string& name) {
+            return benchTick<SnakeGame>(name, 255, 255, length, 200000);
+        }});
+    }
+
+    // Same game on every grid storage variant, at the size main() plays on
+    benchmarks.push_back({"tick/31x15/flat", [](const std::string& name) {
+        return benchTick<SnakeGame>(name, 31, 15, 64, 20000);
+    }});
+    benchmarks.push_back({"tick/31x15/fixed", [](const std::string& name) {
+        return benchTick<FixedSnakeGame<31, 15>>(name, 31, 15, 64, 20000);
+    }});
+    benchmarks.push_back({"tick/31x15/packed", [](const std::string& name) {
+        return benchTick<PackedSnakeGame>(name, 31, 15, 64, 20000);
+    }});
+
+    // Fruit spawning should cost the same however full the grid is
+    std::vector<int> fillPercents = {0, 50, 90, 99};
+    for (size_t i = 0; i < fillPercents.size(); i++) {
+        int fill = fillPercents[i];
+        benchmarks.push_back({"spawnFruit/255x255/fill" + std::to_string(fill), [fill](const std::string& name) {
+            return benchSpawn<SnakeGame>(name, 255, 255, fill / 100.0, 1000000);
+        }});
+    }
+
+    // Chunked grids trade a scan of one chunk per spawn, and a division per tile access, for memory that grows
+    // with the snake instead of the grid area
+    benchmarks.push_back({"tick/255x255/chunked/length16384", [](const std::string& name) {
+        return benchTick<ChunkedSnakeGame>(name, 255, 255, 16384, 200000);
+    }});
+    benchmarks.push_back({"tick/16384x16384/chunked/length1024", [](const std::string& name) {
+        return benchTick<ChunkedSnakeGame>(name, 16384, 16384, 1024, 200000);
+    }});
+    benchmarks.push_back({"spawnFruit/255x255/chunked/fill50", [](const std::string& name) {
+        return benchSpawn<ChunkedSnakeGame>(name, 255, 255, 0.5, 200000);
+    }});
+    benchmarks.push_back({"spawnFruit/16384x16384/chunked/fill0", [](const std::string& name) {
+        return benchSpawn<ChunkedSnakeGame>(name, 16384, 16384, 0, 200000);
+    }});
+
+    // Random number helpers, with the per-thread engine and with a caller-owned one
+    benchmarks.push_back({"getRandomNumbers/8of255", [](const std::string& name) {
+        return measure(name, 200000, []() {
+            benchSink += getRandomNumbers(8, 0, 254)[0];
+        });
+    }});
+    benchmarks.push_back({"getUniqueRandomNumbers/8of255", [](const std::string& name) {
+        return measure(name, 200000, []() {
+            benchSink += getUniqueRandomNumbers(8, 0, 254)[0];
+        });
+    }});
+    benchmarks.push_back({"getUniqueRandomNumbers/8of255/gameRng", [](const std::string& name) {
+        GameRng rng = GameRng(1);
+        return measure(name, 200000, [&rng]() {
+            benchSink += getUniqueRandomNumbers(rng, 8, 0, 254)[0];
+        });
+    }});
+
+    benchmarks.push_back({"sortVectorInt/1000", [](const std::string& name) {
+        GameRng rng = GameRng(1);
+        std::vector<int> numbers = getRandomNumbers(rng, 1000, 0, 1000000);
+        return measure(name, 200, [&numbers]() {
+            benchSink += sortVectorInt(numbers)[0];
+        });
+    }});
+
+    // Per-game result aggregation, Add() includes the Welford update, the exact sum and the percentile sketch
+    benchmarks.push_back({"streamingStats/add", [](const std::string& name) {
+        StreamingStats stats;
+        uint64_t i = 0;
+        return measure(name, 1000000, [&stats, &i]() {
+            stats.Add((int64_t)(i++ % 5000));
+            benchSink += stats.GetCount();
+        });
+    }});
+    benchmarks.push_back({"calcAvgInt/1000", [](const std::string& name) {
+        GameRng rng = GameRng(1);
+        std::vector<int> numbers = getRandomNumbers(rng, 1000, 0, 1000000);
+        return measure(name, 2000, [&numbers]() {
+            benchSink += calcAvgInt(numbers.data(), numbers.size());
+        });
+    }});
+
+    // Cloning a game for search, deep copy vs snapshot round trip vs copy-on-write fork
+    std::vector<int> cloneSizes = {16, 64, 255};
+    for (size_t i = 0; i < cloneSizes.size(); i++) {
+        int size = cloneSizes[i];
+        std::string grid = std::to_string(size) + "x" + std::to_string(size);
+        uint64_t clones = size < 255 ? 20000 : 2000;
+
+        benchmarks.push_back({"clone/copy/" + grid, [size, clones](const std::string& name) {
+            return benchClone(name, size, CloneMethod::Copy, clones);
+        }});
+        benchmarks.push_back({"clone/snapshot/" + grid, [size, clones](const std::string& name) {
+            return benchClone(name, size, CloneMethod::Snapshot, clones);
+        }});
+        benchmarks.push_back({"clone/fork/" + grid, [size, clones](const std::string& name) {
+            return benchClone(name, size, CloneMethod::Fork, clones);
+        }});
+        benchmarks.push_back({"clone/forkAndTick/" + grid, [size, clones](const std::string& name) {
+            return benchClone(name, size, CloneMethod::ForkAndTick, clones);
+        }});
+    }
+
+    benchmarks.push_back({"transpositionTable/store", [](const std::string& name) {
+        return benchTable(name, true, 2000000);
+    }});
+    benchmarks.push_back({"transpositionTable/probe", [](const std::string& name) {
+        return benchTable(name, false, 2000000);
+    }});
+
+    // Includes the rebuilds after every fruit, spread over a few decisions on big grids
+    benchmarks.push_back({"autopilot/decideAndTick/31x15", [](const std::string& name) {
+        return benchAutopilot(name, 31, 15, 200000);
+    }});
+    benchmarks.push_back({"autopilot/decideAndTick/255x255", [](const std::string& name) {
+        return benchAutopilot(name, 255, 255, 200000);
+    }});
+
+    // Cost per tick should grow with snake count, not grid size
+    std::vector<int> snakeCounts = {16, 256, 1024};
+    for (size_t i = 0; i < snakeCounts.size(); i++) {
+        int snakeCount = snakeCounts[i];
+        benchmarks.push_back({"arena/255x255/snakes" + std::to_string(snakeCount), [snakeCount](const std::string& name) {
+            return benchArena(name, 255, snakeCount, snakeCount / 4, 20000);
+        }});
+    }
+    benchmarks.push_back({"arena/64x64/snakes256", [](const std::string& name) {
+        return benchArena(name, 64, 256, 64, 20000);
+    }});
+
+    // Thousands of small games stepped in lockstep, per kernel the CPU has, against as many separate games
+    benchmarks.push_back({"batch/16x16/games4096/objects", [](const std::string& name) {
+        return benchBatchObjects(name, 4096, 16, 200);
+    }});
+    std::vector<SnakeBatch::Kernel> kernels = {SnakeBatch::Kernel::Scalar, SnakeBatch::Kernel::SSE41, SnakeBatch::Kernel::AVX2};
+    for (size_t i = 0; i < kernels.size(); i++) {
+        SnakeBatch::Kernel kernel = kernels[i];
+        if (!SnakeBatch::KernelSupported(kernel)) continue;
+
+        benchmarks.push_back({"batch/16x16/games4096/" + std::string(SnakeBatch::KernelName(kernel)), [kernel](const std::string& name) {
+            return benchBatch(name, 4096, 16, kernel, 200);
+        }});
+    }
+
+    // Full redraw, as on the first frame or after Invalidate()
+    benchmarks.push_back({"render/31x15/full", [](const std::string& name) {
+        return benchRender(name, 31, 15, 20000);
+    }});
+    benchmarks.push_back({"render/255x255/full", [](const std::string& name) {
+        return benchRender(name, 255, 255, 200);
+    }});
+
+    std::vector<BenchResult> results;
+    for (size_t i = 0; i < benchmarks.size(); i++) {
+        if (!filter.empty() && benchmarks[i].first.find(filter) == std::string::npos) continue;
+
+        results.push_back(benchmarks[i].second(benchmarks[i].first));
+
+        // Table is printed as results come in, the machine-readable formats all at once
+        if (format == "table") {
+            std::cout << results.back().name << ": " << results.back().nsPerOp << " ns/op";
+            if (results.back().maxNsPerOp > 0) {
+                std::cout << " (p99 " << results.back().p99NsPerOp << " ns, max " << results.back().maxNsPerOp << " ns)";
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    if (format == "csv") {
+        std::cout << "name,iterations,ns_per_op,p99_ns,max_ns\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            std::cout << results[i].name << ',' << results[i].iterations << ',' << results[i].nsPerOp
+                << ',' << results[i].p99NsPerOp << ',' << results[i].maxNsPerOp << '\n';
+        }
+    } else if (format == "json") {
+        std::cout << "{\"benchmarks\": [\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            std::cout << "  {\"name\": \"" << results[i].name
+                << "\", \"iterations\": " << results[i].iterations
+                << ", \"ns_per_op\": " << results[i].nsPerOp
+                << ", \"p99_ns\": " << results[i].p99NsPerOp
+                << ", \"max_ns\": " << results[i].maxNsPerOp << '}'
+                << (i + 1 < results.size() ? "," : "") << '\n';
+        }
+        std::cout << "]}\n";
+    }
+
+    return 0;
+}
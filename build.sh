@@ -1,5 +1,15 @@
 #!/bin/bash
 
 cd $(dirname "$0")
-g++ src/*.cpp -o build/snake -Wall -Wextra
+mkdir -p build
+g++ src/*.cpp -o build/snake -O2 -Wall -Wextra -pthread
 
+# Benchmarks link every game source except the interactive main()
+g++ bench/*.cpp $(ls src/*.cpp | grep -v -e src/main.cpp) -o build/bench -O2 -Wall -Wextra -pthread
+
+# Allocation check, the only executable with the counting operator new
+g++ alloccheck/*.cpp $(ls src/*.cpp | grep -v -e src/main.cpp) -o build/alloccheck -O2 -Wall -Wextra -pthread
+
+
+# C API shared library, only the functions declared in src/snakeapi.h are exported
+g++ $(ls src/*.cpp | grep -v -e src/main.cpp) -o build/libsnake.so -shared -fPIC -fvisibility=hidden -O2 -Wall -Wextra -pthread
@@ -0,0 +1,349 @@
+#include <algorithm> // std::fill
+#include <limits> // std::numeric_limits<T>
+#include <vector> // std::vector<T>
+
+#include "mylib.h" // getRandomSeed()
+
+#include "arena.h" // Class declaration
+
+// freeCellSlots value for tiles that aren't empty
+static const uint32_t NOT_FREE = std::numeric_limits<uint32_t>::max();
+
+// targets value for snakes that don't move this tick, and for snakes that die this tick
+static const uint32_t NO_TARGET = std::numeric_limits<uint32_t>::max();
+static const uint32_t DYING = NO_TARGET - 1;
+
+// Length of a newly placed snake, same as SnakeGame
+static const uint32_t START_LENGTH = 4;
+
+SnakeArena::SnakeArena(int x, int y, int snakeCount, int fruitCount) : SnakeArena(x, y, snakeCount, fruitCount, getRandomSeed()) {}
+
+SnakeArena::SnakeArena(int x, int y, int snakeCount, int fruitCount, uint64_t rngSeed) {
+    ClampGridSize(x, y);
+
+    this->map.Resize(x, y);
+    this->snakes.resize(snakeCount > 0 ? (size_t)snakeCount : 0);
+
+    // Fruit tiles store their index in 16 bits
+    if (fruitCount < 0) fruitCount = 0;
+    if (fruitCount > std::numeric_limits<uint16_t>::max()) fruitCount = std::numeric_limits<uint16_t>::max();
+    this->fruitTarget = fruitCount;
+
+    this->Seed(rngSeed);
+    this->Reset();
+}
+
+void SnakeArena::Reset() {
+    this->map.Clear();
+
+    uint32_t area = (uint32_t)this->map.Width() * this->map.Height();
+
+    // Every tile starts empty, index them in order
+    this->freeCells.resize(area);
+    this->freeCellSlots.resize(area);
+    for (uint32_t i = 0; i < area; i++) {
+        this->freeCells[i] = i;
+        this->freeCellSlots[i] = i;
+    }
+
+    this->links.assign(area, 0);
+    this->fruitSlots.assign(area, 0);
+    this->claimStamps.assign(area, 0);
+    this->claims.assign(area, 0);
+    this->stamp = 0;
+
+    // A tick changes at most three tiles per snake, plus tiles of dead snakes and the fruits that respawn on them
+    this->targets.assign(this->snakes.size(), NO_TARGET);
+    this->changedTiles.clear();
+    this->changedTiles.reserve((size_t)area * 2 + this->snakes.size() * 3);
+
+    this->tick = 0;
+    this->aliveCount = 0;
+
+    // Snakes take their tiles in order, then fruits
+    for (size_t i = 0; i < this->snakes.size(); i++) {
+        this->snakes[i] = Snake();
+        this->placeSnake(this->snakes[i]);
+    }
+
+    this->fruits.clear();
+    this->fruits.reserve(this->fruitTarget);
+    while ((int)this->fruits.size() < this->fruitTarget && this->spawnFruit()) {}
+
+    // Whole grid changed
+    this->changedTiles.clear();
+    for (int i = 0; i < this->map.Height(); i++) {
+        for (int j = 0; j < this->map.Width(); j++) {
+            this->changedTiles.push_back({(Coord)j, (Coord)i});
+        }
+    }
+}
+
+void SnakeArena::Tick() {
+    this->changedTiles.clear();
+    this->tick++;
+
+    // New claim stamp, clear the old ones only when the counter wraps around
+    if (++this->stamp == 0) {
+        std::fill(this->claimStamps.begin(), this->claimStamps.end(), 0);
+        this->stamp = 1;
+    }
+
+    uint32_t width = (uint32_t)this->map.Width();
+
+    // Where every head moves to, and how many heads move onto each of those tiles
+    for (size_t i = 0; i < this->snakes.size(); i++) {
+        Snake& snake = this->snakes[i];
+        if (!snake.alive || snake.direction == Direction::None) {
+            this->targets[i] = NO_TARGET;
+            continue;
+        }
+
+        uint32_t target = this->step((uint32_t)snake.head.y * width + snake.head.x, snake.direction);
+        this->targets[i] = target;
+
+        if (this->claimStamps[target] != this->stamp) {
+            this->claimStamps[target] = this->stamp;
+            this->claims[target] = 1;
+        } else if (this->claims[target] < std::numeric_limits<uint8_t>::max()) {
+            this->claims[target]++;
+        }
+    }
+
+    // Decide every death against the grid as it was before the tick, so no snake sees another one's move
+    for (size_t i = 0; i < this->snakes.size(); i++) {
+        uint32_t target = this->targets[i];
+        if (target == NO_TARGET) continue;
+
+        if (this->map.Get(target) == (uint8_t)Tile::Snake || this->claims[target] > 1) {
+            this->targets[i] = DYING;
+        }
+    }
+
+    // Move survivors, their targets are distinct tiles that aren't snake, so the order doesn't matter
+    uint32_t area = (uint32_t)this->freeCellSlots.size();
+    for (size_t i = 0; i < this->snakes.size(); i++) {
+        uint32_t target = this->targets[i];
+        if (target >= DYING) continue;
+
+        Snake& snake = this->snakes[i];
+
+        if (this->map.Get(target) == (uint8_t)Tile::Fruit) {
+            if (snake.score < std::numeric_limits<uint16_t>::max()) snake.score++;
+            if (snake.length < area) snake.length++;
+
+            // Take the fruit off the list, last fruit moves into its slot
+            uint16_t slot = this->fruitSlots[target];
+            Position last = this->fruits.back();
+            this->fruits[slot] = last;
+            this->fruitSlots[(uint32_t)last.y * width + last.x] = slot;
+            this->fruits.pop_back();
+        }
+
+        // Old head links to the new one
+        this->links[(uint32_t)snake.head.y * width + snake.head.x] = (uint8_t)snake.direction;
+        this->setTile(target, Tile::Snake);
+        snake.head = {(Coord)(target % width), (Coord)(target / width)};
+        snake.size++;
+
+        // Remove tail bit, if max size was reached
+        if (snake.size > snake.length) {
+            uint32_t tail = (uint32_t)snake.tail.y * width + snake.tail.x;
+            uint32_t next = this->step(tail, (Direction)this->links[tail]);
+
+            this->setTile(tail, Tile::Empty);
+            snake.tail = {(Coord)(next % width), (Coord)(next / width)};
+            snake.size--;
+        }
+    }
+
+    // Take dead snakes off the grid
+    for (size_t i = 0; i < this->snakes.size(); i++) {
+        if (this->targets[i] != DYING) continue;
+
+        this->clearSnake(this->snakes[i]);
+    }
+
+    // Replace eaten fruits, and any that didn't fit before
+    while ((int)this->fruits.size() < this->fruitTarget && this->spawnFruit()) {}
+}
+
+void SnakeArena::ChangeDirection(int index, Direction newDir) {
+    Snake& snake = this->snakes[index];
+
+    // If new direction would be opposite current direction, do nothing
+    if (newDir == Direction::Left && snake.direction == Direction::Right) return;
+    if (newDir == Direction::Right && snake.direction == Direction::Left) return;
+    if (newDir == Direction::Up && snake.direction == Direction::Down) return;
+    if (newDir == Direction::Down && snake.direction == Direction::Up) return;
+
+    snake.direction = newDir;
+}
+
+bool SnakeArena::RespawnSnake(int index) {
+    Snake& snake = this->snakes[index];
+    if (snake.alive) return false;
+
+    return this->placeSnake(snake);
+}
+
+int SnakeArena::GetSnakeCount() {
+    return (int)this->snakes.size();
+}
+
+int SnakeArena::GetAliveCount() {
+    return this->aliveCount;
+}
+
+bool SnakeArena::IsAlive(int index) {
+    return this->snakes[index].alive;
+}
+
+uint16_t SnakeArena::GetScore(int index) {
+    return this->snakes[index].score;
+}
+
+uint32_t SnakeArena::GetSnakeLength(int index) {
+    return this->snakes[index].length;
+}
+
+SnakeTypes::Direction SnakeArena::GetSnakeDirection(int index) {
+    return this->snakes[index].direction;
+}
+
+SnakeTypes::Position SnakeArena::GetSnakeHeadPos(int index) {
+    return this->snakes[index].head;
+}
+
+SnakeTypes::Position SnakeArena::GetSnakeTailPos(int index) {
+    return this->snakes[index].tail;
+}
+
+const std::vector<SnakeTypes::Position>& SnakeArena::GetFruits() {
+    return this->fruits;
+}
+
+const std::vector<SnakeTypes::Position>& SnakeArena::GetChangedTiles() {
+    return this->changedTiles;
+}
+
+uint64_t SnakeArena::GetTickCount() {
+    return this->tick;
+}
+
+uint32_t SnakeArena::GetFreeTileCount() {
+    return (uint32_t)this->freeCells.size();
+}
+
+uint32_t SnakeArena::GetGridSizeHorizontal() {
+    return (uint32_t)this->map.Width();
+}
+
+uint32_t SnakeArena::GetGridSizeVertical() {
+    return (uint32_t)this->map.Height();
+}
+
+SnakeTypes::Tile SnakeArena::GetTile(int x, int y) {
+    return (Tile)this->map.Get((uint32_t)y * this->map.Width() + x);
+}
+
+void SnakeArena::Seed(uint64_t rngSeed) {
+    this->seed = rngSeed;
+    this->rng.seed(rngSeed);
+}
+
+uint64_t SnakeArena::GetSeed() {
+    return this->seed;
+}
+
+uint32_t SnakeArena::step(uint32_t cell, Direction dir) const {
+    uint32_t width = (uint32_t)this->map.Width();
+    uint32_t height = (uint32_t)this->map.Height();
+    uint32_t x = cell % width;
+    uint32_t y = cell / width;
+
+    // Loop through walls on hit
+    switch (dir) {
+        case Direction::Left: x = x == 0 ? width - 1 : x - 1; break;
+        case Direction::Right: x = x + 1 == width ? 0 : x + 1; break;
+        case Direction::Up: y = y == 0 ? height - 1 : y - 1; break;
+        case Direction::Down: y = y + 1 == height ? 0 : y + 1; break;
+        default: break;
+    }
+
+    return y * width + x;
+}
+
+bool SnakeArena::placeSnake(Snake& snake) {
+    if (this->freeCells.empty()) return false;
+
+    uint32_t cell = this->freeCells[randomBelow(this->rng, (uint32_t)this->freeCells.size())];
+    uint32_t width = (uint32_t)this->map.Width();
+    uint32_t area = (uint32_t)this->freeCellSlots.size();
+
+    this->setTile(cell, Tile::Snake);
+
+    snake.head = {(Coord)(cell % width), (Coord)(cell / width)};
+    snake.tail = snake.head;
+    snake.size = 1;
+    snake.length = area < START_LENGTH ? area : START_LENGTH;
+    snake.score = 0;
+    snake.direction = Direction::None;
+    snake.alive = true;
+    this->aliveCount++;
+
+    return true;
+}
+
+void SnakeArena::clearSnake(Snake& snake) {
+    uint32_t width = (uint32_t)this->map.Width();
+
+    // Follow the links from tail to head
+    uint32_t cell = (uint32_t)snake.tail.y * width + snake.tail.x;
+    for (uint32_t i = 0; i < snake.size; i++) {
+        uint32_t next = this->step(cell, (Direction)this->links[cell]);
+        this->setTile(cell, Tile::Empty);
+        cell = next;
+    }
+
+    snake.size = 0;
+    snake.alive = false;
+    this->aliveCount--;
+}
+
+bool SnakeArena::spawnFruit() {
+    if (this->freeCells.empty()) return false;
+
+    uint32_t cell = this->freeCells[randomBelow(this->rng, (uint32_t)this->freeCells.size())];
+    uint32_t width = (uint32_t)this->map.Width();
+
+    this->setTile(cell, Tile::Fruit);
+    this->fruitSlots[cell] = (uint16_t)this->fruits.size();
+    this->fruits.push_back({(Coord)(cell % width), (Coord)(cell / width)});
+
+    return true;
+}
+
+void SnakeArena::setTile(uint32_t cell, Tile newTile) {
+    bool wasEmpty = this->map.Get(cell) == (uint8_t)Tile::Empty;
+
+    this->map.Set(cell, (uint8_t)newTile);
+
+    uint32_t width = (uint32_t)this->map.Width();
+    this->changedTiles.push_back({(Coord)(cell % width), (Coord)(cell / width)});
+
+    if (wasEmpty && newTile != Tile::Empty) {
+        // Tile got filled, move last free tile into its slot
+        uint32_t slot = this->freeCellSlots[cell];
+        uint32_t last = this->freeCells.back();
+
+        this->freeCells[slot] = last;
+        this->freeCellSlots[last] = slot;
+        this->freeCells.pop_back();
+        this->freeCellSlots[cell] = NOT_FREE;
+    } else if (!wasEmpty && newTile == Tile::Empty) {
+        // Tile got emptied, append it to the free tiles
+        this->freeCellSlots[cell] = (uint32_t)this->freeCells.size();
+        this->freeCells.push_back(cell);
+    }
+}
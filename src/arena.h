@@ -0,0 +1,125 @@
+#ifndef __ARENA_INCLUDED__
+#define __ARENA_INCLUDED__
+
+#include <cstdint> // uint8_t, uint16_t, uint32_t, uint64_t
+#include <vector> // std::vector<T>
+
+#include "game.h" // SnakeTypes
+#include "grid.h" // FlatGrid
+#include "rng.h" // GameRng
+
+// Many snakes on one shared grid, each with its own direction and score, and several fruits at once
+//
+// Every snake moves at the same time, so a tick doesn't depend on the order snakes are stored in:
+//   - A snake dies if its head moves onto any snake tile, including tails that would move away this tick
+//     (the same rule SnakeGame uses for the snake's own tail)
+//   - Snakes whose heads move onto the same tile all die
+//   - Dead snakes are removed from the grid, and only come back through RespawnSnake()
+//   - Eaten fruits respawn once every snake has moved, in the order the snakes are stored in
+//
+// Snake bodies are linked through the grid (each body tile stores the direction to the next tile towards the head),
+// so memory doesn't grow with snake count, and a tick only visits the tiles of snakes that moved, died or ate
+class SnakeArena : public SnakeTypes {
+public:
+    // Create variable-size rectangle (same limits as SnakeGame), with the given amount of snakes and fruits
+    SnakeArena(int, int, int snakes, int fruits);
+    // Same, with a fixed RNG seed for reproducible games
+    SnakeArena(int, int, int snakes, int fruits, uint64_t);
+
+    // Clear the grid, place every snake and fruit on a random empty tile
+    void Reset();
+    // Move every living snake by one tile
+    void Tick();
+    // Turn a snake (Does nothing if opposite its current direction)
+    void ChangeDirection(int snake, Direction);
+    // Bring a dead snake back on a random empty tile, with the starting length and no score
+    // Returns false if it's alive, or there's no room
+    bool RespawnSnake(int snake);
+
+    // Amount of snakes, living or not
+    int GetSnakeCount();
+    // Amount of living snakes
+    int GetAliveCount();
+    bool IsAlive(int snake);
+    // Fruits eaten by a snake since it was last placed
+    uint16_t GetScore(int snake);
+    // How long a snake should currently be
+    uint32_t GetSnakeLength(int snake);
+    Direction GetSnakeDirection(int snake);
+    Position GetSnakeHeadPos(int snake);
+    Position GetSnakeTailPos(int snake);
+    // Positions of fruits currently on the grid, in no particular order (fewer than asked for once the grid fills up)
+    const std::vector<Position>& GetFruits();
+    // Tiles changed by the last Tick() and any RespawnSnake() calls since, for redrawing only what changed
+    // After Reset() it lists every tile
+    const std::vector<Position>& GetChangedTiles();
+
+    // Ticks since Reset()
+    uint64_t GetTickCount();
+    // Returns amount of empty tiles left on the grid
+    uint32_t GetFreeTileCount();
+    uint32_t GetGridSizeHorizontal();
+    uint32_t GetGridSizeVertical();
+    Tile GetTile(int x, int y);
+
+    // Reseed the RNG engine, call Reset() afterwards to replay from the start
+    void Seed(uint64_t);
+    uint64_t GetSeed();
+
+private:
+    struct Snake {
+        Position head;
+        Position tail;
+        // Tiles the snake takes up
+        uint32_t size;
+        // Tiles it should take up, grows by one tile per tick until reached
+        uint32_t length;
+        uint16_t score;
+        Direction direction;
+        bool alive;
+    };
+
+    FlatGrid map;
+    std::vector<Snake> snakes;
+    int aliveCount;
+    uint64_t tick;
+
+    // Direction from each snake tile to the next one towards the head (unused on other tiles)
+    std::vector<uint8_t> links;
+
+    // Fruits asked for, and the ones on the grid
+    int fruitTarget;
+    std::vector<Position> fruits;
+    // Index into fruits of each fruit tile (unused on other tiles)
+    std::vector<uint16_t> fruitSlots;
+
+    // Dense array of empty tile indices, and the position of every tile in it (see BasicSnakeGame)
+    std::vector<uint32_t> freeCells;
+    std::vector<uint32_t> freeCellSlots;
+
+    // Heads moving onto each tile this tick, valid where claimStamps matches the tick
+    // Stamps are compared instead of clearing the whole grid every tick
+    std::vector<uint32_t> claimStamps;
+    std::vector<uint8_t> claims;
+    uint32_t stamp;
+
+    // Per-tick scratch, sized by Reset() so ticks don't allocate
+    std::vector<uint32_t> targets;
+    std::vector<Position> changedTiles;
+
+    GameRng rng;
+    uint64_t seed;
+
+    // Tile index one step from a tile in a direction, wrapping around the edges like SnakeGame
+    uint32_t step(uint32_t cell, Direction) const;
+    // Put a snake on a random empty tile, returns false if there's no room
+    bool placeSnake(Snake&);
+    // Take a dead snake's tiles off the grid
+    void clearSnake(Snake&);
+    // Spawn fruit on a random empty tile, returns false if the grid is full
+    bool spawnFruit();
+    // Set tile, keeping the empty tile index up to date and recording the change
+    void setTile(uint32_t cell, Tile);
+};
+
+#endif // __ARENA_INCLUDED__
@@ -0,0 +1,417 @@
+#include <algorithm> // std::push_heap, std::pop_heap
+#include <functional> // std::greater<T>
+
+#include "autopilot.h" // Class declaration
+
+// Directions in the order neighbours() returns tiles
+static const SnakeTypes::Direction DIRECTIONS[4] = {
+    SnakeTypes::Direction::Up,
+    SnakeTypes::Direction::Down,
+    SnakeTypes::Direction::Left,
+    SnakeTypes::Direction::Right
+};
+
+// Would turning from one direction to the other be ignored by ChangeDirection()
+static bool isOpposite(SnakeTypes::Direction a, SnakeTypes::Direction b) {
+    return (a == SnakeTypes::Direction::Up && b == SnakeTypes::Direction::Down)
+    || (a == SnakeTypes::Direction::Down && b == SnakeTypes::Direction::Up)
+    || (a == SnakeTypes::Direction::Left && b == SnakeTypes::Direction::Right)
+    || (a == SnakeTypes::Direction::Right && b == SnakeTypes::Direction::Left);
+}
+
+static bool samePosition(SnakeTypes::Position a, SnakeTypes::Position b) {
+    return a.x == b.x && a.y == b.y;
+}
+
+// Definitions for constants passed by reference
+const uint32_t Autopilot::DefaultBudget;
+const uint32_t Autopilot::UNREACHABLE;
+
+Autopilot::Autopilot() {
+    this->width = 0;
+    this->height = 0;
+    this->budget = DefaultBudget;
+    this->work = 0;
+    this->valid = false;
+    this->rebuilding = false;
+    this->rebuildCell = 0;
+    this->rebuildNext = 0;
+    this->lastHead = {0, 0};
+    this->lastTail = {0, 0};
+    this->lastFruit = {0, 0};
+    this->lastFreeTiles = 0;
+}
+
+void Autopilot::SetBudget(uint32_t tiles) {
+    // Repairs around the head need a few dozen tiles, less than that would rebuild all the time
+    this->budget = tiles < 256 ? 256 : tiles;
+}
+
+void Autopilot::Invalidate() {
+    this->valid = false;
+    this->rebuilding = false;
+}
+
+uint32_t Autopilot::GetLastWork() const {
+    return this->work;
+}
+
+bool Autopilot::IsFieldReady() const {
+    return this->valid;
+}
+
+template <typename Game>
+SnakeTypes::Direction Autopilot::Decide(Game& game) {
+    this->work = 0;
+
+    SnakeTypes::Direction current = game.GetSnakeDirection();
+    if (game.IsGameOver()) return current;
+
+    this->sync(game);
+
+    SnakeTypes::Position head = game.GetSnakeHeadPos();
+    SnakeTypes::Position fruit = game.GetFruitPos();
+
+    uint32_t next[4];
+    this->neighbours((uint32_t)head.y * this->width + head.x, next);
+
+    // Lowest score wins, ties go to going straight
+    int best = -1;
+    uint64_t bestScore = 0;
+    for (int i = 0; i < 4; i++) {
+        if (this->blocked[next[i]] || isOpposite(current, DIRECTIONS[i])) continue;
+
+        uint64_t score;
+        if (!this->valid) {
+            // Field isn't ready, head straight for the fruit
+            score = this->gridDistance(next[i], fruit);
+        } else if (this->dist[next[i]] != UNREACHABLE) {
+            score = this->dist[next[i]];
+        } else {
+            // Fruit can't be reached from there, prefer tiles with more room around them, after every tile that can
+            uint32_t around[4];
+            this->neighbours(next[i], around);
+
+            uint32_t open = 0;
+            for (int j = 0; j < 4; j++) open += !this->blocked[around[j]];
+            score = (uint64_t)UNREACHABLE + 4 - open;
+        }
+
+        if (best == -1 || score < bestScore || (score == bestScore && DIRECTIONS[i] == current)) {
+            best = i;
+            bestScore = score;
+        }
+    }
+
+    // Boxed in, nothing to do but keep going
+    if (best == -1) return current == SnakeTypes::Direction::None ? SnakeTypes::Direction::Up : current;
+
+    return DIRECTIONS[best];
+}
+
+template <typename Game>
+void Autopilot::sync(Game& game) {
+    int w = game.GetGridSizeHorizontal();
+    int h = game.GetGridSizeVertical();
+    if (w != this->width || h != this->height) {
+        this->width = w;
+        this->height = h;
+        this->dist.assign((size_t)w * h, UNREACHABLE);
+        this->blocked.assign((size_t)w * h, 0);
+        this->valid = false;
+        this->rebuilding = false;
+    }
+
+    SnakeTypes::Position head = game.GetSnakeHeadPos();
+    SnakeTypes::Position tail = game.GetSnakeTailPos();
+    SnakeTypes::Position fruit = game.GetFruitPos();
+    uint32_t freeTiles = game.GetFreeTileCount();
+
+    bool headMoved = !samePosition(head, this->lastHead);
+    bool tailMoved = !samePosition(tail, this->lastTail);
+    uint32_t oldTail = (uint32_t)this->lastTail.y * this->width + this->lastTail.x;
+
+    // A single tick moves the head by one tile, and the tail by at most one, anything else (new fruit,
+    // several ticks, a reset or another game entirely) needs a rebuild
+    bool restart = !this->valid && !this->rebuilding;
+    bool changed = false;
+    if (!restart && !samePosition(fruit, this->lastFruit)) {
+        restart = true;
+    } else if (!restart && (headMoved || tailMoved || freeTiles != this->lastFreeTiles)) {
+        changed = true;
+        restart = !headMoved || !this->adjacent(head, this->lastHead)
+        || (tailMoved && !this->adjacent(tail, this->lastTail))
+        || freeTiles + 1 != this->lastFreeTiles + (tailMoved ? 1 : 0);
+    }
+
+    this->lastHead = head;
+    this->lastTail = tail;
+    this->lastFruit = fruit;
+    this->lastFreeTiles = freeTiles;
+
+    if (restart) {
+        this->startRebuild();
+    } else if (changed) {
+        uint32_t headCell = (uint32_t)head.y * this->width + head.x;
+
+        if (this->rebuilding) {
+            // Checked once the rebuild is done
+            this->pendingChanges.push_back(headCell);
+            if (tailMoved) this->pendingChanges.push_back(oldTail);
+        } else if (!this->applyChange(game, headCell) || (tailMoved && !this->applyChange(game, oldTail))) {
+            this->startRebuild();
+        }
+    }
+
+    if (!this->rebuilding || !this->continueRebuild(game)) return;
+
+    // Field is complete, catch up on what changed while it was built
+    this->rebuilding = false;
+    this->valid = true;
+    for (size_t i = 0; i < this->pendingChanges.size(); i++) {
+        if (!this->applyChange(game, this->pendingChanges[i])) {
+            this->startRebuild();
+            return;
+        }
+    }
+    this->pendingChanges.clear();
+}
+
+void Autopilot::startRebuild() {
+    this->valid = false;
+    this->rebuilding = true;
+    this->rebuildCell = 0;
+    this->rebuildQueue.clear();
+    this->rebuildNext = 0;
+    this->pendingChanges.clear();
+}
+
+template <typename Game>
+bool Autopilot::continueRebuild(Game& game) {
+    // Copy the grid a bit at a time, so a big grid doesn't blow the budget of a single decision
+    uint32_t area = (uint32_t)this->width * this->height;
+    if (this->rebuildCell < area) {
+        int x = (int)(this->rebuildCell % this->width);
+        int y = (int)(this->rebuildCell / this->width);
+
+        while (this->rebuildCell < area && this->work < this->budget) {
+            this->blocked[this->rebuildCell] = game.GetTile(x, y) == SnakeTypes::Tile::Snake;
+            this->dist[this->rebuildCell] = UNREACHABLE;
+
+            this->work++;
+            this->rebuildCell++;
+            if (++x == this->width) {
+                x = 0;
+                y++;
+            }
+        }
+
+        // Whole grid copied, start the BFS at the fruit
+        if (this->rebuildCell < area) return false;
+
+        uint32_t fruitCell = (uint32_t)this->lastFruit.y * this->width + this->lastFruit.x;
+        this->dist[fruitCell] = 0;
+        this->rebuildQueue.push_back(fruitCell);
+    }
+
+    while (this->rebuildNext < this->rebuildQueue.size() && this->work < this->budget) {
+        uint32_t cell = this->rebuildQueue[this->rebuildNext++];
+        uint32_t next = this->dist[cell] + 1;
+        this->work++;
+
+        uint32_t around[4];
+        this->neighbours(cell, around);
+        for (int i = 0; i < 4; i++) {
+            if (this->blocked[around[i]] || this->dist[around[i]] != UNREACHABLE) continue;
+
+            this->dist[around[i]] = next;
+            this->rebuildQueue.push_back(around[i]);
+        }
+    }
+
+    return this->rebuildNext == this->rebuildQueue.size();
+}
+
+template <typename Game>
+bool Autopilot::applyChange(Game& game, uint32_t cell) {
+    bool isSnake = game.GetTile((int)(cell % this->width), (int)(cell / this->width)) == SnakeTypes::Tile::Snake;
+    this->blocked[cell] = isSnake;
+
+    return isSnake ? this->block(cell) : this->unblock(cell);
+}
+
+bool Autopilot::block(uint32_t cell) {
+    if (this->dist[cell] == UNREACHABLE) return true;
+
+    // Find every tile whose shortest paths all went through this one, level by level outwards,
+    // a tile keeps its distance if any neighbour one step closer to the fruit still has its own
+    this->queue.clear();
+    this->queueDist.clear();
+    this->queue.push_back(cell);
+    this->queueDist.push_back(this->dist[cell]);
+    this->dist[cell] = UNREACHABLE;
+
+    for (size_t i = 0; i < this->queue.size(); i++) {
+        if (this->work >= this->budget) return false;
+        this->work++;
+
+        uint32_t d = this->queueDist[i];
+        uint32_t around[4];
+        this->neighbours(this->queue[i], around);
+
+        for (int j = 0; j < 4; j++) {
+            uint32_t n = around[j];
+            if (this->blocked[n] || this->dist[n] != d + 1) continue;
+
+            uint32_t support[4];
+            this->neighbours(n, support);
+
+            bool supported = false;
+            for (int k = 0; k < 4; k++) {
+                if (!this->blocked[support[k]] && this->dist[support[k]] == d) {
+                    supported = true;
+                    break;
+                }
+            }
+
+            if (!supported) {
+                this->queue.push_back(n);
+                this->queueDist.push_back(this->dist[n]);
+                this->dist[n] = UNREACHABLE;
+            }
+        }
+    }
+
+    // Give every lost tile the best distance its surviving neighbours offer, then spread those outwards,
+    // closest first (Dijkstra with a binary heap, keyed by distance << 32 | tile)
+    this->heap.clear();
+    for (size_t i = 1; i < this->queue.size(); i++) {
+        uint32_t c = this->queue[i];
+        uint32_t around[4];
+        this->neighbours(c, around);
+
+        uint32_t best = UNREACHABLE;
+        for (int j = 0; j < 4; j++) {
+            if (!this->blocked[around[j]] && this->dist[around[j]] != UNREACHABLE && this->dist[around[j]] + 1u < best) {
+                best = this->dist[around[j]] + 1u;
+            }
+        }
+
+        if (best != UNREACHABLE) {
+            this->dist[c] = best;
+            this->heap.push_back((uint64_t)best << 32 | c);
+            std::push_heap(this->heap.begin(), this->heap.end(), std::greater<uint64_t>());
+        }
+    }
+
+    while (!this->heap.empty()) {
+        std::pop_heap(this->heap.begin(), this->heap.end(), std::greater<uint64_t>());
+        uint64_t top = this->heap.back();
+        this->heap.pop_back();
+
+        uint32_t c = (uint32_t)top;
+        uint32_t d = (uint32_t)(top >> 32);
+        if (d != this->dist[c]) continue;
+        if (this->work >= this->budget) return false;
+        this->work++;
+
+        uint32_t around[4];
+        this->neighbours(c, around);
+        for (int j = 0; j < 4; j++) {
+            uint32_t n = around[j];
+            if (this->blocked[n] || this->dist[n] <= d + 1) continue;
+
+            this->dist[n] = d + 1;
+            this->heap.push_back((uint64_t)(d + 1) << 32 | n);
+            std::push_heap(this->heap.begin(), this->heap.end(), std::greater<uint64_t>());
+        }
+    }
+
+    return true;
+}
+
+bool Autopilot::unblock(uint32_t cell) {
+    uint32_t fruitCell = (uint32_t)this->lastFruit.y * this->width + this->lastFruit.x;
+
+    uint32_t best = UNREACHABLE;
+    if (cell == fruitCell) {
+        best = 0;
+    } else {
+        uint32_t around[4];
+        this->neighbours(cell, around);
+        for (int i = 0; i < 4; i++) {
+            if (!this->blocked[around[i]] && this->dist[around[i]] != UNREACHABLE && this->dist[around[i]] + 1u < best) {
+                best = this->dist[around[i]] + 1u;
+            }
+        }
+    }
+
+    if (best >= this->dist[cell]) return true;
+    this->dist[cell] = best;
+
+    // Shorter distances spread outwards one step at a time, so a plain BFS queue keeps them in order
+    this->queue.clear();
+    this->queue.push_back(cell);
+    for (size_t i = 0; i < this->queue.size(); i++) {
+        if (this->work >= this->budget) return false;
+        this->work++;
+
+        uint32_t c = this->queue[i];
+        uint32_t next = this->dist[c] + 1;
+
+        uint32_t around[4];
+        this->neighbours(c, around);
+        for (int j = 0; j < 4; j++) {
+            uint32_t n = around[j];
+            if (this->blocked[n] || this->dist[n] <= next) continue;
+
+            this->dist[n] = next;
+            this->queue.push_back(n);
+        }
+    }
+
+    return true;
+}
+
+void Autopilot::neighbours(uint32_t cell, uint32_t out[4]) const {
+    uint32_t w = (uint32_t)this->width;
+    uint32_t h = (uint32_t)this->height;
+    uint32_t x = cell % w;
+    uint32_t y = cell / w;
+
+    out[0] = y == 0 ? cell + (h - 1) * w : cell - w;
+    out[1] = y == h - 1 ? x : cell + w;
+    out[2] = x == 0 ? cell + w - 1 : cell - 1;
+    out[3] = x == w - 1 ? cell - x : cell + 1;
+}
+
+bool Autopilot::adjacent(SnakeTypes::Position a, SnakeTypes::Position b) const {
+    int dx = a.x > b.x ? a.x - b.x : b.x - a.x;
+    int dy = a.y > b.y ? a.y - b.y : b.y - a.y;
+
+    // Opposite edges touch through the wrap-around
+    if (dx == this->width - 1 && this->width > 1) dx = 1;
+    if (dy == this->height - 1 && this->height > 1) dy = 1;
+
+    return dx + dy == 1;
+}
+
+uint32_t Autopilot::gridDistance(uint32_t cell, SnakeTypes::Position target) const {
+    int x = (int)(cell % this->width);
+    int y = (int)(cell / this->width);
+
+    int dx = x > (int)target.x ? x - (int)target.x : (int)target.x - x;
+    int dy = y > (int)target.y ? y - (int)target.y : (int)target.y - y;
+
+    // Going the other way around may be shorter
+    if (this->width - dx < dx) dx = this->width - dx;
+    if (this->height - dy < dy) dy = this->height - dy;
+
+    return (uint32_t)(dx + dy);
+}
+
+// Game variants the autopilot can drive, add new ones here like at the end of game.cpp
+template SnakeTypes::Direction Autopilot::Decide<SnakeGame>(SnakeGame&);
+template SnakeTypes::Direction Autopilot::Decide<PackedSnakeGame>(PackedSnakeGame&);
+template SnakeTypes::Direction Autopilot::Decide<CowSnakeGame>(CowSnakeGame&);
+template SnakeTypes::Direction Autopilot::Decide<FixedSnakeGame<31, 15>>(FixedSnakeGame<31, 15>&);
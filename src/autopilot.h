@@ -0,0 +1,102 @@
+#ifndef __AUTOPILOT_INCLUDED__
+#define __AUTOPILOT_INCLUDED__
+
+#include <cstdint> // uint8_t, uint32_t, uint64_t
+#include <vector> // std::vector<T>
+
+#include "game.h" // SnakeTypes
+
+// Steers a game towards the fruit, along shortest paths that avoid the snake and wrap around the edges like move()
+//
+// Keeps a distance field (steps from every tile to the fruit) and only repairs the tiles affected by each tick:
+// the new head blocks a tile, the freed tail unblocks one. When the fruit moves the field is rebuilt with a BFS,
+// spread over as many decisions as the work budget needs, steering greedily towards the fruit in the meantime
+// Any repair that would go over the budget is turned into a rebuild, so no decision visits more tiles than that
+//
+// Decide() works with every game variant instantiated at the end of autopilot.cpp
+class Autopilot {
+public:
+    // Tiles a single decision may visit by default
+    // The budget counts tiles instead of microseconds, so decisions (and replays of autopiloted games) don't depend
+    // on machine speed or load. A tile costs roughly 10-20 ns, so 4096 tiles keeps decisions on a 255x255 grid to
+    // about 70 us at p99 (see the p99 and max of the autopilot/decideAndTick/255x255 benchmark, the max also
+    // catches the thread being descheduled). Lower it for a tighter bound
+    static const uint32_t DefaultBudget = 4096;
+
+    Autopilot();
+
+    // Most tiles a single decision may visit
+    void SetBudget(uint32_t);
+    // Forget the distance field, the next decision starts a rebuild (e.g. after loading another game)
+    void Invalidate();
+
+    // Pick the direction for the next tick, call before every Tick()
+    template <typename Game>
+    SnakeTypes::Direction Decide(Game&);
+
+    // Tiles visited by the last decision
+    uint32_t GetLastWork() const;
+    // Is the distance field complete (false while rebuilding)
+    bool IsFieldReady() const;
+
+private:
+    // Distance value for blocked and unreachable tiles
+    static const uint32_t UNREACHABLE = 0xFFFFFFFF;
+
+    int width;
+    int height;
+    uint32_t budget;
+    uint32_t work;
+
+    // Steps from each tile to the fruit
+    std::vector<uint32_t> dist;
+    // Copy of which tiles are snake, so the field doesn't have to ask the game for every tile it visits
+    std::vector<uint8_t> blocked;
+    // Is the field built, and has it been kept in sync with the game
+    bool valid;
+    // Is a rebuild still running
+    bool rebuilding;
+    // Next tile to copy into blocked, rebuilds copy the whole grid before the BFS starts
+    uint32_t rebuildCell;
+    // BFS queue of a rebuild, kept between decisions
+    std::vector<uint32_t> rebuildQueue;
+    size_t rebuildNext;
+    // Tiles that changed while rebuilding, re-checked once the rebuild finishes
+    std::vector<uint32_t> pendingChanges;
+
+    // Game state the field was last synced with
+    SnakeTypes::Position lastHead;
+    SnakeTypes::Position lastTail;
+    SnakeTypes::Position lastFruit;
+    uint32_t lastFreeTiles;
+
+    // Scratch space for repairs, reused so decisions don't allocate after the first few
+    std::vector<uint32_t> queue;
+    std::vector<uint32_t> queueDist;
+    std::vector<uint64_t> heap;
+
+    // Bring the field up to date with the game
+    template <typename Game>
+    void sync(Game&);
+    // Throw away the field and start a rebuild
+    void startRebuild();
+    // Continue a rebuild within the budget, returns true once it's done
+    template <typename Game>
+    bool continueRebuild(Game&);
+    // Update the field after a tile changed, returns false if it needed more than the budget
+    template <typename Game>
+    bool applyChange(Game&, uint32_t);
+    // Tile got blocked, raise distances that depended on it, returns false if it needed more than the budget
+    bool block(uint32_t);
+    // Tile got unblocked, lower distances that can go through it, returns false if it needed more than the budget
+    bool unblock(uint32_t);
+
+    // Tiles next to a tile, in Up, Down, Left, Right order, wrapping around the edges
+    void neighbours(uint32_t, uint32_t out[4]) const;
+    // Are two tiles next to each other (with wrap-around)
+    bool adjacent(SnakeTypes::Position, SnakeTypes::Position) const;
+    // Steps between two tiles on an empty grid (with wrap-around)
+    uint32_t gridDistance(uint32_t, SnakeTypes::Position) const;
+};
+
+#endif // __AUTOPILOT_INCLUDED__
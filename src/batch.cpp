@@ -0,0 +1,683 @@
+#include <cstring> // std::memcpy, std::memset
+#include <limits> // std::numeric_limits<T>
+#include <vector> // std::vector<T>
+
+#include "mylib.h" // getRandomSeed()
+
+#include "batch.h" // Class declaration
+
+// SIMD kernels are built with per-function target attributes and picked at runtime, so the rest of the
+// program doesn't need -mavx2 and still runs on CPUs without it
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SNAKE_BATCH_X86
+#include <immintrin.h> // SSE4.1 and AVX2 intrinsics
+#endif // __GNUC__ && x86
+
+// freeSlots value for tiles that aren't empty
+static const uint32_t NOT_FREE = std::numeric_limits<uint32_t>::max();
+
+// What the first pass of Step() decided for a game
+static const int32_t OUTCOME_STAY = 0;
+static const int32_t OUTCOME_MOVE = 1;
+static const int32_t OUTCOME_EAT = 2;
+static const int32_t OUTCOME_DIE = 3;
+
+// Score is clamped like SnakeGame::ModifyScore()
+static const int32_t MAX_SCORE = std::numeric_limits<uint8_t>::max();
+
+// Snapshot sections start on 8-byte boundaries, same as SnakeGame
+static size_t snapshotAlign(size_t offset) {
+    return (offset + 7) & ~(size_t)7;
+}
+
+// Everything the first pass of Step() reads and writes, lane i is game i
+struct StepLanes {
+    const uint8_t* actions;
+    const uint8_t* tiles;
+    int32_t* headX;
+    int32_t* headY;
+    int32_t* directions;
+    int32_t* scores;
+    int32_t* over;
+    uint32_t* targets;
+    int32_t* outcomes;
+    int count;
+    int32_t width;
+    int32_t height;
+    uint32_t area;
+};
+
+// First pass for games [begin, count), one at a time
+static void stepScalar(const StepLanes& lanes, int begin) {
+    for (int i = begin; i < lanes.count; i++) {
+        int32_t dir = lanes.directions[i];
+        int32_t action = lanes.actions[i];
+
+        // Opposite directions share an axis (Up/Down = 1, Left/Right = 2), turning onto the same axis only
+        // keeps the current direction
+        if (action != 0 && action <= (int32_t)SnakeTypes::Direction::Right && (action == dir || (action + 1) >> 1 != (dir + 1) >> 1)) {
+            dir = action;
+        }
+        lanes.directions[i] = dir;
+        lanes.outcomes[i] = OUTCOME_STAY;
+
+        if (dir == (int32_t)SnakeTypes::Direction::None || lanes.over[i] != 0) continue;
+
+        int32_t x = lanes.headX[i];
+        int32_t y = lanes.headY[i];
+
+        // Loop through walls on hit
+        switch ((SnakeTypes::Direction)dir) {
+            case SnakeTypes::Direction::Left: x = x == 0 ? lanes.width - 1 : x - 1; break;
+            case SnakeTypes::Direction::Right: x = x + 1 == lanes.width ? 0 : x + 1; break;
+            case SnakeTypes::Direction::Up: y = y == 0 ? lanes.height - 1 : y - 1; break;
+            default: y = y + 1 == lanes.height ? 0 : y + 1; break;
+        }
+
+        uint32_t cell = (uint32_t)y * (uint32_t)lanes.width + (uint32_t)x;
+        uint8_t tile = lanes.tiles[(size_t)i * lanes.area + cell];
+        lanes.targets[i] = cell;
+
+        if (tile == (uint8_t)SnakeTypes::Tile::Snake) {
+            // Snake hit itself, head stays where it was
+            lanes.over[i] = 1;
+            lanes.outcomes[i] = OUTCOME_DIE;
+            continue;
+        }
+
+        if (tile == (uint8_t)SnakeTypes::Tile::Fruit) {
+            if (lanes.scores[i] < MAX_SCORE) lanes.scores[i]++;
+            lanes.outcomes[i] = OUTCOME_EAT;
+        } else {
+            lanes.outcomes[i] = OUTCOME_MOVE;
+        }
+
+        lanes.headX[i] = x;
+        lanes.headY[i] = y;
+    }
+}
+
+#ifdef SNAKE_BATCH_X86
+
+// First pass four games at a time, tile lookups are scalar loads (SSE has no gather)
+// Returns the first game left for stepScalar()
+__attribute__((target("sse4.1")))
+static int stepSSE41(const StepLanes& lanes) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i two = _mm_set1_epi32(2);
+    const __m128i lastAction = _mm_set1_epi32((int32_t)SnakeTypes::Direction::Right);
+    const __m128i up = _mm_set1_epi32((int32_t)SnakeTypes::Direction::Up);
+    const __m128i down = _mm_set1_epi32((int32_t)SnakeTypes::Direction::Down);
+    const __m128i left = _mm_set1_epi32((int32_t)SnakeTypes::Direction::Left);
+    const __m128i right = _mm_set1_epi32((int32_t)SnakeTypes::Direction::Right);
+    const __m128i width = _mm_set1_epi32(lanes.width);
+    const __m128i height = _mm_set1_epi32(lanes.height);
+    const __m128i lastX = _mm_set1_epi32(lanes.width - 1);
+    const __m128i lastY = _mm_set1_epi32(lanes.height - 1);
+    const __m128i maxScore = _mm_set1_epi32(MAX_SCORE);
+
+    int i = 0;
+    for (; i + 4 <= lanes.count; i += 4) {
+        int32_t packedActions;
+        std::memcpy(&packedActions, lanes.actions + i, sizeof(packedActions));
+        __m128i action = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(packedActions));
+        __m128i dir = _mm_loadu_si128((const __m128i*)(lanes.directions + i));
+
+        // Turn unless the action is 0, out of range, or opposite the current direction (same axis, other way)
+        __m128i sameAxis = _mm_cmpeq_epi32(_mm_srli_epi32(_mm_add_epi32(action, one), 1), _mm_srli_epi32(_mm_add_epi32(dir, one), 1));
+        __m128i opposite = _mm_andnot_si128(_mm_cmpeq_epi32(action, dir), sameAxis);
+        __m128i ignored = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi32(action, zero), _mm_cmpgt_epi32(action, lastAction)), opposite);
+        dir = _mm_blendv_epi8(action, dir, ignored);
+        _mm_storeu_si128((__m128i*)(lanes.directions + i), dir);
+
+        __m128i over = _mm_loadu_si128((const __m128i*)(lanes.over + i));
+        __m128i moving = _mm_andnot_si128(_mm_cmpeq_epi32(dir, zero), _mm_cmpeq_epi32(over, zero));
+
+        // Comparisons give -1 for true: Left -1, Right +1, Up -1, Down +1
+        __m128i dx = _mm_sub_epi32(_mm_cmpeq_epi32(dir, left), _mm_cmpeq_epi32(dir, right));
+        __m128i dy = _mm_sub_epi32(_mm_cmpeq_epi32(dir, up), _mm_cmpeq_epi32(dir, down));
+        __m128i oldX = _mm_loadu_si128((const __m128i*)(lanes.headX + i));
+        __m128i oldY = _mm_loadu_si128((const __m128i*)(lanes.headY + i));
+        __m128i x = _mm_add_epi32(oldX, dx);
+        __m128i y = _mm_add_epi32(oldY, dy);
+
+        // Loop through walls on hit
+        x = _mm_blendv_epi8(x, lastX, _mm_cmpgt_epi32(zero, x));
+        x = _mm_blendv_epi8(x, zero, _mm_cmpeq_epi32(x, width));
+        y = _mm_blendv_epi8(y, lastY, _mm_cmpgt_epi32(zero, y));
+        y = _mm_blendv_epi8(y, zero, _mm_cmpeq_epi32(y, height));
+
+        __m128i cell = _mm_add_epi32(_mm_mullo_epi32(y, width), x);
+        _mm_storeu_si128((__m128i*)(lanes.targets + i), cell);
+
+        const uint8_t* grid = lanes.tiles + (size_t)i * lanes.area;
+        __m128i tile = _mm_setr_epi32(
+            grid[(uint32_t)_mm_cvtsi128_si32(cell)],
+            grid[(size_t)lanes.area + (uint32_t)_mm_extract_epi32(cell, 1)],
+            grid[(size_t)lanes.area * 2 + (uint32_t)_mm_extract_epi32(cell, 2)],
+            grid[(size_t)lanes.area * 3 + (uint32_t)_mm_extract_epi32(cell, 3)]
+        );
+
+        __m128i dies = _mm_and_si128(moving, _mm_cmpeq_epi32(tile, one));
+        __m128i eats = _mm_and_si128(moving, _mm_cmpeq_epi32(tile, two));
+        __m128i advances = _mm_andnot_si128(dies, moving);
+
+        _mm_storeu_si128((__m128i*)(lanes.over + i), _mm_sub_epi32(over, dies));
+
+        __m128i score = _mm_loadu_si128((const __m128i*)(lanes.scores + i));
+        _mm_storeu_si128((__m128i*)(lanes.scores + i), _mm_min_epi32(_mm_sub_epi32(score, eats), maxScore));
+
+        _mm_storeu_si128((__m128i*)(lanes.headX + i), _mm_blendv_epi8(oldX, x, advances));
+        _mm_storeu_si128((__m128i*)(lanes.headY + i), _mm_blendv_epi8(oldY, y, advances));
+
+        // Stay 0, move 1, eat 2, die 3
+        __m128i outcome = _mm_sub_epi32(_mm_sub_epi32(_mm_and_si128(moving, one), eats), _mm_add_epi32(dies, dies));
+        _mm_storeu_si128((__m128i*)(lanes.outcomes + i), outcome);
+    }
+
+    return i;
+}
+
+// First pass eight games at a time, tile lookups gather straight from the slab
+// Tile indices must fit a signed 32-bit offset, SetKernel() checks the slab size
+// Gathers read four bytes per tile, up to three past the slab's last tile, so the games those bytes fall in are
+// left to stepScalar() to stay inside the slab: the last game on grids of three tiles or more, up to three on
+// smaller ones
+// Returns the first game left for stepScalar()
+__attribute__((target("avx2")))
+static int stepAVX2(const StepLanes& lanes) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i two = _mm256_set1_epi32(2);
+    const __m256i lastAction = _mm256_set1_epi32((int32_t)SnakeTypes::Direction::Right);
+    const __m256i up = _mm256_set1_epi32((int32_t)SnakeTypes::Direction::Up);
+    const __m256i down = _mm256_set1_epi32((int32_t)SnakeTypes::Direction::Down);
+    const __m256i left = _mm256_set1_epi32((int32_t)SnakeTypes::Direction::Left);
+    const __m256i right = _mm256_set1_epi32((int32_t)SnakeTypes::Direction::Right);
+    const __m256i width = _mm256_set1_epi32(lanes.width);
+    const __m256i height = _mm256_set1_epi32(lanes.height);
+    const __m256i lastX = _mm256_set1_epi32(lanes.width - 1);
+    const __m256i lastY = _mm256_set1_epi32(lanes.height - 1);
+    const __m256i maxScore = _mm256_set1_epi32(MAX_SCORE);
+    const __m256i tileMask = _mm256_set1_epi32(0xFF);
+
+    // Offset of each lane's grid in the slab, moves on by eight grids every iteration
+    const __m256i gridStep = _mm256_set1_epi32((int32_t)(lanes.area * 8));
+    __m256i gridOffset = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32((int32_t)lanes.area));
+
+    // Games after the last lane that the three extra bytes of its gather can reach
+    int spareGames = (int)((3 + lanes.area - 1) / lanes.area);
+
+    int i = 0;
+    for (; i + 8 + spareGames <= lanes.count; i += 8) {
+        __m256i action = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(lanes.actions + i)));
+        __m256i dir = _mm256_loadu_si256((const __m256i*)(lanes.directions + i));
+
+        // Turn unless the action is 0, out of range, or opposite the current direction (same axis, other way)
+        __m256i sameAxis = _mm256_cmpeq_epi32(_mm256_srli_epi32(_mm256_add_epi32(action, one), 1), _mm256_srli_epi32(_mm256_add_epi32(dir, one), 1));
+        __m256i opposite = _mm256_andnot_si256(_mm256_cmpeq_epi32(action, dir), sameAxis);
+        __m256i ignored = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi32(action, zero), _mm256_cmpgt_epi32(action, lastAction)), opposite);
+        dir = _mm256_blendv_epi8(action, dir, ignored);
+        _mm256_storeu_si256((__m256i*)(lanes.directions + i), dir);
+
+        __m256i over = _mm256_loadu_si256((const __m256i*)(lanes.over + i));
+        __m256i moving = _mm256_andnot_si256(_mm256_cmpeq_epi32(dir, zero), _mm256_cmpeq_epi32(over, zero));
+
+        // Comparisons give -1 for true: Left -1, Right +1, Up -1, Down +1
+        __m256i dx = _mm256_sub_epi32(_mm256_cmpeq_epi32(dir, left), _mm256_cmpeq_epi32(dir, right));
+        __m256i dy = _mm256_sub_epi32(_mm256_cmpeq_epi32(dir, up), _mm256_cmpeq_epi32(dir, down));
+        __m256i oldX = _mm256_loadu_si256((const __m256i*)(lanes.headX + i));
+        __m256i oldY = _mm256_loadu_si256((const __m256i*)(lanes.headY + i));
+        __m256i x = _mm256_add_epi32(oldX, dx);
+        __m256i y = _mm256_add_epi32(oldY, dy);
+
+        // Loop through walls on hit
+        x = _mm256_blendv_epi8(x, lastX, _mm256_cmpgt_epi32(zero, x));
+        x = _mm256_blendv_epi8(x, zero, _mm256_cmpeq_epi32(x, width));
+        y = _mm256_blendv_epi8(y, lastY, _mm256_cmpgt_epi32(zero, y));
+        y = _mm256_blendv_epi8(y, zero, _mm256_cmpeq_epi32(y, height));
+
+        __m256i cell = _mm256_add_epi32(_mm256_mullo_epi32(y, width), x);
+        _mm256_storeu_si256((__m256i*)(lanes.targets + i), cell);
+
+        // Gather four bytes per lane, the tile is the lowest one
+        __m256i tile = _mm256_and_si256(_mm256_i32gather_epi32((const int*)lanes.tiles, _mm256_add_epi32(gridOffset, cell), 1), tileMask);
+        gridOffset = _mm256_add_epi32(gridOffset, gridStep);
+
+        __m256i dies = _mm256_and_si256(moving, _mm256_cmpeq_epi32(tile, one));
+        __m256i eats = _mm256_and_si256(moving, _mm256_cmpeq_epi32(tile, two));
+        __m256i advances = _mm256_andnot_si256(dies, moving);
+
+        _mm256_storeu_si256((__m256i*)(lanes.over + i), _mm256_sub_epi32(over, dies));
+
+        __m256i score = _mm256_loadu_si256((const __m256i*)(lanes.scores + i));
+        _mm256_storeu_si256((__m256i*)(lanes.scores + i), _mm256_min_epi32(_mm256_sub_epi32(score, eats), maxScore));
+
+        _mm256_storeu_si256((__m256i*)(lanes.headX + i), _mm256_blendv_epi8(oldX, x, advances));
+        _mm256_storeu_si256((__m256i*)(lanes.headY + i), _mm256_blendv_epi8(oldY, y, advances));
+
+        // Stay 0, move 1, eat 2, die 3
+        __m256i outcome = _mm256_sub_epi32(_mm256_sub_epi32(_mm256_and_si256(moving, one), eats), _mm256_add_epi32(dies, dies));
+        _mm256_storeu_si256((__m256i*)(lanes.outcomes + i), outcome);
+    }
+
+    return i;
+}
+
+#endif // SNAKE_BATCH_X86
+
+SnakeBatch::SnakeBatch(int games, int x, int y) : SnakeBatch(games, x, y, getRandomSeed()) {}
+
+SnakeBatch::SnakeBatch(int games, int x, int y, uint64_t rngSeed) {
+    ClampGridSize(x, y);
+
+    this->count = games > 0 ? games : 0;
+    this->width = (uint32_t)x;
+    this->height = (uint32_t)y;
+    this->area = this->width * this->height;
+
+    size_t gameCount = (size_t)this->count;
+    size_t cells = gameCount * this->area;
+
+    this->headX.assign(gameCount, 0);
+    this->headY.assign(gameCount, 0);
+    this->directions.assign(gameCount, 0);
+    this->ownScores.assign(gameCount, 0);
+    this->ownOver.assign(gameCount, 0);
+    this->scores = this->ownScores.data();
+    this->over = this->ownOver.data();
+    this->lengths.assign(gameCount, 0);
+    this->won.assign(gameCount, 0);
+    this->hasFruit.assign(gameCount, 0);
+    this->fruits.assign(gameCount, 0);
+
+    this->ownTiles.Resize(cells);
+    this->tiles = this->ownTiles.Data();
+    this->snakeCells.assign(cells, 0);
+    this->snakeFirst.assign(gameCount, 0);
+    this->snakeSizes.assign(gameCount, 0);
+    this->freeCells.assign(cells, 0);
+    this->freeSlots.assign(cells, 0);
+    this->freeCounts.assign(gameCount, 0);
+
+    this->rngs.resize(gameCount);
+    this->seeds.assign(gameCount, 0);
+
+    this->targets.assign(gameCount, 0);
+    this->outcomes.assign(gameCount, OUTCOME_STAY);
+    this->noActions.assign(gameCount, 0);
+
+    // Best kernel the CPU and slab size allow
+    this->kernel = Kernel::Scalar;
+    if (!this->SetKernel(Kernel::AVX2)) this->SetKernel(Kernel::SSE41);
+
+    for (int i = 0; i < this->count; i++) {
+        this->Seed(i, rngSeed + (uint64_t)i);
+        this->Reset(i);
+    }
+}
+
+void SnakeBatch::Reset(int game) {
+    size_t base = (size_t)game * this->area;
+
+    // Blank every tile, and index them all as empty in order
+    std::memset(this->tiles + base, (uint8_t)Tile::Empty, this->area);
+    for (uint32_t i = 0; i < this->area; i++) {
+        this->freeCells[base + i] = i;
+        this->freeSlots[base + i] = i;
+    }
+    this->freeCounts[game] = this->area;
+
+    // Snake head at centre tile
+    uint32_t centreX = this->width / 2;
+    uint32_t centreY = this->height / 2;
+    uint32_t centre = centreY * this->width + centreX;
+    this->setTile(game, centre, Tile::Snake);
+
+    this->scores[game] = 0;
+    this->over[game] = 0;
+    this->won[game] = 0;
+
+    this->snakeCells[base] = centre;
+    this->snakeFirst[game] = 0;
+    this->snakeSizes[game] = 1;
+    this->headX[game] = (int32_t)centreX;
+    this->headY[game] = (int32_t)centreY;
+
+    // Same starting length and direction as SnakeGame
+    this->lengths[game] = 4;
+    this->directions[game] = (int32_t)Direction::None;
+    this->outcomes[game] = OUTCOME_STAY;
+
+    // Spawn first fruit, a 1x1 grid is already full
+    if (!this->spawnFruit(game)) {
+        this->won[game] = 1;
+        this->over[game] = 1;
+    }
+}
+
+void SnakeBatch::ResetAll() {
+    for (int i = 0; i < this->count; i++) this->Reset(i);
+}
+
+int SnakeBatch::ResetFinished() {
+    int finished = 0;
+    for (int i = 0; i < this->count; i++) {
+        if (this->over[i] == 0) continue;
+
+        this->Reset(i);
+        finished++;
+    }
+
+    return finished;
+}
+
+void SnakeBatch::Step(const uint8_t* actions) {
+    StepLanes lanes;
+    lanes.actions = actions != nullptr ? actions : this->noActions.data();
+    lanes.tiles = this->tiles;
+    lanes.headX = this->headX.data();
+    lanes.headY = this->headY.data();
+    lanes.directions = this->directions.data();
+    lanes.scores = this->scores;
+    lanes.over = this->over;
+    lanes.targets = this->targets.data();
+    lanes.outcomes = this->outcomes.data();
+    lanes.count = this->count;
+    lanes.width = (int32_t)this->width;
+    lanes.height = (int32_t)this->height;
+    lanes.area = this->area;
+
+    // Turns, movement, lookups, deaths and scores for every game at once, leftover games one at a time
+    int done = 0;
+#ifdef SNAKE_BATCH_X86
+    if (this->kernel == Kernel::AVX2) done = stepAVX2(lanes);
+    else if (this->kernel == Kernel::SSE41) done = stepSSE41(lanes);
+#endif // SNAKE_BATCH_X86
+    stepScalar(lanes, done);
+
+    // Grid and bookkeeping for the games that moved
+    for (int i = 0; i < this->count; i++) {
+        if (this->outcomes[i] == OUTCOME_MOVE || this->outcomes[i] == OUTCOME_EAT) this->settle(i);
+    }
+}
+
+void SnakeBatch::ChangeDirection(int game, Direction newDir) {
+    Direction dir = (Direction)this->directions[game];
+
+    // If new direction would be opposite current direction, do nothing
+    if (newDir == Direction::Left && dir == Direction::Right) return;
+    if (newDir == Direction::Right && dir == Direction::Left) return;
+    if (newDir == Direction::Up && dir == Direction::Down) return;
+    if (newDir == Direction::Down && dir == Direction::Up) return;
+
+    this->directions[game] = (int32_t)newDir;
+}
+
+int SnakeBatch::GetGameCount() {
+    return this->count;
+}
+
+uint32_t SnakeBatch::GetGridSizeHorizontal() {
+    return this->width;
+}
+
+uint32_t SnakeBatch::GetGridSizeVertical() {
+    return this->height;
+}
+
+uint16_t SnakeBatch::GetScore(int game) {
+    return (uint16_t)this->scores[game];
+}
+
+uint32_t SnakeBatch::GetSnakeLength(int game) {
+    return this->lengths[game];
+}
+
+SnakeTypes::Direction SnakeBatch::GetSnakeDirection(int game) {
+    return (Direction)this->directions[game];
+}
+
+bool SnakeBatch::IsGameOver(int game) {
+    return this->over[game] != 0;
+}
+
+bool SnakeBatch::IsGameWon(int game) {
+    return this->won[game] != 0;
+}
+
+uint32_t SnakeBatch::GetFreeTileCount(int game) {
+    return this->freeCounts[game];
+}
+
+SnakeTypes::Tile SnakeBatch::GetTile(int game, int x, int y) {
+    return (Tile)this->GetTiles(game)[(uint32_t)y * this->width + x];
+}
+
+const uint8_t* SnakeBatch::GetTiles(int game) {
+    return this->tiles + (size_t)game * this->area;
+}
+
+const uint8_t* SnakeBatch::GetAllTiles() {
+    return this->tiles;
+}
+
+const int32_t* SnakeBatch::GetScores() {
+    return this->scores;
+}
+
+const int32_t* SnakeBatch::GetGameOverFlags() {
+    return this->over;
+}
+
+void SnakeBatch::UseBuffers(uint8_t* newTiles, int32_t* newScores, int32_t* newOver) {
+    size_t gameCount = (size_t)this->count;
+
+    // Copy the state over, then let go of the batch's own storage
+    if (newTiles != nullptr && newTiles != this->tiles) {
+        if (gameCount > 0) std::memcpy(newTiles, this->tiles, gameCount * this->area);
+        this->tiles = newTiles;
+        this->ownTiles.Resize(0);
+    }
+    if (newScores != nullptr && newScores != this->scores) {
+        if (gameCount > 0) std::memcpy(newScores, this->scores, gameCount * sizeof(int32_t));
+        this->scores = newScores;
+        this->ownScores = std::vector<int32_t>();
+    }
+    if (newOver != nullptr && newOver != this->over) {
+        if (gameCount > 0) std::memcpy(newOver, this->over, gameCount * sizeof(int32_t));
+        this->over = newOver;
+        this->ownOver = std::vector<int32_t>();
+    }
+}
+
+SnakeTypes::Position SnakeBatch::GetSnakeHeadPos(int game) {
+    return {(Coord)this->headX[game], (Coord)this->headY[game]};
+}
+
+SnakeTypes::Position SnakeBatch::GetSnakeTailPos(int game) {
+    uint32_t tail = this->snakeCells[(size_t)game * this->area + this->snakeFirst[game]];
+    return {(Coord)(tail % this->width), (Coord)(tail / this->width)};
+}
+
+SnakeTypes::Position SnakeBatch::GetFruitPos(int game) {
+    return {(Coord)(this->fruits[game] % this->width), (Coord)(this->fruits[game] / this->width)};
+}
+
+void SnakeBatch::Seed(int game, uint64_t rngSeed) {
+    this->seeds[game] = rngSeed;
+    this->rngs[game].seed(rngSeed);
+}
+
+uint64_t SnakeBatch::GetSeed(int game) {
+    return this->seeds[game];
+}
+
+size_t SnakeBatch::GetSnapshotSize(int game) {
+    size_t size = snapshotAlign(sizeof(SnapshotHeader));
+    size = snapshotAlign(size + sizeof(GameRng));
+    size = snapshotAlign(size + this->area);
+    size = snapshotAlign(size + this->snakeSizes[game] * sizeof(uint32_t));
+    return size + this->freeCounts[game] * sizeof(uint32_t);
+}
+
+size_t SnakeBatch::SaveSnapshot(int game, uint8_t* buffer) {
+    size_t base = (size_t)game * this->area;
+    Position fruit = this->GetFruitPos(game);
+
+    // Same layout SnakeGame::SaveSnapshot() writes
+    SnapshotHeader header = {};
+    header.magic = SNAPSHOT_MAGIC;
+    header.version = SNAPSHOT_VERSION;
+    header.width = this->width;
+    header.height = this->height;
+    header.score = (uint16_t)this->scores[game];
+    header.snakeLength = this->lengths[game];
+    header.direction = (uint8_t)this->directions[game];
+    header.flags = (this->over[game] ? SNAPSHOT_GAME_OVER : 0) | (this->won[game] ? SNAPSHOT_GAME_WON : 0) | (this->hasFruit[game] ? SNAPSHOT_HAS_FRUIT : 0);
+    header.fruitX = fruit.x;
+    header.fruitY = fruit.y;
+    header.seed = this->seeds[game];
+
+    header.rngOffset = (uint32_t)snapshotAlign(sizeof(SnapshotHeader));
+    header.rngSize = (uint32_t)sizeof(GameRng);
+    header.tilesOffset = (uint32_t)snapshotAlign(header.rngOffset + header.rngSize);
+    header.snakeOffset = (uint32_t)snapshotAlign(header.tilesOffset + this->area);
+    header.snakeCount = this->snakeSizes[game];
+    header.freeOffset = (uint32_t)snapshotAlign(header.snakeOffset + (size_t)header.snakeCount * sizeof(uint32_t));
+    header.freeCount = this->freeCounts[game];
+    header.size = header.freeOffset + header.freeCount * (uint32_t)sizeof(uint32_t);
+
+    // Zero the alignment padding between sections, so equal games give equal snapshots
+    std::memset(buffer, 0, header.tilesOffset);
+    std::memset(buffer + header.snakeOffset - 8, 0, 8);
+    std::memset(buffer + header.freeOffset - 8, 0, 8);
+
+    std::memcpy(buffer, &header, sizeof(header));
+    std::memcpy(buffer + header.rngOffset, &this->rngs[game], sizeof(GameRng));
+    std::memcpy(buffer + header.tilesOffset, this->tiles + base, this->area);
+
+    // Snake buffer from tail to head, wrapping around the end of the game's slice
+    uint8_t* snakeOut = buffer + header.snakeOffset;
+    uint32_t pos = this->snakeFirst[game];
+    for (uint32_t i = 0; i < header.snakeCount; i++) {
+        std::memcpy(snakeOut + i * sizeof(uint32_t), &this->snakeCells[base + pos], sizeof(uint32_t));
+        if (++pos == this->area) pos = 0;
+    }
+
+    if (header.freeCount > 0) {
+        std::memcpy(buffer + header.freeOffset, &this->freeCells[base], header.freeCount * sizeof(uint32_t));
+    }
+
+    return header.size;
+}
+
+SnakeBatch::Kernel SnakeBatch::GetKernel() {
+    return this->kernel;
+}
+
+bool SnakeBatch::SetKernel(Kernel newKernel) {
+    if (!KernelSupported(newKernel)) return false;
+
+    // Gathers take signed 32-bit offsets into the slab
+    if (newKernel == Kernel::AVX2 && (uint64_t)this->count * this->area > (uint64_t)std::numeric_limits<int32_t>::max()) {
+        return false;
+    }
+
+    this->kernel = newKernel;
+    return true;
+}
+
+bool SnakeBatch::KernelSupported(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Scalar: return true;
+#ifdef SNAKE_BATCH_X86
+        case Kernel::SSE41: return __builtin_cpu_supports("sse4.1");
+        case Kernel::AVX2: return __builtin_cpu_supports("avx2");
+#endif // SNAKE_BATCH_X86
+        default: return false;
+    }
+}
+
+const char* SnakeBatch::KernelName(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::SSE41: return "sse4.1";
+        case Kernel::AVX2: return "avx2";
+        default: return "scalar";
+    }
+}
+
+void SnakeBatch::settle(int game) {
+    size_t base = (size_t)game * this->area;
+    uint32_t target = this->targets[game];
+
+    if (this->outcomes[game] == OUTCOME_EAT) {
+        // Score went up in the first pass, no empty tile left for new fruit means the snake is about to fill the grid
+        if (!this->spawnFruit(game)) {
+            this->won[game] = 1;
+            this->over[game] = 1;
+        }
+
+        // Grow snake
+        if (this->lengths[game] < this->area) this->lengths[game]++;
+    }
+
+    // Move snake onto the new head tile
+    this->setTile(game, target, Tile::Snake);
+
+    uint32_t pos = this->snakeFirst[game] + this->snakeSizes[game];
+    if (pos >= this->area) pos -= this->area;
+    this->snakeCells[base + pos] = target;
+    this->snakeSizes[game]++;
+
+    // Remove tail bit when snake moves, if max size was reached
+    if (this->snakeSizes[game] > this->lengths[game]) {
+        this->setTile(game, this->snakeCells[base + this->snakeFirst[game]], Tile::Empty);
+
+        if (++this->snakeFirst[game] == this->area) this->snakeFirst[game] = 0;
+        this->snakeSizes[game]--;
+    }
+}
+
+bool SnakeBatch::spawnFruit(int game) {
+    // Grid is full, nowhere to spawn
+    uint32_t freeTiles = this->freeCounts[game];
+    if (freeTiles == 0) {
+        this->hasFruit[game] = 0;
+        return false;
+    }
+
+    // Pick any empty tile, in the same order SnakeGame would
+    uint32_t cell = this->freeCells[(size_t)game * this->area + randomBelow(this->rngs[game], freeTiles)];
+
+    this->setTile(game, cell, Tile::Fruit);
+    this->fruits[game] = cell;
+    this->hasFruit[game] = 1;
+
+    return true;
+}
+
+void SnakeBatch::setTile(int game, uint32_t cell, Tile newTile) {
+    size_t base = (size_t)game * this->area;
+    uint8_t* grid = this->tiles + base;
+    uint32_t* cells = this->freeCells.data() + base;
+    uint32_t* slots = this->freeSlots.data() + base;
+
+    bool wasEmpty = grid[cell] == (uint8_t)Tile::Empty;
+    grid[cell] = (uint8_t)newTile;
+
+    if (wasEmpty && newTile != Tile::Empty) {
+        // Tile got filled, move last free tile into its slot
+        uint32_t slot = slots[cell];
+        uint32_t last = cells[--this->freeCounts[game]];
+
+        cells[slot] = last;
+        slots[last] = slot;
+        slots[cell] = NOT_FREE;
+    } else if (!wasEmpty && newTile == Tile::Empty) {
+        // Tile got emptied, append it to the free tiles
+        slots[cell] = this->freeCounts[game];
+        cells[this->freeCounts[game]++] = cell;
+    }
+}
@@ -0,0 +1,150 @@
+#ifndef __BATCH_INCLUDED__
+#define __BATCH_INCLUDED__
+
+#include <cstddef> // size_t
+#include <cstdint> // uint8_t, uint16_t, uint32_t, uint64_t, int32_t
+#include <vector> // std::vector<T>
+
+#include "game.h" // SnakeTypes
+#include "grid.h" // AlignedBuffer
+#include "rng.h" // GameRng
+
+// Many independent games of the same size, stepped in lockstep, for running thousands of games at once
+//
+// Every game plays by SnakeGame's rules, and with the same seed a game plays out exactly like a SnakeGame
+// (same fruit spawns, scores and snapshots, see SaveSnapshot()). State is stored as structure of arrays:
+// heads, directions, lengths, scores and game over flags each sit in one contiguous array, and every
+// game's grid, snake buffer and empty tile index is a slice of one slab
+//
+// Step() runs in two passes over all games:
+//   - Turns, head movement with wrap-around, the tile lookup under each new head, deaths and scoring,
+//     several games per instruction with SSE4.1 or AVX2 when the CPU has them (see Kernel)
+//   - Grid writes, snake buffer and empty tile index updates and fruit spawns, one game at a time for the
+//     games that moved
+class SnakeBatch : public SnakeTypes {
+public:
+    // Instruction set the first pass of Step() runs on, every kernel gives the same results
+    enum class Kernel: uint8_t { Scalar = 0, SSE41 = 1, AVX2 = 2 };
+
+    // Create games variable-size rectangles (same limits as SnakeGame), randomly seeded
+    SnakeBatch(int games, int, int);
+    // Same, game i seeded with seed + i, so it plays like SnakeGame(width, height, seed + i)
+    SnakeBatch(int games, int, int, uint64_t);
+
+    // Arrays may live in caller-owned buffers (see UseBuffers()), so batches aren't copied or moved
+    SnakeBatch(const SnakeBatch&) = delete;
+    SnakeBatch& operator=(const SnakeBatch&) = delete;
+
+    // Reset one game's grid and create its starting state, same as SnakeGame::Reset()
+    void Reset(int game);
+    // Reset every game
+    void ResetAll();
+    // Reset every game that's over, returns how many were
+    int ResetFinished();
+    // Turn every game by actions[game] (0 keeps the direction, 1-4 turn like ChangeDirection(), anything else
+    // is ignored), then tick every game, same as ChangeDirection() and Tick() on each game in turn
+    // actions may be nullptr to tick without turning
+    void Step(const uint8_t* actions);
+    // Turn one game's snake (Does nothing if opposite its current direction)
+    void ChangeDirection(int game, Direction);
+
+    // Amount of games
+    int GetGameCount();
+    uint32_t GetGridSizeHorizontal();
+    uint32_t GetGridSizeVertical();
+
+    uint16_t GetScore(int game);
+    uint32_t GetSnakeLength(int game);
+    Direction GetSnakeDirection(int game);
+    bool IsGameOver(int game);
+    bool IsGameWon(int game);
+    uint32_t GetFreeTileCount(int game);
+    Tile GetTile(int game, int x, int y);
+    // One game's width * height tiles, row-major, valid until the batch is destroyed
+    const uint8_t* GetTiles(int game);
+    Position GetSnakeHeadPos(int game);
+    Position GetSnakeTailPos(int game);
+    // Only valid while the game has fruit, which is until its grid fills up
+    Position GetFruitPos(int game);
+
+    // Every game's tiles (game after game, each laid out like GetTiles()), scores, and game over flags (1 if over)
+    const uint8_t* GetAllTiles();
+    const int32_t* GetScores();
+    const int32_t* GetGameOverFlags();
+    // Keep tiles, scores and game over flags in caller-owned buffers from now on, so they can be read after every
+    // Step() without copying: tiles holds games * width * height bytes, scores and over one element per game
+    // The current state is copied in once, the buffers must outlive the batch (or the next UseBuffers() call)
+    // nullptr leaves that array where it is
+    void UseBuffers(uint8_t* tiles, int32_t* scores, int32_t* over);
+
+    // Reseed one game's RNG engine, call Reset() afterwards to replay it from the start
+    void Seed(int game, uint64_t);
+    uint64_t GetSeed(int game);
+
+    // Bytes SaveSnapshot() needs for one game's current state
+    size_t GetSnapshotSize(int game);
+    // Write one game's state to buffer as a SnakeGame snapshot, returns bytes written
+    // Any SnakeGame can restore it, and a SnakeGame in the same state writes the exact same bytes
+    size_t SaveSnapshot(int game, uint8_t* buffer);
+
+    // Kernel Step() currently uses, the best one the CPU supports unless changed
+    Kernel GetKernel();
+    // Use another kernel, returns false (and keeps the current one) if the CPU or the batch size doesn't allow it
+    bool SetKernel(Kernel);
+    // Can this CPU run the kernel
+    static bool KernelSupported(Kernel);
+    static const char* KernelName(Kernel);
+
+private:
+    int count;
+    uint32_t width;
+    uint32_t height;
+    uint32_t area;
+    Kernel kernel;
+
+    // Per-game state, one element per game
+    // Kept 32 bits wide (flags and directions too), so the first pass of Step() loads them straight into lanes
+    std::vector<int32_t> headX;
+    std::vector<int32_t> headY;
+    std::vector<int32_t> directions;
+    int32_t* scores;
+    // 1 once the game is over
+    int32_t* over;
+    std::vector<uint32_t> lengths;
+    std::vector<uint8_t> won;
+    std::vector<uint8_t> hasFruit;
+    std::vector<uint32_t> fruits;
+
+    // Every game's grid, game after game
+    uint8_t* tiles;
+    // Storage for tiles, scores and over, unless the caller gave buffers
+    AlignedBuffer ownTiles;
+    std::vector<int32_t> ownScores;
+    std::vector<int32_t> ownOver;
+    // Every game's snake tile indices, a circular buffer of area elements per game from tail to head
+    std::vector<uint32_t> snakeCells;
+    std::vector<uint32_t> snakeFirst;
+    std::vector<uint32_t> snakeSizes;
+    // Every game's dense array of empty tile indices, and the position of every tile in it (see DenseFreeCells)
+    std::vector<uint32_t> freeCells;
+    std::vector<uint32_t> freeSlots;
+    std::vector<uint32_t> freeCounts;
+
+    std::vector<GameRng> rngs;
+    std::vector<uint64_t> seeds;
+
+    // Written by the first pass of Step(), read by the second: tile each head moved onto, and what happened
+    std::vector<uint32_t> targets;
+    std::vector<int32_t> outcomes;
+    // Actions used when Step() is given none
+    std::vector<uint8_t> noActions;
+
+    // Finish a tick for a game that moved, after the first pass scored it
+    void settle(int game);
+    // Spawn new fruit on a random empty tile of a game, returns false if its grid is full
+    bool spawnFruit(int game);
+    // Set tile of a game, keeping its empty tile index up to date
+    void setTile(int game, uint32_t cell, Tile);
+};
+
+#endif // __BATCH_INCLUDED__
@@ -0,0 +1,119 @@
+#ifndef __COWARRAY_INCLUDED__
+#define __COWARRAY_INCLUDED__
+
+#include <cstddef> // size_t
+#include <memory> // std::shared_ptr<T>, std::make_shared<T>()
+#include <vector> // std::vector<T>
+
+// Array split into fixed-size pages, copies share every page until one of them writes to it
+// Used like a std::vector, copying is only as expensive as copying the page pointers, and writing through
+// a non-const reference first gives the written page to this array alone (if it was shared)
+// Non-const operator[] and back() count as writes, read through a const reference to leave pages shared
+// Elements must be trivially copyable, pages are never freed while the array is in use
+template <typename T, int PageBits = 10>
+class CowArray {
+public:
+    // Elements per page
+    static const size_t PageSize = (size_t)1 << PageBits;
+
+    CowArray() : count(0) {}
+
+    // Amount of elements
+    size_t size() const {
+        return this->count;
+    }
+
+    bool empty() const {
+        return this->count == 0;
+    }
+
+    // Change amount of elements, new elements are value-initialised
+    void resize(size_t n) {
+        this->reservePages(n);
+
+        for (size_t i = this->count; i < n; i++) {
+            this->writable(i >> PageBits).items[i & PageMask] = T();
+        }
+
+        this->count = n;
+    }
+
+    // Replace contents with n copies of value, on fresh pages that aren't shared with anything
+    void assign(size_t n, const T& value) {
+        this->pages.clear();
+        this->count = 0;
+        this->reservePages(n);
+
+        for (size_t i = 0; i < n; i++) {
+            this->pages[i >> PageBits]->items[i & PageMask] = value;
+        }
+
+        this->count = n;
+    }
+
+    // Remove every element, pages are kept
+    void clear() {
+        this->count = 0;
+    }
+
+    // Free pages past the last element
+    void shrink_to_fit() {
+        this->pages.resize((this->count + PageSize - 1) >> PageBits);
+    }
+
+    const T& operator[](size_t i) const {
+        return this->pages[i >> PageBits]->items[i & PageMask];
+    }
+
+    // Makes the element's page private to this array
+    T& operator[](size_t i) {
+        return this->writable(i >> PageBits).items[i & PageMask];
+    }
+
+    const T& back() const {
+        return (*this)[this->count - 1];
+    }
+
+    T& back() {
+        return (*this)[this->count - 1];
+    }
+
+    void push_back(const T& value) {
+        this->reservePages(this->count + 1);
+        (*this)[this->count] = value;
+        this->count++;
+    }
+
+    void pop_back() {
+        this->count--;
+    }
+
+private:
+    static const size_t PageMask = PageSize - 1;
+
+    struct Page {
+        T items[PageSize];
+    };
+
+    // Pages in order, shared with copies of this array
+    std::vector<std::shared_ptr<Page>> pages;
+    // Amount of elements
+    size_t count;
+
+    // Allocate pages until there's room for n elements
+    void reservePages(size_t n) {
+        while (this->pages.size() * PageSize < n) {
+            this->pages.push_back(std::make_shared<Page>());
+        }
+    }
+
+    // Page p, copied first if another array still uses it
+    Page& writable(size_t p) {
+        std::shared_ptr<Page>& page = this->pages[p];
+        if (page.use_count() > 1) page = std::make_shared<Page>(*page);
+
+        return *page;
+    }
+};
+
+#endif // __COWARRAY_INCLUDED__
@@ -0,0 +1,168 @@
+#ifndef __FREECELLS_INCLUDED__
+#define __FREECELLS_INCLUDED__
+
+#include <cstdint> // uint8_t, uint32_t
+#include <cstring> // std::memcpy
+#include <limits> // std::numeric_limits<T>
+#include <vector> // std::vector<T>
+
+/**
+*
+* Empty tile tracking, so fruit can spawn on a uniformly random empty tile without scanning the grid
+*
+* Every grid picks one with its FreeCells typedef, the game tells it about every tile that gets filled or emptied:
+*   DenseFreeCells<Array>: dense array of empty tile indices, and the position of every tile in it, two arrays
+*     the size of the grid. Empty tiles are picked in the array's own order, which snapshots store
+*   GridFreeCells: asks the grid, for grids that count their empty tiles themselves (ChunkedGrid), so nothing
+*     grows with the grid area. Empty tiles are picked in grid order, so snapshots don't have to list them
+*
+* */
+
+// Copy tile indices out to a snapshot, std::vector in one go, paged arrays one element at a time
+inline void copyCellsOut(const std::vector<uint32_t>& cells, uint8_t* out) {
+    if (!cells.empty()) std::memcpy(out, cells.data(), cells.size() * sizeof(uint32_t));
+}
+
+template <typename Array>
+void copyCellsOut(const Array& cells, uint8_t* out) {
+    for (size_t i = 0; i < cells.size(); i++) std::memcpy(out + i * sizeof(uint32_t), &cells[i], sizeof(uint32_t));
+}
+
+// Copy tile indices in from a snapshot, cells must already hold the right amount of elements
+inline void copyCellsIn(std::vector<uint32_t>& cells, const uint8_t* in) {
+    if (!cells.empty()) std::memcpy(cells.data(), in, cells.size() * sizeof(uint32_t));
+}
+
+template <typename Array>
+void copyCellsIn(Array& cells, const uint8_t* in) {
+    for (size_t i = 0; i < cells.size(); i++) std::memcpy(&cells[i], in + i * sizeof(uint32_t), sizeof(uint32_t));
+}
+
+template <typename Array>
+class DenseFreeCells {
+public:
+    // Snapshots list the empty tiles in picking order
+    static const bool Listed = true;
+
+    // Every tile of the grid is empty, index them in order
+    template <typename Grid>
+    void Reset(const Grid& grid) {
+        uint32_t area = (uint32_t)grid.Width() * grid.Height();
+
+        this->cells.resize(area);
+        this->slots.resize(area);
+        for (uint32_t i = 0; i < area; i++) {
+            this->cells[i] = i;
+            this->slots[i] = i;
+        }
+    }
+
+    // Tile got filled, move last free tile into its slot
+    void Filled(uint32_t cell) {
+        // Reads go through const references, so a shared CowArray page is only copied if it gets written
+        const Array& cells = this->cells;
+        const Array& slots = this->slots;
+        uint32_t slot = slots[cell];
+        uint32_t last = cells.back();
+
+        this->cells[slot] = last;
+        this->slots[last] = slot;
+        this->cells.pop_back();
+        this->slots[cell] = NOT_FREE;
+    }
+
+    // Tile got emptied, append it to the free tiles
+    void Emptied(uint32_t cell) {
+        this->slots[cell] = (uint32_t)this->cells.size();
+        this->cells.push_back(cell);
+    }
+
+    template <typename Grid>
+    uint32_t Count(const Grid&) const {
+        return (uint32_t)this->cells.size();
+    }
+
+    // Empty tile number i, in [0, Count())
+    template <typename Grid>
+    uint32_t Pick(const Grid&, uint32_t i) const {
+        return this->cells[i];
+    }
+
+    // Write every empty tile index in picking order, four bytes each
+    void Save(uint8_t* out) const {
+        copyCellsOut(this->cells, out);
+    }
+
+    // Replace the index with count tile indices from a snapshot, returns false unless every listed tile is
+    // within area, empty in tiles, and listed only once (the index is left half-built then, reset it)
+    bool Restore(const uint8_t* in, uint32_t count, const uint8_t* tiles, uint32_t area) {
+        this->cells.resize(count);
+        copyCellsIn(this->cells, in);
+
+        this->slots.assign((size_t)area, NOT_FREE);
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t cell = this->cells[i];
+            if (cell >= area || tiles[cell] != 0 || this->slots[cell] != NOT_FREE) return false;
+
+            this->slots[cell] = i;
+        }
+
+        return true;
+    }
+
+    // Replace the index with the empty tiles in tiles, in grid order (snapshots that don't list them)
+    void Rebuild(const uint8_t* tiles, uint32_t area) {
+        this->cells.resize(0);
+        this->slots.assign((size_t)area, NOT_FREE);
+        for (uint32_t i = 0; i < area; i++) {
+            if (tiles[i] == 0) this->Emptied(i);
+        }
+    }
+
+private:
+    // slots value for tiles that aren't empty
+    static const uint32_t NOT_FREE = std::numeric_limits<uint32_t>::max();
+
+    // Dense array of empty tile indices (y * width + x), in no particular order
+    Array cells;
+    // Position of every tile in cells, or NOT_FREE if the tile isn't empty
+    Array slots;
+};
+
+// Definition for the constant passed by reference
+template <typename Array>
+const uint32_t DenseFreeCells<Array>::NOT_FREE;
+
+class GridFreeCells {
+public:
+    // Grid order is implied, snapshots don't list empty tiles
+    static const bool Listed = false;
+
+    // The grid keeps count as tiles are set, nothing to track here
+    template <typename Grid>
+    void Reset(const Grid&) {}
+
+    void Filled(uint32_t) {}
+
+    void Emptied(uint32_t) {}
+
+    template <typename Grid>
+    uint32_t Count(const Grid& grid) const {
+        return grid.EmptyCount();
+    }
+
+    template <typename Grid>
+    uint32_t Pick(const Grid& grid, uint32_t i) const {
+        return grid.FindEmpty(i);
+    }
+
+    void Save(uint8_t*) const {}
+
+    bool Restore(const uint8_t*, uint32_t, const uint8_t*, uint32_t) {
+        return true;
+    }
+
+    void Rebuild(const uint8_t*, uint32_t) {}
+};
+
+#endif // __FREECELLS_INCLUDED__
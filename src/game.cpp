@@ -1,30 +1,74 @@
 #include <iostream> // std::cerr
+#include <algorithm> // std::sort, std::adjacent_find
 #include <limits> // std::numeric_limits<T>
 #include <vector> // std::vector<T>
+#include <cstring> // std::memcpy
+#include <type_traits> // std::is_trivially_copyable<T>
 
 #include "mylib.h" // Helper functions
 
 #include "game.h" // Class declaration
 
-// Default grid of 31x31
-SnakeGame::SnakeGame() : SnakeGame(31, 31) {}
+// Snapshots store the engine as raw bytes
+static_assert(std::is_trivially_copyable<GameRng>::value, "GameRng must be trivially copyable to be snapshotted");
+
+// Snapshot sections start on 8-byte boundaries
+static size_t snapshotAlign(size_t offset) {
+    return (offset + 7) & ~(size_t)7;
+}
+
+// Are two tile indices one move apart, on a width x height grid that wraps around its edges
+static bool snapshotNeighbours(uint32_t a, uint32_t b, uint32_t width, uint32_t height) {
+    uint32_t ax = a % width;
+    uint32_t ay = a / width;
+    uint32_t bx = b % width;
+    uint32_t by = b / width;
+    uint32_t dx = ax > bx ? ax - bx : bx - ax;
+    uint32_t dy = ay > by ? ay - by : by - ay;
+
+    if (dy == 0) return dx == 1 || (dx != 0 && dx == width - 1);
+    if (dx == 0) return dy == 1 || dy == height - 1;
+    return false;
+}
+
+// Default grid of 31x31, or the size of a fixed grid
+template <typename Grid>
+BasicSnakeGame<Grid>::BasicSnakeGame() : BasicSnakeGame(Grid::DefaultWidth, Grid::DefaultHeight) {}
 
 // Square grid
-// Max 255
-SnakeGame::SnakeGame(int size) : SnakeGame(size, size) {}
+template <typename Grid>
+BasicSnakeGame<Grid>::BasicSnakeGame(int size) : BasicSnakeGame(size, size) {}
+
+// Rectangle grid, randomly seeded
+template <typename Grid>
+BasicSnakeGame<Grid>::BasicSnakeGame(int x, int y) : BasicSnakeGame(x, y, getRandomSeed()) {}
+
+// Rectangle grid, fixed seed
+// Fixed grids ignore the requested size
+template <typename Grid>
+BasicSnakeGame<Grid>::BasicSnakeGame(int x, int y, uint64_t rngSeed) {
+    ClampGridSize(x, y);
 
-// Rectangle grid
-// Max 255, 255
-SnakeGame::SnakeGame(int x, int y) {
-    // Set grid sizes
-    this->MapGridSizeHorizontal = x;
-    this->MapGridSizeVertical = y;
+    // Allocate grid, and take sizes from it in case it has a fixed size
+    this->map.Resize(x, y);
+    this->MapGridSizeHorizontal = this->map.Width();
+    this->MapGridSizeVertical = this->map.Height();
+
+#ifdef _WIN32
+    this->trackChanges = true;
+#else // _WIN32
+    this->trackChanges = false;
+#endif // _WIN32
+
+    // Seed before Reset(), so the first fruit is reproducible too
+    this->Seed(rngSeed);
 
     // Create starting grid
     Reset();
 }
 
-void SnakeGame::Reset() {
+template <typename Grid>
+void BasicSnakeGame<Grid>::Reset() {
     /**
     *
     * Initialise game field map
@@ -34,67 +78,84 @@ void SnakeGame::Reset() {
     *   1: Spawn
     *
     * */
-    // Resize vertical vector
-    map.resize(this->MapGridSizeVertical);
-    for (uint8_t i = 0; i < (uint8_t)MapGridSizeVertical; i++) {
-        // Resize horizontal vectors
-        map[i].resize(this->MapGridSizeHorizontal);
-        for (uint8_t j = 0; j < (uint8_t)MapGridSizeHorizontal; j++) {
-            // Blank every tile at beginning
-            this->map[i][j] = (uint8_t)SnakeGame::Tile::Empty;
-
-#ifdef _WIN32
-            // Mark every tile as changed initially
-            this->ChangedTiles.push_back({j, i});
-#endif // _WIN32
+    // Blank every tile at beginning
+    this->map.Clear();
+
+    // Mark every tile as changed initially
+    if (this->trackChanges) {
+        this->ChangedTiles.clear();
+        this->ChangedTiles.reserve(MaxChangedTilesPerTick);
+        for (int i = 0; i < MapGridSizeVertical; i++) {
+            for (int j = 0; j < MapGridSizeHorizontal; j++) {
+                this->ChangedTiles.push_back({(Coord)j, (Coord)i});
+            }
         }
     }
 
+    // Every tile starts empty
+    this->freeCells.Reset(this->map);
+    this->hash = 0;
+
     // Create snake head at centre tile
-    this->map[MapGridSizeVertical / 2][MapGridSizeHorizontal / 2] = (uint8_t)SnakeGame::Tile::Snake;
+    this->setTile(MapGridSizeHorizontal / 2, MapGridSizeVertical / 2, Tile::Snake);
 
     // Reset basic vars
     this->score = 0;
     this->gameOver = false;
-
-    // Reinitialise empty vector with snake part at the centre
-    this->snake.clear();
-    this->snake.resize(0);
-    this->snake.push_back({
-        static_cast<uint8_t>(MapGridSizeHorizontal / 2),
-        static_cast<uint8_t>(MapGridSizeVertical / 2)
+    this->gameWon = false;
+
+    // Empty the snake buffer, and place the first snake part at the centre
+    // The snake can never be longer than the grid area, so the buffer never has to grow past that
+    // Lazy grids only allocate what the snake needs, everything else gets the whole area up front
+    this->snake.Reset((size_t)MapGridSizeHorizontal * MapGridSizeVertical, !Grid::Lazy);
+    this->snake.PushBack({
+        static_cast<Coord>(MapGridSizeHorizontal / 2),
+        static_cast<Coord>(MapGridSizeVertical / 2)
     });
 
+    // No tick has run yet
+    this->events = TickEvents();
+
     // Set starting snake length
     this->snakeLength = 4;
-    this->snakeDirection = SnakeGame::Direction::None;
+    this->snakeDirection = Direction::None;
+    this->headKey = ZobristKeys::Head((uint32_t)(MapGridSizeVertical / 2) * this->map.Width() + MapGridSizeHorizontal / 2);
+    this->hash ^= this->headKey ^ ZobristKeys::Direction((uint8_t)Direction::None) ^ ZobristKeys::Length(4);
 
-    // Spawn first fruit
-    this->spawnFruit();
+    // Spawn first fruit, a 1x1 grid is already full
+    if (!this->spawnFruit()) {
+        this->gameWon = true;
+        this->gameOver = true;
+    }
 }
 
-void SnakeGame::Tick() {
+template <typename Grid>
+void BasicSnakeGame<Grid>::Tick() {
+    // Nothing happened yet this tick
+    this->events.flags = 0;
+    this->events.cause = GameOverCause::None;
+
     // Quit ticking if game over state reached
     if (this->gameOver) return;
 
-#ifdef _WIN32
-    // Clear vector between frames
+    // Clear vector between ticks, keeping its memory
     this->ChangedTiles.clear();
-    this->ChangedTiles.resize(0);
-#endif // _WIN32
 
     this->move();
 }
 
-uint16_t SnakeGame::GetScore() {
+template <typename Grid>
+uint16_t BasicSnakeGame<Grid>::GetScore() {
     return this->score;
 }
 
-void SnakeGame::SetScore(uint16_t newScore) {
+template <typename Grid>
+void BasicSnakeGame<Grid>::SetScore(uint16_t newScore) {
     this->score = newScore;
 }
 
-void SnakeGame::ModifyScore(int amount) {
+template <typename Grid>
+void BasicSnakeGame<Grid>::ModifyScore(int amount) {
     // Use temporary variable to verify score won't over- or underflow
     int temp = static_cast<int>(this->score);
     temp += amount;
@@ -110,162 +171,495 @@ void SnakeGame::ModifyScore(int amount) {
     this->score = static_cast<uint16_t>(temp);
 }
 
-void SnakeGame::ChangeDirection(Direction newDir) {
+template <typename Grid>
+uint32_t BasicSnakeGame<Grid>::GetSnakeLength() {
+    return this->snakeLength;
+}
+
+template <typename Grid>
+void BasicSnakeGame<Grid>::SetSnakeLength(uint32_t length) {
+    // Snake can't be longer than the grid, or shorter than its head
+    if (length > this->snake.Capacity()) length = (uint32_t)this->snake.Capacity();
+    if (length < 1) length = 1;
+
+    this->setSnakeLength(length);
+
+    // Shrinking drops the extra tail parts right away, moving couldn't shed more than one per tick
+    while (this->snake.Size() > this->snakeLength) {
+        if (this->trackChanges) this->ChangedTiles.push_back(this->snake.Front());
+        this->setTile(this->snake.Front().x, this->snake.Front().y, Tile::Empty);
+        this->snake.PopFront();
+    }
+}
+
+template <typename Grid>
+void BasicSnakeGame<Grid>::ChangeDirection(Direction newDir) {
     // If new direciton would be opposite current direction, do nothing
-    if (newDir == SnakeGame::Direction::Left && this->snakeDirection == SnakeGame::Direction::Right) return;
-    if (newDir == SnakeGame::Direction::Right && this->snakeDirection == SnakeGame::Direction::Left) return;
-    if (newDir == SnakeGame::Direction::Up && this->snakeDirection == SnakeGame::Direction::Down) return;
-    if (newDir == SnakeGame::Direction::Down && this->snakeDirection == SnakeGame::Direction::Up) return;
+    if (newDir == Direction::Left && this->snakeDirection == Direction::Right) return;
+    if (newDir == Direction::Right && this->snakeDirection == Direction::Left) return;
+    if (newDir == Direction::Up && this->snakeDirection == Direction::Down) return;
+    if (newDir == Direction::Down && this->snakeDirection == Direction::Up) return;
 
+    if (newDir == this->snakeDirection) return;
+
+    this->hash ^= ZobristKeys::Direction((uint8_t)this->snakeDirection) ^ ZobristKeys::Direction((uint8_t)newDir);
     this->snakeDirection = newDir;
 }
 
-bool SnakeGame::IsGameOver() {
+template <typename Grid>
+bool BasicSnakeGame<Grid>::IsGameOver() {
     return this->gameOver;
 }
 
-uint16_t SnakeGame::GetGridSizeVertical() {
-    return (uint16_t)this->MapGridSizeVertical;
+template <typename Grid>
+bool BasicSnakeGame<Grid>::IsGameWon() {
+    return this->gameWon;
+}
+
+template <typename Grid>
+uint32_t BasicSnakeGame<Grid>::GetFreeTileCount() {
+    return this->freeCells.Count(this->map);
+}
+
+template <typename Grid>
+uint32_t BasicSnakeGame<Grid>::GetGridSizeVertical() {
+    return (uint32_t)this->MapGridSizeVertical;
 }
 
-uint16_t SnakeGame::GetGridSizeHorizontal() {
-    return (uint16_t)this->MapGridSizeHorizontal;
+template <typename Grid>
+uint32_t BasicSnakeGame<Grid>::GetGridSizeHorizontal() {
+    return (uint32_t)this->MapGridSizeHorizontal;
 }
 
-SnakeGame::Tile SnakeGame::GetTile(int x, int y) {
-    return (SnakeGame::Tile)this->map[y][x];
+template <typename Grid>
+SnakeTypes::Tile BasicSnakeGame<Grid>::GetTile(int x, int y) {
+    return (Tile)this->map.Get((uint32_t)y * this->map.Width() + x);
 }
 
-SnakeGame::Direction SnakeGame::GetSnakeDirection() {
-    return (SnakeGame::Direction)this->snakeDirection;
+template <typename Grid>
+SnakeTypes::Direction BasicSnakeGame<Grid>::GetSnakeDirection() {
+    return (Direction)this->snakeDirection;
 }
 
-SnakeGame::Position SnakeGame::GetSnakeHeadPos() {
+template <typename Grid>
+SnakeTypes::Position BasicSnakeGame<Grid>::GetSnakeHeadPos() {
     // Make sure to return copy instead of reference
-    return {this->snake.back().x, this->snake.back().y};
+    return {this->snake.Back().x, this->snake.Back().y};
+}
+
+template <typename Grid>
+SnakeTypes::Position BasicSnakeGame<Grid>::GetSnakeTailPos() {
+    return {this->snake.Front().x, this->snake.Front().y};
+}
+
+template <typename Grid>
+SnakeTypes::Position BasicSnakeGame<Grid>::GetFruitPos() {
+    return this->fruit;
+}
+
+template <typename Grid>
+bool BasicSnakeGame<Grid>::RespawnFruit() {
+    // Draw the new position before freeing the old one, so fruit always moves
+    Position oldFruit = this->fruit;
+    bool hadFruit = this->hasFruit;
+
+    if (!this->spawnFruit()) {
+        // No empty tile to move to, old fruit stays where it is
+        this->hasFruit = hadFruit;
+        return false;
+    }
+
+    if (hadFruit) {
+        this->setTile(oldFruit.x, oldFruit.y, Tile::Empty);
+        if (this->trackChanges) this->ChangedTiles.push_back(oldFruit);
+    }
+
+    return true;
+}
+
+template <typename Grid>
+void BasicSnakeGame<Grid>::Seed(uint64_t rngSeed) {
+    this->seed = rngSeed;
+    this->rng.seed(rngSeed);
+}
+
+template <typename Grid>
+uint64_t BasicSnakeGame<Grid>::GetSeed() {
+    return this->seed;
+}
+
+template <typename Grid>
+void BasicSnakeGame<Grid>::SetRng(const GameRng& engine) {
+    this->rng = engine;
 }
 
-void SnakeGame::move() {
-    if (this->snakeDirection == SnakeGame::Direction::None) return;
+template <typename Grid>
+size_t BasicSnakeGame<Grid>::GetSnapshotSize() {
+    size_t area = (size_t)this->map.Width() * this->map.Height();
+
+    size_t size = snapshotAlign(sizeof(SnapshotHeader));
+    size = snapshotAlign(size + sizeof(GameRng));
+    size = snapshotAlign(size + area);
+    size = snapshotAlign(size + this->snake.Size() * sizeof(uint32_t));
+    return size + (Grid::FreeCells::Listed ? this->GetFreeTileCount() * sizeof(uint32_t) : 0);
+}
+
+template <typename Grid>
+size_t BasicSnakeGame<Grid>::SaveSnapshot(uint8_t* buffer) {
+    size_t area = (size_t)this->map.Width() * this->map.Height();
+
+    SnapshotHeader header = {};
+    header.magic = SNAPSHOT_MAGIC;
+    header.version = SNAPSHOT_VERSION;
+    header.width = (uint32_t)this->map.Width();
+    header.height = (uint32_t)this->map.Height();
+    header.score = this->score;
+    header.snakeLength = this->snakeLength;
+    header.direction = (uint8_t)this->snakeDirection;
+    header.flags = (this->gameOver ? SNAPSHOT_GAME_OVER : 0) | (this->gameWon ? SNAPSHOT_GAME_WON : 0) | (this->hasFruit ? SNAPSHOT_HAS_FRUIT : 0)
+    | (Grid::FreeCells::Listed ? 0 : SNAPSHOT_FREE_UNLISTED);
+    header.fruitX = this->fruit.x;
+    header.fruitY = this->fruit.y;
+    header.seed = this->seed;
+
+    header.rngOffset = (uint32_t)snapshotAlign(sizeof(SnapshotHeader));
+    header.rngSize = (uint32_t)sizeof(GameRng);
+    header.tilesOffset = (uint32_t)snapshotAlign(header.rngOffset + header.rngSize);
+    header.snakeOffset = (uint32_t)snapshotAlign(header.tilesOffset + area);
+    header.snakeCount = (uint32_t)this->snake.Size();
+    header.freeOffset = (uint32_t)snapshotAlign(header.snakeOffset + (size_t)header.snakeCount * sizeof(uint32_t));
+    header.freeCount = Grid::FreeCells::Listed ? this->GetFreeTileCount() : 0;
+    header.size = header.freeOffset + header.freeCount * (uint32_t)sizeof(uint32_t);
+
+    // Zero the alignment padding between sections, so equal games give equal snapshots
+    std::memset(buffer, 0, header.tilesOffset);
+    std::memset(buffer + header.snakeOffset - 8, 0, 8);
+    std::memset(buffer + header.freeOffset - 8, 0, 8);
+
+    std::memcpy(buffer, &header, sizeof(header));
+    std::memcpy(buffer + header.rngOffset, &this->rng, sizeof(GameRng));
+    this->map.CopyTo(buffer + header.tilesOffset);
+
+    uint8_t* snakeOut = buffer + header.snakeOffset;
+    for (uint32_t i = 0; i < header.snakeCount; i++) {
+        uint32_t cell = (uint32_t)this->snake[i].y * header.width + this->snake[i].x;
+        std::memcpy(snakeOut + i * sizeof(uint32_t), &cell, sizeof(uint32_t));
+    }
+
+    this->freeCells.Save(buffer + header.freeOffset);
+
+    return header.size;
+}
+
+template <typename Grid>
+std::vector<uint8_t> BasicSnakeGame<Grid>::SaveSnapshot() {
+    std::vector<uint8_t> buffer = std::vector<uint8_t>(this->GetSnapshotSize());
+    this->SaveSnapshot(buffer.data());
+    return buffer;
+}
+
+template <typename Grid>
+bool BasicSnakeGame<Grid>::RestoreSnapshot(const uint8_t* buffer, size_t size) {
+    // Buffer may not be aligned (e.g. inside a file), so the header is copied out
+    SnapshotHeader header;
+    if (size < sizeof(header)) return false;
+    std::memcpy(&header, buffer, sizeof(header));
+
+    if (header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION || header.size > size) return false;
+    if (header.width < 1 || header.width > MaxGridSize || header.height < 1 || header.height > MaxGridSize) return false;
+    if ((uint64_t)header.width * header.height > std::numeric_limits<uint32_t>::max()) return false;
+    if (header.width > (uint32_t)std::numeric_limits<int>::max() || header.height > (uint32_t)std::numeric_limits<int>::max()) return false;
+    if (header.rngSize != sizeof(GameRng)) return false;
+
+    // Every section has to fit inside the snapshot
+    uint64_t area = (uint64_t)header.width * header.height;
+    if ((uint64_t)header.rngOffset + header.rngSize > header.size) return false;
+    if ((uint64_t)header.tilesOffset + area > header.size) return false;
+    if ((uint64_t)header.snakeOffset + (uint64_t)header.snakeCount * sizeof(uint32_t) > header.size) return false;
+    if ((uint64_t)header.freeOffset + (uint64_t)header.freeCount * sizeof(uint32_t) > header.size) return false;
+    if (header.snakeCount > area || header.freeCount > area || header.snakeLength < 1 || header.snakeLength > area) return false;
+    // There's always a head, and the body never outgrows the length (SetSnakeLength() trims it right away)
+    if (header.snakeCount < 1 || header.snakeCount > header.snakeLength) return false;
+    if (header.direction > (uint8_t)Direction::Right) return false;
+
+    const uint8_t* tiles = buffer + header.tilesOffset;
+    const uint8_t* snakeIn = buffer + header.snakeOffset;
+
+    // Every tile must be a valid Tile, and there must be exactly as many empty ones as listed free tiles, and
+    // as many snake ones as listed snake parts
+    uint32_t emptyTiles = 0;
+    uint32_t snakeTiles = 0;
+    uint8_t highestTile = 0;
+    for (uint64_t i = 0; i < area; i++) {
+        emptyTiles += tiles[i] == (uint8_t)Tile::Empty;
+        snakeTiles += tiles[i] == (uint8_t)Tile::Snake;
+        highestTile = tiles[i] > highestTile ? tiles[i] : highestTile;
+    }
+    if (snakeTiles != header.snakeCount) return false;
+    if (highestTile > (uint8_t)Tile::Fruit) return false;
+    bool listed = (header.flags & SNAPSHOT_FREE_UNLISTED) == 0;
+    if (listed ? emptyTiles != header.freeCount : header.freeCount != 0) return false;
+
+    // Every snake part is on a snake tile, one step (around the edges too) from the part before it, and no tile is
+    // listed twice, or a snake tile would go unlisted and never be freed while a listed one got freed twice
+    std::vector<uint32_t> snakeCells = std::vector<uint32_t>(header.snakeCount);
+    for (uint32_t i = 0; i < header.snakeCount; i++) {
+        uint32_t cell;
+        std::memcpy(&cell, snakeIn + i * sizeof(uint32_t), sizeof(uint32_t));
+        if (cell >= area || tiles[cell] != (uint8_t)Tile::Snake) return false;
+        if (i > 0 && !snapshotNeighbours(snakeCells[i - 1], cell, header.width, header.height)) return false;
+        snakeCells[i] = cell;
+    }
+    std::sort(snakeCells.begin(), snakeCells.end());
+    if (std::adjacent_find(snakeCells.begin(), snakeCells.end()) != snakeCells.end()) return false;
+
+    // The one fruit tile is where the header says, or there's none
+    bool hasFruit = (header.flags & SNAPSHOT_HAS_FRUIT) != 0;
+    if (hasFruit && (header.fruitX >= header.width || header.fruitY >= header.height)) return false;
+    if (hasFruit && tiles[(uint64_t)header.fruitY * header.width + header.fruitX] != (uint8_t)Tile::Fruit) return false;
+    if (area - emptyTiles - snakeTiles != (hasFruit ? 1u : 0u)) return false;
+
+    // Fixed-size grids ignore the resize, and can only take snapshots of their own size
+    if ((uint32_t)this->map.Width() != header.width || (uint32_t)this->map.Height() != header.height) {
+        this->map.Resize(header.width, header.height);
+        if ((uint32_t)this->map.Width() != header.width || (uint32_t)this->map.Height() != header.height) return false;
+    }
+
+    this->MapGridSizeHorizontal = header.width;
+    this->MapGridSizeVertical = header.height;
+    this->map.CopyFrom(tiles);
+
+    // Each listed tile has to be empty, and listed only once, or setTile() would index out of bounds later
+    // Checked while building the index, the game is reset if the list turns out to be invalid
+    // Snapshots that don't list them (from games that pick empty tiles in grid order) get them in grid order
+    if (listed) {
+        if (!this->freeCells.Restore(buffer + header.freeOffset, header.freeCount, tiles, (uint32_t)area)) {
+            this->Reset();
+            return false;
+        }
+    } else {
+        this->freeCells.Rebuild(tiles, (uint32_t)area);
+    }
+
+    this->snake.Reset((size_t)area, !Grid::Lazy);
+    for (uint32_t i = 0; i < header.snakeCount; i++) {
+        uint32_t cell;
+        std::memcpy(&cell, snakeIn + i * sizeof(uint32_t), sizeof(uint32_t));
+        this->snake.PushBack({(Coord)(cell % header.width), (Coord)(cell / header.width)});
+    }
+
+    std::memcpy(&this->rng, buffer + header.rngOffset, sizeof(GameRng));
+    this->seed = header.seed;
+    this->score = header.score;
+    this->snakeLength = header.snakeLength;
+    this->snakeDirection = (Direction)header.direction;
+    this->gameOver = (header.flags & SNAPSHOT_GAME_OVER) != 0;
+    this->gameWon = (header.flags & SNAPSHOT_GAME_WON) != 0;
+    this->hasFruit = hasFruit;
+    this->fruit = {(Coord)header.fruitX, (Coord)header.fruitY};
+    this->headKey = ZobristKeys::Head((uint32_t)this->snake.Back().y * this->map.Width() + this->snake.Back().x);
+    this->hash = this->computeHash();
+    this->events = TickEvents();
+
+    // Whole grid may have changed
+    this->ChangedTiles.clear();
+    if (this->trackChanges) {
+        for (int i = 0; i < MapGridSizeVertical; i++) {
+            for (int j = 0; j < MapGridSizeHorizontal; j++) {
+                this->ChangedTiles.push_back({(Coord)j, (Coord)i});
+            }
+        }
+    }
+
+    return true;
+}
+
+template <typename Grid>
+BasicSnakeGame<Grid> BasicSnakeGame<Grid>::Fork() {
+    // Copying is the fork, grids decide how much of the state copies share
+    return *this;
+}
+
+template <typename Grid>
+uint64_t BasicSnakeGame<Grid>::GetHash() {
+    return this->hash;
+}
+
+template <typename Grid>
+const SnakeTypes::TickEvents& BasicSnakeGame<Grid>::GetTickEvents() {
+    return this->events;
+}
+
+template <typename Grid>
+void BasicSnakeGame<Grid>::TrackChangedTiles(bool track) {
+    this->trackChanges = track;
+    if (!track) this->ChangedTiles.clear();
+    else this->ChangedTiles.reserve(MaxChangedTilesPerTick);
+}
+
+template <typename Grid>
+void BasicSnakeGame<Grid>::move() {
+    if (this->snakeDirection == Direction::None) return;
 
     // Simple safety check
-    if (this->snake.size() <= 0) {
-        std::cerr << "Something went wrong with snake vector" << std::endl;
+    if (this->snake.Empty()) {
+        std::cerr << "Something went wrong with snake buffer" << std::endl;
         return;
     }
 
-    SnakeGame::Position newPos = {this->snake.back().x, this->snake.back().y};
+    Position newPos = {this->snake.Back().x, this->snake.Back().y};
 
     // Directional movement
-    if (this->snakeDirection == SnakeGame::Direction::Left) {
+    if (this->snakeDirection == Direction::Left) {
         // Loop through walls on hit
-        if (newPos.x == 0) newPos.x = MapGridSizeHorizontal - 1;
+        if (newPos.x == 0) newPos.x = this->map.Width() - 1;
         else newPos.x--;
     }
-    if (this->snakeDirection == SnakeGame::Direction::Up) {
+    if (this->snakeDirection == Direction::Up) {
         // Loop through walls on hit
-        if (newPos.y == 0) newPos.y = MapGridSizeVertical - 1;
+        if (newPos.y == 0) newPos.y = this->map.Height() - 1;
         else newPos.y--;
     }
-    if (this->snakeDirection == SnakeGame::Direction::Right) {
+    if (this->snakeDirection == Direction::Right) {
         // Loop through walls on hit
-        if (newPos.x >= MapGridSizeHorizontal - 1) newPos.x = 0;
+        if (newPos.x >= (Coord)(this->map.Width() - 1)) newPos.x = 0;
         else newPos.x++;
     }
-    if (this->snakeDirection == SnakeGame::Direction::Down) {
+    if (this->snakeDirection == Direction::Down) {
         // Loop through walls on hit
-        if (newPos.y >= MapGridSizeVertical - 1) newPos.y = 0;
+        if (newPos.y >= (Coord)(this->map.Height() - 1)) newPos.y = 0;
         else newPos.y++;
     }
     // END Directional movement
 
-#ifdef _WIN32
-    // Mark new head, old head, and old tail tiles as changed
-    this->ChangedTiles.push_back({newPos.x, newPos.y});
-    this->ChangedTiles.push_back({this->snake[0].x, this->snake[0].y});
+    // Tile the snake is moving onto
+    uint8_t tile = this->map.Get((uint32_t)newPos.y * this->map.Width() + newPos.x);
+    this->events.headFrom = {this->snake.Back().x, this->snake.Back().y};
+    this->events.headTo = newPos;
 
-    // Mark old head position to redraw as snake body
-    if (this->snake.size() > 1) this->ChangedTiles.push_back({this->snake.back().x, this->snake.back().y});
-#endif // _WIN32
+    if (this->trackChanges) {
+        // Mark new head, old head, and old tail tiles as changed
+        this->ChangedTiles.push_back({newPos.x, newPos.y});
+        this->ChangedTiles.push_back({this->snake.Front().x, this->snake.Front().y});
 
-    if (this->map[newPos.y][newPos.x] == (uint8_t)SnakeGame::Tile::Fruit) {
+        // Mark old head position to redraw as snake body
+        if (this->snake.Size() > 1) this->ChangedTiles.push_back({this->snake.Back().x, this->snake.Back().y});
+    }
+
+    if (tile == (uint8_t)Tile::Fruit) {
         // Increment score by 1 and spawn new fruit
         this->ModifyScore(1);
-        this->spawnFruit();
+        this->events.flags |= TICK_MOVED | TICK_ATE;
+
+        // No empty tile left for new fruit, the snake is about to fill the whole grid
+        if (this->spawnFruit()) {
+            this->events.fruitSpawned = this->fruit;
+            this->events.flags |= TICK_FRUIT_SPAWNED;
+        } else {
+            this->gameWon = true;
+            this->gameOver = true;
+            this->events.flags |= TICK_GAME_OVER;
+            this->events.cause = GameOverCause::FilledGrid;
+        }
 
         // Grow snake
-        this->snakeLength++;
+        if (this->snakeLength < this->snake.Capacity()) this->setSnakeLength(this->snakeLength + 1);
 
         // Move snake after score increment and new fruit spawn
-        this->map[newPos.y][newPos.x] = (uint8_t)SnakeGame::Tile::Snake;
-        this->snake.push_back({newPos.x, newPos.y});
-    } else if (this->map[newPos.y][newPos.x] == (uint8_t)SnakeGame::Tile::Snake) {
+        this->pushHead(newPos);
+    } else if (tile == (uint8_t)Tile::Snake) {
         // Snake hit itself, end game
         this->gameOver = true;
-    } else if (this->map[newPos.y][newPos.x] == (uint8_t)SnakeGame::Tile::Empty) {
+        this->events.flags |= TICK_GAME_OVER;
+        this->events.cause = GameOverCause::HitSelf;
+    } else if (tile == (uint8_t)Tile::Empty) {
         // Move snake normally
-        this->map[newPos.y][newPos.x] = (uint8_t)SnakeGame::Tile::Snake;
-        this->snake.push_back({newPos.x, newPos.y});
+        this->pushHead(newPos);
+        this->events.flags |= TICK_MOVED;
     }
 
     // Remove tail bit when snake moves, if max size was reached
-    if (this->snake.size() > this->snakeLength) {
-        this->map[this->snake[0].y][this->snake[0].x] = (uint8_t)SnakeGame::Tile::Empty;
-        this->snake.erase(this->snake.begin());
+    if (this->snake.Size() > this->snakeLength) {
+        this->events.tailFreed = {this->snake.Front().x, this->snake.Front().y};
+        this->events.flags |= TICK_TAIL_FREED;
+        this->setTile(this->snake.Front().x, this->snake.Front().y, Tile::Empty);
+        this->snake.PopFront();
     }
 }
 
-void SnakeGame::spawnFruit() {
-    // How many random numbers to get every iteration
-    int spawnedPotentials = 8;
-
-    // Clamp random number count to map size, in case map size is lower than 8
-    if (spawnedPotentials > MapGridSizeHorizontal - 1) {
-        spawnedPotentials = MapGridSizeHorizontal - 1;
-    }
-    if (spawnedPotentials > MapGridSizeVertical - 1) {
-        spawnedPotentials = MapGridSizeVertical - 1;
+template <typename Grid>
+bool BasicSnakeGame<Grid>::spawnFruit() {
+    // Grid is full, nowhere to spawn
+    uint32_t freeTiles = this->freeCells.Count(this->map);
+    if (freeTiles == 0) {
+        this->hasFruit = false;
+        return false;
     }
 
-    // Has a suitable location been found?
-    bool found = false;
+    // Pick any empty tile, every one of them is equally likely
+    uint32_t cell = this->freeCells.Pick(this->map, randomBelow(this->rng, freeTiles));
 
-    // Temporary variables used to find where to spawn fruit
-    int coordX = 0;
-    int coordY = 0;
+    Coord coordX = (Coord)(cell % this->map.Width());
+    Coord coordY = (Coord)(cell / this->map.Width());
 
-    // Variables used to generate random numbers to iterate over
-    std::vector<int> potentialCoordsX;
-    std::vector<int> potentialCoordsY;
+    // Set found tile to fruit
+    this->setTile(coordX, coordY, Tile::Fruit);
+    this->fruit = {coordX, coordY};
+    this->hasFruit = true;
 
-    // Loop until suitable location found
-    while (!found) {
-        potentialCoordsX = getUniqueRandomNumbers(spawnedPotentials, 0, MapGridSizeHorizontal - 1);
-        potentialCoordsY = getUniqueRandomNumbers(spawnedPotentials, 0, MapGridSizeVertical - 1);
+    // Mark tile as changed
+    if (this->trackChanges) this->ChangedTiles.push_back({coordX, coordY});
 
-        for (int i = 0; i < spawnedPotentials; i++) {
-            coordX = potentialCoordsX[i];
-            coordY = potentialCoordsY[i];
+    return true;
+}
 
-            if (map[coordY][coordX] == (uint8_t)SnakeGame::Tile::Empty) {
-                // Suitable spawn point found, return to program
-                found = true;
-                break;
-            }
-        }
+template <typename Grid>
+void BasicSnakeGame<Grid>::setTile(Coord x, Coord y, Tile newTile) {
+    uint32_t cell = (uint32_t)y * this->map.Width() + x;
+    uint8_t oldTile = this->map.Get(cell);
+    bool wasEmpty = oldTile == (uint8_t)Tile::Empty;
 
-        // Empty arrays in case function needs to be run again
-        potentialCoordsX.clear();
-        potentialCoordsX.resize(0);
-        potentialCoordsY.clear();
-        potentialCoordsY.resize(0);
+    this->map.Set(cell, (uint8_t)newTile);
+    this->hash ^= ZobristKeys::Tile(cell, oldTile) ^ ZobristKeys::Tile(cell, (uint8_t)newTile);
+
+    if (wasEmpty && newTile != Tile::Empty) {
+        this->freeCells.Filled(cell);
+    } else if (!wasEmpty && newTile == Tile::Empty) {
+        this->freeCells.Emptied(cell);
     }
+}
 
-    // Set found tile to fruit
-    map[coordY][coordX] = (uint8_t)SnakeGame::Tile::Fruit;
+template <typename Grid>
+void BasicSnakeGame<Grid>::pushHead(Position pos) {
+    this->setTile(pos.x, pos.y, Tile::Snake);
+    this->snake.PushBack(pos);
 
-#ifdef _WIN32
-    // Mark tile as changed
-    this->ChangedTiles.push_back({static_cast<uint8_t>(coordX), static_cast<uint8_t>(coordY)});
-#endif // _WIN32
+    // Old head's key is kept, so moving only hashes the new one
+    uint64_t newHeadKey = ZobristKeys::Head((uint32_t)pos.y * this->map.Width() + pos.x);
+    this->hash ^= this->headKey ^ newHeadKey;
+    this->headKey = newHeadKey;
 }
+
+template <typename Grid>
+void BasicSnakeGame<Grid>::setSnakeLength(uint32_t length) {
+    this->hash ^= ZobristKeys::Length(this->snakeLength) ^ ZobristKeys::Length(length);
+    this->snakeLength = length;
+}
+
+template <typename Grid>
+uint64_t BasicSnakeGame<Grid>::computeHash() {
+    uint64_t result = ZobristKeys::Direction((uint8_t)this->snakeDirection) ^ ZobristKeys::Length(this->snakeLength) ^ this->headKey;
+
+    // Empty tiles hash to nothing
+    uint32_t area = (uint32_t)this->map.Width() * this->map.Height();
+    for (uint32_t cell = 0; cell < area; cell++) result ^= ZobristKeys::Tile(cell, this->map.Get(cell));
+
+    return result;
+}
+
+// Grid variants compiled into the game, add a FixedSnakeGame size here before using it
+template class BasicSnakeGame<FlatGrid>;
+template class BasicSnakeGame<PackedGrid>;
+template class BasicSnakeGame<FixedGrid<31, 15>>;
+template class BasicSnakeGame<CowGrid>;
+template class BasicSnakeGame<ChunkedGrid>;
@@ -2,31 +2,152 @@
 #define __GAME_INCLUDED__
 
 #include <vector>
-#include <cstdint> // unit8_t, uint16_t
+#include <cstdint> // unit8_t, uint16_t, uint32_t
+#include <limits> // std::numeric_limits<T>
+
+#include "grid.h" // FlatGrid, FixedGrid<W, H>, PackedGrid, CowGrid, ChunkedGrid
+#include "ringbuffer.h" // RingBuffer<T>
+#include "rng.h" // GameRng
+#include "zobrist.h" // ZobristKeys
+
+// Bits per coordinate, build with -DSNAKE_COORD_BITS=8 for the most compact positions (grids up to 255x255),
+// or 32 for grids wider or taller than 65535 tiles (their area still has to stay below 2^32)
+#ifndef SNAKE_COORD_BITS
+#define SNAKE_COORD_BITS 16
+#endif // SNAKE_COORD_BITS
+
+// Types shared by every game variant, so SnakeGame::Direction etc. mean the same thing regardless of grid storage
+struct SnakeTypes {
+#if SNAKE_COORD_BITS == 8
+    typedef uint8_t Coord;
+#elif SNAKE_COORD_BITS == 16
+    typedef uint16_t Coord;
+#elif SNAKE_COORD_BITS == 32
+    typedef uint32_t Coord;
+#else
+#error "SNAKE_COORD_BITS must be 8, 16 or 32"
+#endif // SNAKE_COORD_BITS
+
+    // Widest and tallest grid positions can address
+    static const uint32_t MaxGridSize = std::numeric_limits<Coord>::max();
 
-class SnakeGame {
-public:
     struct Position {
-        uint8_t x;
-        uint8_t y;
+        Coord x;
+        Coord y;
     };
 
+    // Clamp a grid size to [1, MaxGridSize], and the height to keep the area below 2^32, so positions reach every
+    // tile and tile indices fit 32 bits
+    static void ClampGridSize(int& width, int& height) {
+        uint32_t maxSize = MaxGridSize < (uint32_t)std::numeric_limits<int>::max() ? MaxGridSize : std::numeric_limits<int>::max();
+
+        if (width < 1) width = 1;
+        if (height < 1) height = 1;
+        if ((uint32_t)width > maxSize) width = (int)maxSize;
+        if ((uint32_t)height > maxSize) height = (int)maxSize;
+        if ((uint64_t)width * height > std::numeric_limits<uint32_t>::max()) {
+            height = (int)(std::numeric_limits<uint32_t>::max() / (uint32_t)width);
+        }
+    }
+
     enum class Direction: uint8_t { Up = 1, Down = 2, Left = 3, Right = 4, None = 0 };
     enum class Tile: uint8_t { Empty = 0, Snake = 1, Fruit = 2 };
+    // Why a game ended
+    enum class GameOverCause: uint8_t { None = 0, HitSelf = 1, FilledGrid = 2 };
+
+    // What one Tick() did (see GetTickEvents()), for updating renderers, recordings, feeds and searches from
+    // the few tiles that changed instead of scanning the grid
+    // Fixed size and overwritten every tick, fields are only valid while their TICK_* bit is set in flags
+    struct TickEvents {
+        uint8_t flags;
+        GameOverCause cause;
+        // Head before the tick, and the tile it moved onto (or ran into, if it hit itself)
+        Position headFrom;
+        Position headTo;
+        // Tile the tail left, empty now
+        Position tailFreed;
+        // Where the fruit eaten at headTo got replaced
+        Position fruitSpawned;
+
+        // Is TICK_* bit flag set
+        bool Has(uint8_t flag) const { return (this->flags & flag) != 0; }
+    };
+
+    // TickEvents flag bits
+    static const uint8_t TICK_MOVED = 1;
+    static const uint8_t TICK_TAIL_FREED = 2;
+    static const uint8_t TICK_ATE = 4;
+    static const uint8_t TICK_FRUIT_SPAWNED = 8;
+    static const uint8_t TICK_GAME_OVER = 16;
 
+    // Start of a game snapshot (see SaveSnapshot()), followed by the sections it points to
+    // Sections are found by offset from the start of the snapshot and hold no pointers, so a snapshot can be
+    // memcpy'd, written to a file or memory-mapped as is. Fields use the byte order of the machine that saved it
+    struct SnapshotHeader {
+        // SNAPSHOT_MAGIC and SNAPSHOT_VERSION
+        uint32_t magic;
+        uint32_t version;
+        // Bytes in the whole snapshot
+        uint32_t size;
+        uint32_t width;
+        uint32_t height;
+        uint32_t fruitX;
+        uint32_t fruitY;
+        uint32_t snakeLength;
+        uint16_t score;
+        uint8_t direction;
+        // 1 = game over, 2 = game won, 4 = has fruit, 8 = empty tiles aren't listed (the game picks them in grid order)
+        uint8_t flags;
+        // Zero
+        uint32_t reserved;
+        uint64_t seed;
+        // Raw RNG engine state
+        uint32_t rngOffset;
+        uint32_t rngSize;
+        // width * height tiles, one byte each, row-major
+        uint32_t tilesOffset;
+        // snakeCount tile indices (y * width + x), four bytes each, from tail to head
+        uint32_t snakeOffset;
+        uint32_t snakeCount;
+        // freeCount empty tile indices, four bytes each, in the game's own order so fruit spawns replay exactly
+        // (none if they aren't listed)
+        uint32_t freeOffset;
+        uint32_t freeCount;
+    };
+
+    static const uint32_t SNAPSHOT_MAGIC = 0x534e4150; // "SNAP"
+    static const uint32_t SNAPSHOT_VERSION = 2;
+
+    // SnapshotHeader flag bits
+    static const uint8_t SNAPSHOT_GAME_OVER = 1;
+    static const uint8_t SNAPSHOT_GAME_WON = 2;
+    static const uint8_t SNAPSHOT_HAS_FRUIT = 4;
+    static const uint8_t SNAPSHOT_FREE_UNLISTED = 8;
+};
+
+// Game instance, built on top of grid storage Grid (see grid.h)
+// Use the SnakeGame, FixedSnakeGame<W, H>, PackedSnakeGame, CowSnakeGame and ChunkedSnakeGame aliases below
+// Grid sizes are clamped with ClampGridSize()
+template <typename Grid>
+class BasicSnakeGame : public SnakeTypes {
+public:
     int MapGridSizeVertical;
     int MapGridSizeHorizontal;
 
-    // Use default values ()
-    SnakeGame();
-    // Create perfect square (max 255)
-    SnakeGame(int);
-    // Create variable-size rectangle (max 255x255)
-    SnakeGame(int, int);
+    // Use default values (31x31, or the fixed grid size)
+    BasicSnakeGame();
+    // Create perfect square
+    BasicSnakeGame(int);
+    // Create variable-size rectangle
+    BasicSnakeGame(int, int);
+    // Create variable-size rectangle, with a fixed RNG seed for reproducible games
+    BasicSnakeGame(int, int, uint64_t);
 
     // Reset grid and create starting game state
     void Reset();
     // Run through game logic loop
+    // Ticking, turning and spawning fruit never allocate once Reset() has run, except on CowSnakeGame (which
+    // copies shared pages on write) and ChunkedSnakeGame (which allocates chunks as the snake reaches them)
     void Tick();
     // Returns current score
     uint16_t GetScore();
@@ -34,45 +155,137 @@ public:
     void SetScore(uint16_t);
     // Adds parameter to current score (+/-)
     void ModifyScore(int);
+    // Returns how long the snake should currently be
+    uint32_t GetSnakeLength();
+    // Sets how long the snake should be, it grows by one tile per tick until reached, or drops tail parts right away
+    // if it got shorter (clamped to [1, grid area])
+    void SetSnakeLength(uint32_t);
     // Turn the snake (Does nothing if opposite current direction)
     void ChangeDirection(Direction);
     // Has the player died
     bool IsGameOver();
+    // Has the snake filled the whole grid (also sets game over)
+    bool IsGameWon();
+    // Returns amount of empty tiles left on the grid
+    uint32_t GetFreeTileCount();
     // Returns grid width
-    uint16_t GetGridSizeHorizontal();
+    uint32_t GetGridSizeHorizontal();
     // Returns grid height
-    uint16_t GetGridSizeVertical();
+    uint32_t GetGridSizeVertical();
     // Returns tile at (x, y)
     Tile GetTile(int x, int y);
     // Returns read-only snake direction
     Direction GetSnakeDirection();
     // Returns read-only snake head position
     Position GetSnakeHeadPos();
+    // Returns read-only snake tail position (the head, while the snake is one tile long)
+    Position GetSnakeTailPos();
+    // Returns read-only fruit position (only valid while there's fruit, which is until the grid fills up)
+    Position GetFruitPos();
+    // Move the fruit to another random empty tile, returns false if there's no room
+    bool RespawnFruit();
+    // Reseed the RNG engine, call Reset() afterwards to replay a game from the start
+    void Seed(uint64_t);
+    // Returns the seed the RNG engine was last seeded with
+    uint64_t GetSeed();
+    // Replace the RNG engine with an existing one
+    void SetRng(const GameRng&);
+
+    // Bytes SaveSnapshot() needs for the current state
+    size_t GetSnapshotSize();
+    // Write the whole game state to buffer, which must hold GetSnapshotSize() bytes, returns bytes written
+    size_t SaveSnapshot(uint8_t* buffer);
+    // Write the whole game state to a new buffer
+    std::vector<uint8_t> SaveSnapshot();
+    // Replace the game state with a snapshot, returns false if it isn't a valid snapshot, or its grid size doesn't
+    // fit this game (fixed-size grids only restore their own size)
+    // Failed restores leave the game as it was, except for a corrupt free tile list, which resets the game
+    bool RestoreSnapshot(const uint8_t* buffer, size_t size);
+    // Copy of this game that plays on independently
+    // CowSnakeGame forks share grid, snake and free tile pages until either game writes to them
+    BasicSnakeGame Fork();
+    // Zobrist hash of the tiles, head position, direction and snake length (see zobrist.h), kept up to date as
+    // they change, for keying search results in a TranspositionTable
+    // Score, RNG state and game over aren't hashed, states differing only in those hash the same
+    uint64_t GetHash();
 
-#ifdef _WIN32
-    // Helper variable for only redrawing changed tiles on windows
+    // Tiles changed by the last Tick() (every tile after Reset() or RestoreSnapshot()), for only redrawing or
+    // broadcasting what changed, may list a tile more than once
+    // Only collected while tracking is on, which it is by default on Windows, where the game draws from it
     std::vector<Position> ChangedTiles;
-#endif // _WIN32
+    // Turn collecting ChangedTiles on or off
+    void TrackChangedTiles(bool);
+
+    // Most tiles a tick lists in ChangedTiles: new head, old head, old tail and new fruit, with room for a
+    // RespawnFruit() between ticks, reserved up front so ticking never grows the list
+    static const size_t MaxChangedTilesPerTick = 8;
+
+    // What the last Tick() did, filled on every platform and every tick, costing a few stores
+    // Empty after a tick that did nothing (no direction yet, or game over), and after Reset() or RestoreSnapshot()
+    // Only Tick() writes it, a RespawnFruit() between ticks doesn't show up
+    const TickEvents& GetTickEvents();
 
 private:
     // Has the player died
     bool gameOver;
-    // Map grid, for storing tile information
-    std::vector<std::vector<uint8_t>> map;
+    // Has the snake filled the grid
+    bool gameWon;
+    // Map grid, for storing tile information, row-major in one contiguous buffer
+    Grid map;
     // Score counter
     uint16_t score;
-    // Variable-size array for storing snake information
-    std::vector<Position> snake;
+    // Circular buffer of snake parts, tail at the front and head at the back, sized to the grid area
+    // (Lazy grids start it small and let it grow with the snake)
+    RingBuffer<Position, typename Grid::template Array<Position>> snake;
     // How long the snake currently should be
-    uint16_t snakeLength;
+    uint32_t snakeLength;
     // Where the snake is headed
     Direction snakeDirection;
+    // Where the fruit currently is
+    Position fruit;
+    // Is there fruit on the grid
+    bool hasFruit;
+    // Empty tiles, for spawning fruit (see freecells.h)
+    typename Grid::FreeCells freeCells;
+    // Game-owned PRNG, lives as long as the game so fruit spawns don't create engines
+    GameRng rng;
+    // Last seed given to rng
+    uint64_t seed;
+    // Collect ChangedTiles
+    bool trackChanges;
+    // Zobrist hash of the current state
+    uint64_t hash;
+    // Zobrist key of the head position
+    uint64_t headKey;
+    // What the last tick did
+    TickEvents events;
 
     // Move snake by one tile
     void move();
-    // Spawn new fruit randomly on grid
-    void spawnFruit();
+    // Spawn new fruit randomly on an empty tile, returns false if the grid is full
+    bool spawnFruit();
+    // Set tile at (x, y), keeping the empty tile index and the hash up to date
+    void setTile(Coord x, Coord y, Tile);
+    // Move the head onto pos, keeping the hash up to date
+    void pushHead(Position);
+    // Set how long the snake should be, keeping the hash up to date
+    void setSnakeLength(uint32_t);
+    // Hash the whole state from scratch
+    uint64_t computeHash();
 
 };
 
+// Runtime-size grid, one byte per tile
+typedef BasicSnakeGame<FlatGrid> SnakeGame;
+// Compile-time size grid, wrap-around and indexing use constants
+// Only sizes instantiated at the end of game.cpp are available
+template <int W, int H>
+using FixedSnakeGame = BasicSnakeGame<FixedGrid<W, H>>;
+// Runtime-size grid, two bits per tile
+typedef BasicSnakeGame<PackedGrid> PackedSnakeGame;
+// Runtime-size grid, copies share unchanged pages, for search trees that fork games a lot
+typedef BasicSnakeGame<CowGrid> CowSnakeGame;
+// Runtime-size grid for huge boards (e.g. 16384x16384), memory grows with the snake instead of the grid area
+typedef BasicSnakeGame<ChunkedGrid> ChunkedSnakeGame;
+
 #endif // __GAME_INCLUDED__
@@ -0,0 +1,615 @@
+#ifndef __GRID_INCLUDED__
+#define __GRID_INCLUDED__
+
+#include <cstddef> // size_t
+#include <cstdint> // uint8_t, uint32_t, uint64_t, uintptr_t
+#include <cstdlib> // std::malloc, std::free
+#include <cstring> // std::memcpy, std::memset
+#include <memory> // std::unique_ptr<T>
+#include <new> // std::bad_alloc
+#include <vector> // std::vector<T>
+
+#include "cowarray.h" // CowArray<T>
+#include "freecells.h" // DenseFreeCells<Array>, GridFreeCells
+
+/**
+*
+* Tile storage for the game grid
+*
+* Every grid stores W * H tiles in row-major order (cell = y * width + x), and exposes the same
+* Resize/Clear/Get/Set/CopyTo/CopyFrom interface, so the game can be built on any of them:
+*   FlatGrid: runtime size, one byte per tile
+*   FixedGrid<W, H>: compile-time size, one byte per tile, width and height fold into constants
+*   PackedGrid: runtime size, two bits per tile (enough for every Tile value), 4x less memory
+*   CowGrid: runtime size, one byte per tile, in pages shared between copies until written to
+*   ChunkedGrid: runtime size, one byte per tile, in chunks only allocated where tiles aren't empty
+*
+* Array<T> is the container the game keeps its other per-tile arrays in, so a CowGrid game shares
+* those between copies too. FreeCells is how the game tracks empty tiles (see freecells.h), and Lazy
+* grids have the game grow its snake buffer as the snake grows, instead of sizing it to the grid area
+*
+* */
+
+// Length of a cache line, grid buffers start on one
+const size_t GRID_ALIGNMENT = 64;
+
+// Heap buffer starting on a cache line boundary, copies are deep
+class AlignedBuffer {
+public:
+    AlignedBuffer() : raw(nullptr), data(nullptr), size(0) {}
+
+    AlignedBuffer(const AlignedBuffer& other) : raw(nullptr), data(nullptr), size(0) {
+        this->Resize(other.size);
+        if (this->size > 0) std::memcpy(this->data, other.data, this->size);
+    }
+
+    AlignedBuffer& operator=(const AlignedBuffer& other) {
+        if (this != &other) {
+            this->Resize(other.size);
+            if (this->size > 0) std::memcpy(this->data, other.data, this->size);
+        }
+
+        return *this;
+    }
+
+    AlignedBuffer(AlignedBuffer&& other) : raw(other.raw), data(other.data), size(other.size) {
+        other.raw = nullptr;
+        other.data = nullptr;
+        other.size = 0;
+    }
+
+    AlignedBuffer& operator=(AlignedBuffer&& other) {
+        if (this != &other) {
+            std::free(this->raw);
+
+            this->raw = other.raw;
+            this->data = other.data;
+            this->size = other.size;
+
+            other.raw = nullptr;
+            other.data = nullptr;
+            other.size = 0;
+        }
+
+        return *this;
+    }
+
+    ~AlignedBuffer() {
+        std::free(this->raw);
+    }
+
+    // Make room for n bytes, contents are undefined afterwards unless the size didn't change
+    void Resize(size_t bytes) {
+        if (bytes == this->size) return;
+
+        std::free(this->raw);
+        this->raw = nullptr;
+        this->data = nullptr;
+        this->size = bytes;
+
+        if (bytes == 0) return;
+
+        // Over-allocate, and round the start up to the next cache line
+        this->raw = std::malloc(bytes + GRID_ALIGNMENT - 1);
+        if (this->raw == nullptr) throw std::bad_alloc();
+
+        uintptr_t aligned = ((uintptr_t)this->raw + GRID_ALIGNMENT - 1) & ~(uintptr_t)(GRID_ALIGNMENT - 1);
+        this->data = (uint8_t*)aligned;
+    }
+
+    uint8_t* Data() {
+        return this->data;
+    }
+
+    const uint8_t* Data() const {
+        return this->data;
+    }
+
+    size_t Size() const {
+        return this->size;
+    }
+
+private:
+    // Pointer returned by malloc, for freeing
+    void* raw;
+    // Aligned start of usable memory
+    uint8_t* data;
+    // Usable bytes
+    size_t size;
+};
+
+// Runtime-size grid, one byte per tile
+class FlatGrid {
+public:
+    template <typename T>
+    using Array = std::vector<T>;
+    typedef DenseFreeCells<Array<uint32_t>> FreeCells;
+    static const bool Lazy = false;
+
+    // Size used by default-constructed games
+    static const int DefaultWidth = 31;
+    static const int DefaultHeight = 31;
+
+    FlatGrid() : width(0), height(0) {}
+
+    void Resize(int w, int h) {
+        this->width = w;
+        this->height = h;
+        this->tiles.Resize((size_t)w * h);
+    }
+
+    // Set every tile to 0 (Empty)
+    void Clear() {
+        if (this->tiles.Size() > 0) std::memset(this->tiles.Data(), 0, this->tiles.Size());
+    }
+
+    int Width() const {
+        return this->width;
+    }
+
+    int Height() const {
+        return this->height;
+    }
+
+    uint8_t Get(uint32_t cell) const {
+        return this->tiles.Data()[cell];
+    }
+
+    void Set(uint32_t cell, uint8_t value) {
+        this->tiles.Data()[cell] = value;
+    }
+
+    // Copy every tile out to one byte each
+    void CopyTo(uint8_t* out) const {
+        if (this->tiles.Size() > 0) std::memcpy(out, this->tiles.Data(), this->tiles.Size());
+    }
+
+    // Overwrite every tile from one byte each
+    void CopyFrom(const uint8_t* in) {
+        if (this->tiles.Size() > 0) std::memcpy(this->tiles.Data(), in, this->tiles.Size());
+    }
+
+private:
+    int width;
+    int height;
+    AlignedBuffer tiles;
+};
+
+// Compile-time size grid, one byte per tile, stored inline without heap allocation
+template <int W, int H>
+class FixedGrid {
+public:
+    template <typename T>
+    using Array = std::vector<T>;
+    typedef DenseFreeCells<Array<uint32_t>> FreeCells;
+    static const bool Lazy = false;
+
+    static const int DefaultWidth = W;
+    static const int DefaultHeight = H;
+
+    // Size is fixed, requested size is ignored
+    void Resize(int, int) {}
+
+    void Clear() {
+        std::memset(this->tiles, 0, sizeof(this->tiles));
+    }
+
+    static constexpr int Width() {
+        return W;
+    }
+
+    static constexpr int Height() {
+        return H;
+    }
+
+    uint8_t Get(uint32_t cell) const {
+        return this->tiles[cell];
+    }
+
+    void Set(uint32_t cell, uint8_t value) {
+        this->tiles[cell] = value;
+    }
+
+    void CopyTo(uint8_t* out) const {
+        std::memcpy(out, this->tiles, sizeof(this->tiles));
+    }
+
+    void CopyFrom(const uint8_t* in) {
+        std::memcpy(this->tiles, in, sizeof(this->tiles));
+    }
+
+private:
+    alignas(GRID_ALIGNMENT) uint8_t tiles[W * H];
+};
+
+// Runtime-size grid, two bits per tile, packed into 64-bit words (32 tiles per word)
+class PackedGrid {
+public:
+    template <typename T>
+    using Array = std::vector<T>;
+    typedef DenseFreeCells<Array<uint32_t>> FreeCells;
+    static const bool Lazy = false;
+
+    static const int DefaultWidth = 31;
+    static const int DefaultHeight = 31;
+
+    PackedGrid() : width(0), height(0) {}
+
+    void Resize(int w, int h) {
+        this->width = w;
+        this->height = h;
+
+        // Round up to whole words
+        size_t words = ((size_t)w * h + 31) / 32;
+        this->words.Resize(words * sizeof(uint64_t));
+    }
+
+    void Clear() {
+        if (this->words.Size() > 0) std::memset(this->words.Data(), 0, this->words.Size());
+    }
+
+    int Width() const {
+        return this->width;
+    }
+
+    int Height() const {
+        return this->height;
+    }
+
+    uint8_t Get(uint32_t cell) const {
+        const uint64_t* data = (const uint64_t*)this->words.Data();
+        return (uint8_t)((data[cell >> 5] >> ((cell & 31) * 2)) & 3);
+    }
+
+    void Set(uint32_t cell, uint8_t value) {
+        uint64_t* data = (uint64_t*)this->words.Data();
+        int shift = (cell & 31) * 2;
+
+        data[cell >> 5] = (data[cell >> 5] & ~((uint64_t)3 << shift)) | ((uint64_t)(value & 3) << shift);
+    }
+
+    void CopyTo(uint8_t* out) const {
+        uint32_t area = (uint32_t)this->width * this->height;
+        for (uint32_t i = 0; i < area; i++) out[i] = this->Get(i);
+    }
+
+    void CopyFrom(const uint8_t* in) {
+        this->Clear();
+
+        uint32_t area = (uint32_t)this->width * this->height;
+        uint64_t* data = (uint64_t*)this->words.Data();
+        for (uint32_t i = 0; i < area; i++) data[i >> 5] |= (uint64_t)(in[i] & 3) << ((i & 31) * 2);
+    }
+
+private:
+    int width;
+    int height;
+    AlignedBuffer words;
+};
+
+// Runtime-size grid, one byte per tile, split into 4 KiB pages that copies share until one of them writes to a page
+// A tick only writes a few tiles, so a copied game only pays for the pages it actually changes
+class CowGrid {
+public:
+    template <typename T>
+    using Array = CowArray<T>;
+    typedef DenseFreeCells<Array<uint32_t>> FreeCells;
+    static const bool Lazy = false;
+
+    static const int DefaultWidth = 31;
+    static const int DefaultHeight = 31;
+
+    CowGrid() : width(0), height(0) {}
+
+    void Resize(int w, int h) {
+        this->width = w;
+        this->height = h;
+        this->tiles.resize((size_t)w * h);
+    }
+
+    // Fresh zeroed pages, stops sharing with copies
+    void Clear() {
+        this->tiles.assign(this->tiles.size(), 0);
+    }
+
+    int Width() const {
+        return this->width;
+    }
+
+    int Height() const {
+        return this->height;
+    }
+
+    uint8_t Get(uint32_t cell) const {
+        return this->tiles[cell];
+    }
+
+    void Set(uint32_t cell, uint8_t value) {
+        this->tiles[cell] = value;
+    }
+
+    void CopyTo(uint8_t* out) const {
+        for (size_t i = 0; i < this->tiles.size(); i++) out[i] = this->tiles[i];
+    }
+
+    void CopyFrom(const uint8_t* in) {
+        this->tiles.assign(this->tiles.size(), 0);
+        for (size_t i = 0; i < this->tiles.size(); i++) this->tiles[i] = in[i];
+    }
+
+private:
+    int width;
+    int height;
+    CowArray<uint8_t, 12> tiles;
+};
+
+// Runtime-size grid for very large, mostly empty boards, one byte per tile in 64x64 tile chunks
+// A chunk is only allocated once one of its tiles is set to something other than 0 (Empty), and given back once
+// all of them are 0 again, so memory grows with the occupied area instead of the board area
+// Also keeps a count of empty tiles per chunk in a Fenwick tree, so the game can pick the n-th empty tile without
+// an index of every tile (see GridFreeCells)
+class ChunkedGrid {
+public:
+    template <typename T>
+    using Array = std::vector<T>;
+    typedef GridFreeCells FreeCells;
+    static const bool Lazy = true;
+
+    static const int DefaultWidth = 31;
+    static const int DefaultHeight = 31;
+
+    // Chunks are ChunkSize x ChunkSize tiles
+    static const int ChunkBits = 6;
+    static const uint32_t ChunkSize = (uint32_t)1 << ChunkBits;
+    // Freed chunks kept around for reuse, so a snake crossing chunk edges doesn't allocate every time
+    static const size_t SpareChunks = 16;
+
+    ChunkedGrid() : width(0), height(0), chunksX(0), chunksY(0), occupied(0) {}
+
+    ChunkedGrid(const ChunkedGrid& other) : width(0), height(0), chunksX(0), chunksY(0), occupied(0) {
+        *this = other;
+    }
+
+    ChunkedGrid& operator=(const ChunkedGrid& other) {
+        if (this == &other) return *this;
+
+        this->width = other.width;
+        this->height = other.height;
+        this->chunksX = other.chunksX;
+        this->chunksY = other.chunksY;
+        this->occupied = other.occupied;
+        this->used = other.used;
+        this->emptyTree = other.emptyTree;
+        this->spare.clear();
+
+        // Deep copy of allocated chunks only
+        this->chunks.clear();
+        this->chunks.resize(other.chunks.size());
+        for (size_t i = 0; i < other.chunks.size(); i++) {
+            if (!other.chunks[i]) continue;
+
+            this->chunks[i].reset(new uint8_t[ChunkSize * ChunkSize]);
+            std::memcpy(this->chunks[i].get(), other.chunks[i].get(), ChunkSize * ChunkSize);
+        }
+
+        return *this;
+    }
+
+    ChunkedGrid(ChunkedGrid&&) = default;
+    ChunkedGrid& operator=(ChunkedGrid&&) = default;
+
+    void Resize(int w, int h) {
+        this->width = w;
+        this->height = h;
+        this->chunksX = (uint32_t)(w + ChunkSize - 1) >> ChunkBits;
+        this->chunksY = (uint32_t)(h + ChunkSize - 1) >> ChunkBits;
+
+        this->chunks.clear();
+        this->chunks.resize((size_t)this->chunksX * this->chunksY);
+        this->spare.clear();
+        this->Clear();
+    }
+
+    // Give back every chunk, and count every tile as empty
+    void Clear() {
+        for (size_t i = 0; i < this->chunks.size(); i++) {
+            if (this->chunks[i]) this->release(i);
+        }
+
+        this->occupied = 0;
+        this->used.assign(this->chunks.size(), 0);
+
+        // Fenwick tree over empty tiles per chunk, built bottom-up
+        this->emptyTree.assign(this->chunks.size() + 1, 0);
+        for (size_t i = 1; i < this->emptyTree.size(); i++) {
+            this->emptyTree[i] += this->chunkArea(i - 1);
+
+            size_t parent = i + (i & (0 - i));
+            if (parent < this->emptyTree.size()) this->emptyTree[parent] += this->emptyTree[i];
+        }
+    }
+
+    int Width() const {
+        return this->width;
+    }
+
+    int Height() const {
+        return this->height;
+    }
+
+    uint8_t Get(uint32_t cell) const {
+        uint32_t y = cell / (uint32_t)this->width;
+        uint32_t x = cell - y * (uint32_t)this->width;
+
+        const uint8_t* chunk = this->chunks[this->chunkIndex(x, y)].get();
+        return chunk ? chunk[tileIndex(x, y)] : 0;
+    }
+
+    void Set(uint32_t cell, uint8_t value) {
+        uint32_t y = cell / (uint32_t)this->width;
+        uint32_t x = cell - y * (uint32_t)this->width;
+        size_t index = this->chunkIndex(x, y);
+
+        uint8_t* chunk = this->chunks[index].get();
+        if (!chunk) {
+            // Missing chunks are all 0 already
+            if (value == 0) return;
+            chunk = this->allocate(index);
+        }
+
+        uint8_t& tile = chunk[tileIndex(x, y)];
+        bool wasEmpty = tile == 0;
+        tile = value;
+
+        if (wasEmpty && value != 0) {
+            this->used[index]++;
+            this->occupied++;
+            this->addEmpty(index, -1);
+        } else if (!wasEmpty && value == 0) {
+            this->used[index]--;
+            this->occupied--;
+            this->addEmpty(index, 1);
+
+            if (this->used[index] == 0) this->release(index);
+        }
+    }
+
+    // Amount of tiles that are 0
+    uint32_t EmptyCount() const {
+        return (uint32_t)((uint64_t)this->width * this->height - this->occupied);
+    }
+
+    // Cell of empty tile number n, in [0, EmptyCount()), counting chunk by chunk and row by row inside a chunk
+    uint32_t FindEmpty(uint32_t n) const {
+        // Walk down the Fenwick tree to the chunk holding it
+        size_t index = 0;
+        size_t step = 1;
+        while (step * 2 < this->emptyTree.size()) step *= 2;
+
+        for (; step > 0; step /= 2) {
+            if (index + step < this->emptyTree.size() && this->emptyTree[index + step] <= n) {
+                index += step;
+                n -= this->emptyTree[index];
+            }
+        }
+
+        uint32_t originX = (uint32_t)(index % this->chunksX) << ChunkBits;
+        uint32_t originY = (uint32_t)(index / this->chunksX) << ChunkBits;
+        uint32_t chunkWidth = chunkSpan((uint32_t)this->width - originX);
+        uint32_t chunkHeight = chunkSpan((uint32_t)this->height - originY);
+
+        // Missing chunk, every tile is empty
+        const uint8_t* chunk = this->chunks[index].get();
+        if (!chunk) return (originY + n / chunkWidth) * (uint32_t)this->width + originX + n % chunkWidth;
+
+        for (uint32_t y = 0; y < chunkHeight; y++) {
+            const uint8_t* row = chunk + (y << ChunkBits);
+            for (uint32_t x = 0; x < chunkWidth; x++) {
+                if (row[x] != 0) continue;
+                if (n == 0) return (originY + y) * (uint32_t)this->width + originX + x;
+                n--;
+            }
+        }
+
+        // Counts don't match the tiles, can't happen
+        return 0;
+    }
+
+    // Chunks currently allocated, each holding ChunkSize * ChunkSize bytes
+    size_t AllocatedChunks() const {
+        size_t count = 0;
+        for (size_t i = 0; i < this->used.size(); i++) count += this->used[i] > 0;
+        return count;
+    }
+
+    void CopyTo(uint8_t* out) const {
+        std::memset(out, 0, (size_t)this->width * this->height);
+
+        for (size_t i = 0; i < this->chunks.size(); i++) {
+            const uint8_t* chunk = this->chunks[i].get();
+            if (!chunk) continue;
+
+            uint32_t originX = (uint32_t)(i % this->chunksX) << ChunkBits;
+            uint32_t originY = (uint32_t)(i / this->chunksX) << ChunkBits;
+            uint32_t chunkWidth = chunkSpan((uint32_t)this->width - originX);
+            uint32_t chunkHeight = chunkSpan((uint32_t)this->height - originY);
+
+            for (uint32_t y = 0; y < chunkHeight; y++) {
+                std::memcpy(out + (size_t)(originY + y) * this->width + originX, chunk + (y << ChunkBits), chunkWidth);
+            }
+        }
+    }
+
+    void CopyFrom(const uint8_t* in) {
+        this->Clear();
+
+        uint32_t area = (uint32_t)this->width * this->height;
+        for (uint32_t i = 0; i < area; i++) {
+            if (in[i] != 0) this->Set(i, in[i]);
+        }
+    }
+
+private:
+    int width;
+    int height;
+    uint32_t chunksX;
+    uint32_t chunksY;
+    // Tiles that aren't 0
+    uint64_t occupied;
+    // Row-major chunks, null where every tile is 0
+    std::vector<std::unique_ptr<uint8_t[]>> chunks;
+    // Tiles that aren't 0 in each chunk
+    std::vector<uint16_t> used;
+    // Fenwick tree of empty tiles per chunk, 1-based
+    std::vector<uint32_t> emptyTree;
+    // Freed chunks, zeroed and ready for reuse
+    std::vector<std::unique_ptr<uint8_t[]>> spare;
+
+    size_t chunkIndex(uint32_t x, uint32_t y) const {
+        return (size_t)(y >> ChunkBits) * this->chunksX + (x >> ChunkBits);
+    }
+
+    static uint32_t tileIndex(uint32_t x, uint32_t y) {
+        return ((y & (ChunkSize - 1)) << ChunkBits) | (x & (ChunkSize - 1));
+    }
+
+    // Width or height of a chunk starting this many tiles before the edge of the grid
+    static uint32_t chunkSpan(uint32_t remaining) {
+        return remaining < ChunkSize ? remaining : ChunkSize;
+    }
+
+    // Tiles of chunk i that are inside the grid (edge chunks may be cut off)
+    uint32_t chunkArea(size_t i) const {
+        uint32_t originX = (uint32_t)(i % this->chunksX) << ChunkBits;
+        uint32_t originY = (uint32_t)(i / this->chunksX) << ChunkBits;
+        return chunkSpan((uint32_t)this->width - originX) * chunkSpan((uint32_t)this->height - originY);
+    }
+
+    void addEmpty(size_t index, int amount) {
+        for (size_t i = index + 1; i < this->emptyTree.size(); i += i & (0 - i)) {
+            this->emptyTree[i] += (uint32_t)amount;
+        }
+    }
+
+    uint8_t* allocate(size_t index) {
+        if (!this->spare.empty()) {
+            this->chunks[index] = std::move(this->spare.back());
+            this->spare.pop_back();
+        } else {
+            this->chunks[index].reset(new uint8_t[ChunkSize * ChunkSize]());
+        }
+
+        return this->chunks[index].get();
+    }
+
+    void release(size_t index) {
+        if (this->spare.size() < SpareChunks) {
+            std::memset(this->chunks[index].get(), 0, ChunkSize * ChunkSize);
+            this->spare.push_back(std::move(this->chunks[index]));
+        } else {
+            this->chunks[index].reset();
+        }
+    }
+};
+
+#endif // __GRID_INCLUDED__
@@ -0,0 +1,139 @@
+#ifndef _WIN32
+#include <cerrno> // errno, EINTR
+#include <poll.h> // poll(), pollfd
+#include <unistd.h> // read(), write(), pipe(), close(), isatty()
+
+#include "input.h" // Class declaration
+
+// How long to wait for the rest of an escape sequence before treating ESC as a key press
+const int ESCAPE_TIMEOUT_MS = 30;
+
+// Control character sent by Ctrl+C, raw mode turns off the interrupt signal
+const char KEY_CTRL_C = 3;
+const char KEY_ESCAPE = 27;
+
+TerminalInput::TerminalInput() : running(false), pressedButtons(0) {
+    this->wakePipe[0] = -1;
+    this->wakePipe[1] = -1;
+}
+
+TerminalInput::~TerminalInput() {
+    this->Stop();
+}
+
+bool TerminalInput::Start() {
+    if (this->running) return true;
+
+    // Nothing to read keys from if input is piped or redirected
+    if (!isatty(STDIN_FILENO)) return false;
+    if (tcgetattr(STDIN_FILENO, &this->originalSettings) != 0) return false;
+    if (pipe(this->wakePipe) != 0) return false;
+
+    // Raw mode: no line buffering, no echo, and Ctrl+C arrives as a key instead of killing the game
+    // with the terminal still in raw mode
+    termios raw = this->originalSettings;
+    raw.c_lflag &= ~(ICANON | ECHO | ISIG);
+    raw.c_iflag &= ~(IXON | ICRNL);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+
+    this->running = true;
+    this->reader = std::thread(&TerminalInput::readLoop, this);
+
+    return true;
+}
+
+void TerminalInput::Stop() {
+    if (!this->running) return;
+
+    // Wake reader thread up and wait for it to quit
+    char wake = 0;
+    while (write(this->wakePipe[1], &wake, 1) < 0 && errno == EINTR) {}
+    this->reader.join();
+
+    close(this->wakePipe[0]);
+    close(this->wakePipe[1]);
+    this->wakePipe[0] = -1;
+    this->wakePipe[1] = -1;
+
+    tcsetattr(STDIN_FILENO, TCSANOW, &this->originalSettings);
+    this->running = false;
+}
+
+char TerminalInput::TakeButtons() {
+    return this->pressedButtons.exchange(0, std::memory_order_relaxed);
+}
+
+void TerminalInput::readLoop() {
+    pollfd fds[2] = {
+        {STDIN_FILENO, POLLIN, 0},
+        {this->wakePipe[0], POLLIN, 0}
+    };
+
+    // Escape sequence parser state
+    // 0: normal, 1: got ESC, 2: got ESC [ or ESC O (arrow key follows)
+    int state = 0;
+
+    while (1) {
+        // Wait for keys, or for the rest of an escape sequence if one is unfinished
+        int ready = poll(fds, 2, state == 1 ? ESCAPE_TIMEOUT_MS : -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        // Stop() was called
+        if (fds[1].revents != 0) break;
+
+        if (ready == 0) {
+            // Nothing followed ESC, so it was the escape key itself
+            this->pressedButtons.fetch_or(BUTTON_EXIT, std::memory_order_relaxed);
+            state = 0;
+            continue;
+        }
+
+        char buffer[64];
+        ssize_t count = read(STDIN_FILENO, buffer, sizeof(buffer));
+        if (count <= 0) {
+            if (count < 0 && errno == EINTR) continue;
+            break;
+        }
+
+        char buttons = 0;
+        for (ssize_t i = 0; i < count; i++) {
+            char c = buffer[i];
+
+            if (state == 1) {
+                if (c == '[' || c == 'O') {
+                    state = 2;
+                    continue;
+                }
+
+                // ESC followed by an unrelated key
+                buttons |= BUTTON_EXIT;
+                state = 0;
+            } else if (state == 2) {
+                if (c == 'A') buttons |= BUTTON_UP;
+                if (c == 'B') buttons |= BUTTON_DOWN;
+                if (c == 'C') buttons |= BUTTON_RIGHT;
+                if (c == 'D') buttons |= BUTTON_LEFT;
+
+                state = 0;
+                continue;
+            }
+
+            // WASD, either case
+            if (c == 'w' || c == 'W') buttons |= BUTTON_UP;
+            if (c == 'a' || c == 'A') buttons |= BUTTON_LEFT;
+            if (c == 's' || c == 'S') buttons |= BUTTON_DOWN;
+            if (c == 'd' || c == 'D') buttons |= BUTTON_RIGHT;
+            if (c == 'r' || c == 'R') buttons |= BUTTON_RESTART;
+            if (c == KEY_CTRL_C) buttons |= BUTTON_EXIT;
+            if (c == KEY_ESCAPE) state = 1;
+        }
+
+        if (buttons != 0) this->pressedButtons.fetch_or(buttons, std::memory_order_relaxed);
+    }
+}
+#endif // _WIN32
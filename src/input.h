@@ -0,0 +1,56 @@
+#ifndef __INPUT_INCLUDED__
+#define __INPUT_INCLUDED__
+
+#ifndef _WIN32
+#include <atomic> // std::atomic<T>
+#include <thread> // std::thread
+#include <termios.h> // termios
+#endif // _WIN32
+
+// Button bit positions
+
+const char BUTTON_LEFT = 1;
+const char BUTTON_UP = 1 << 1;
+const char BUTTON_RIGHT = 1 << 2;
+const char BUTTON_DOWN = 1 << 3;
+const char BUTTON_RESTART = 1 << 4;
+const char BUTTON_EXIT = 1 << 7;
+
+// END Button bit positions
+
+#ifndef _WIN32
+// Non-blocking keyboard input for POSIX terminals
+// Puts the terminal in raw mode, and reads keys on a dedicated thread that sleeps in poll() until a key arrives,
+// so checking for input from the game loop is a single atomic exchange without any syscalls
+class TerminalInput {
+public:
+    TerminalInput();
+    // Restores the terminal
+    ~TerminalInput();
+
+    // Switch standard input to raw mode and start reading keys, returns false if standard input isn't a terminal
+    bool Start();
+    // Stop reading keys, and restore terminal settings
+    void Stop();
+
+    // Returns BUTTON_* bits of every key pressed since the last call, and clears them
+    char TakeButtons();
+
+private:
+    // Terminal settings before Start()
+    termios originalSettings;
+    // Is the terminal currently in raw mode
+    bool running;
+    // Buttons pressed since last TakeButtons()
+    std::atomic<char> pressedButtons;
+    // Pipe used to wake the reader thread up for stopping
+    int wakePipe[2];
+    // Reader thread
+    std::thread reader;
+
+    // Reader thread body
+    void readLoop();
+};
+#endif // _WIN32
+
+#endif // __INPUT_INCLUDED__
@@ -0,0 +1,136 @@
+#include <fstream> // std::ofstream
+#include <iomanip> // std::setw, std::setprecision
+#include <cstring> // std::memset
+
+#ifdef _MSC_VER
+#include <intrin.h> // _BitScanReverse64()
+#endif // _MSC_VER
+
+#include "latency.h" // Class declarations
+
+// Index of the highest set bit, value must not be 0
+static int highestBit(uint64_t value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return (int)index;
+#else // _MSC_VER
+    return 63 - __builtin_clzll(value);
+#endif // _MSC_VER
+}
+
+LatencyHistogram::LatencyHistogram() {
+    this->Reset();
+}
+
+void LatencyHistogram::Record(int64_t ns) {
+    uint64_t value = ns < 0 ? 0 : (uint64_t)ns;
+
+    this->counts[BucketIndex(value)]++;
+    this->count++;
+    if (value > this->max) this->max = value;
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+    for (int i = 0; i < BucketCount; i++) this->counts[i] += other.counts[i];
+    this->count += other.count;
+    if (other.max > this->max) this->max = other.max;
+}
+
+void LatencyHistogram::Reset() {
+    std::memset(this->counts, 0, sizeof(this->counts));
+    this->count = 0;
+    this->max = 0;
+}
+
+uint64_t LatencyHistogram::GetCount() const {
+    return this->count;
+}
+
+uint64_t LatencyHistogram::GetMax() const {
+    return this->max;
+}
+
+uint64_t LatencyHistogram::Percentile(double p) const {
+    if (this->count == 0) return 0;
+
+    // Rank of the wanted recording, 1-based
+    uint64_t rank = (uint64_t)(p * (double)this->count + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > this->count) rank = this->count;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < BucketCount; i++) {
+        seen += this->counts[i];
+        if (seen >= rank) {
+            // Bucket edge can't be past the longest recording
+            uint64_t bound = BucketUpperBound(i);
+            return bound < this->max ? bound : this->max;
+        }
+    }
+
+    return this->max;
+}
+
+int LatencyHistogram::BucketIndex(uint64_t value) {
+    // First two powers of two get one bucket per value
+    if (value < 2 * SubBucketCount) return (int)value;
+
+    // Past that, keep the top SubBucketBits + 1 bits of the value
+    int shift = highestBit(value) - SubBucketBits;
+    return shift * SubBucketCount + (int)(value >> shift);
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(int index) {
+    if (index < 2 * SubBucketCount) return (uint64_t)index;
+
+    int shift = index / SubBucketCount - 1;
+    uint64_t mantissa = (uint64_t)(index % SubBucketCount + SubBucketCount);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+uint64_t LatencyHistogram::BucketLowerBound(int index) {
+    return index == 0 ? 0 : BucketUpperBound(index - 1) + 1;
+}
+
+void PhaseLatencies::Record(Phase phase, int64_t ns) {
+    this->phases[phase].Record(ns);
+}
+
+const LatencyHistogram& PhaseLatencies::Get(Phase phase) const {
+    return this->phases[phase];
+}
+
+bool PhaseLatencies::WriteReport(const std::string& path) const {
+    std::ofstream file = std::ofstream(path, std::ios::trunc);
+    if (!file) return false;
+
+    // Microseconds, one phase per line, columns separated by whitespace so it's easy to diff and parse
+    file << "phase   count       p50_us      p90_us      p99_us      max_us\n";
+    file << std::fixed << std::setprecision(3);
+
+    for (int i = 0; i < PhaseCount; i++) {
+        const LatencyHistogram& histogram = this->phases[i];
+
+        file << std::left << std::setw(8) << PhaseName((Phase)i) << std::right
+        << std::setw(10) << histogram.GetCount()
+        << std::setw(12) << histogram.Percentile(0.50) / 1000.0
+        << std::setw(12) << histogram.Percentile(0.90) / 1000.0
+        << std::setw(12) << histogram.Percentile(0.99) / 1000.0
+        << std::setw(12) << histogram.GetMax() / 1000.0
+        << '\n';
+    }
+
+    return (bool)file;
+}
+
+const char* PhaseLatencies::PhaseName(Phase phase) {
+    switch (phase) {
+        case Input: return "input";
+        case Decide: return "decide";
+        case Tick: return "tick";
+        case Render: return "render";
+        case Flush: return "flush";
+        default: return "unknown";
+    }
+}
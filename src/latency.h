@@ -0,0 +1,67 @@
+#ifndef __LATENCY_INCLUDED__
+#define __LATENCY_INCLUDED__
+
+#include <cstdint> // uint64_t, int64_t
+#include <string> // std::string
+
+// Fixed-size histogram of durations in nanoseconds
+// Buckets are log-linear (32 per power of two), so every value is within ~3% of its bucket,
+// and recording is a couple of shifts and an increment, with no allocation
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    // Add one duration, negative durations count as 0
+    void Record(int64_t ns);
+    // Add every duration another histogram recorded
+    void Merge(const LatencyHistogram&);
+    // Forget every recorded duration
+    void Reset();
+
+    // Amount of recorded durations
+    uint64_t GetCount() const;
+    // Longest recorded duration, exact
+    uint64_t GetMax() const;
+    // Duration at or under which fraction p (0-1) of recordings fall, rounded up to the bucket edge
+    uint64_t Percentile(double p) const;
+
+    // Sub-buckets per power of two, as a bit count
+    static const int SubBucketBits = 5;
+    static const int SubBucketCount = 1 << SubBucketBits;
+    // Enough buckets for any uint64_t
+    static const int BucketCount = (64 - SubBucketBits + 1) * SubBucketCount;
+
+    // Bucket a value falls into, buckets are in value order
+    static int BucketIndex(uint64_t);
+    // Smallest and largest value that fall into a bucket
+    static uint64_t BucketLowerBound(int);
+    static uint64_t BucketUpperBound(int);
+
+private:
+    uint64_t counts[BucketCount];
+    uint64_t count;
+    uint64_t max;
+};
+
+// One latency histogram per phase of the interactive main loop
+class PhaseLatencies {
+public:
+    // Decide is the autopilot picking a turn, only recorded while it steers
+    enum Phase { Input = 0, Decide, Tick, Render, Flush, PhaseCount };
+
+    // Add one duration to a phase
+    void Record(Phase, int64_t ns);
+    // Histogram of a phase
+    const LatencyHistogram& Get(Phase) const;
+
+    // Write count, p50, p90, p99 and max of every phase to a file (overwriting it), returns false if it can't be written
+    bool WriteReport(const std::string& path) const;
+
+    // Printable name of a phase
+    static const char* PhaseName(Phase);
+
+private:
+    LatencyHistogram phases[PhaseCount];
+};
+
+#endif // __LATENCY_INCLUDED__
@@ -1,6 +1,12 @@
 #include <iostream> // std::cout
-#include <chrono> // std::chrono::high_resolution_clock, std::chrono::duration_cast, std::chrono::nanoseconds
+#include <algorithm> // std::fill
+#include <chrono> // std::chrono::steady_clock, std::chrono::duration_cast, std::chrono::nanoseconds
 #include <vector> // mylib.h
+#include <string> // std::string, std::stoi, std::stoull
+#include <thread> // std::thread::hardware_concurrency, std::this_thread::sleep_for
+#include <sstream> // std::ostringstream
+#include <csignal> // std::signal, std::sig_atomic_t, SIGINT, SIGTERM
+#include <deque> // std::deque<T>
 
 #ifdef _WIN32
 #include <Windows.h> // GetKeyState()
@@ -8,33 +14,20 @@
 
 #include "mylib.h" // Helper functions
 #include "game.h" // Game instance class
+#include "arena.h" // SnakeArena
+#include "runner.h" // Headless batch runner
+#include "render.h" // Grid characters, FrameRenderer
+#include "input.h" // Button bit positions, TerminalInput
+#include "scheduler.h" // FixedStepScheduler
+#include "latency.h" // PhaseLatencies
+#include "replay.h" // InputLog, InputRecorder, ReplayInputLog()
+#include "autopilot.h" // Autopilot
+#include "batch.h" // SnakeBatch
+#include "mcts.h" // MctsPlayer
+#include "spectator.h" // SpectatorFeed, SpectatorView
+#include "server.h" // GameServer, RunServerLoad()
 
 
-// Button bit positions
-
-const char BUTTON_LEFT = 1;
-const char BUTTON_UP = 1 << 1;
-const char BUTTON_RIGHT = 1 << 2;
-const char BUTTON_DOWN = 1 << 3;
-const char BUTTON_EXIT = 1 << 7;
-
-// END Button bit positions
-
-// Grid characters
-
-const char TILE_EMPTY = ' ';
-const char TILE_SNAKE = 'S';
-const char TILE_SNAKE_HEAD_LEFT = '<';
-const char TILE_SNAKE_HEAD_UP = '^';
-const char TILE_SNAKE_HEAD_RIGHT = '>';
-const char TILE_SNAKE_HEAD_DOWN = 'V';
-const char TILE_FRUIT = 'o';
-const char BORDER_VERTICAL = '|';
-const char BORDER_HORIZONTAL = '-';
-const char BORDER_CORNER = '+';
-
-// END Grid characters
-
 #ifdef _WIN32
 // x is the column, y is the row. The origin (0,0) is top-left.
 void setCursorPosition(int x, int y) {
@@ -61,12 +54,895 @@ void hideCmdCursor() {
 }
 #endif // _WIN32
 
-// How many milliseconds to wait before each frame
-const int64_t MIN_MS_FRAMETIME = 1000 / 15;
+// Default game ticks per second
+const double DEFAULT_TICK_RATE = 15;
+// Default maximum frames drawn per second
+const double DEFAULT_RENDER_RATE = 30;
+
+// Set from signal handlers, checked once per loop
+static volatile std::sig_atomic_t quitRequested = 0;
+static volatile std::sig_atomic_t latencyReportRequested = 0;
+
+// SIGINT/SIGTERM, leave the main loop so the terminal gets restored and the latency report written
+void onQuitSignal(int) {
+    quitRequested = 1;
+}
+
+#ifndef _WIN32
+// SIGUSR1, write the latency report without quitting
+void onReportSignal(int) {
+    latencyReportRequested = 1;
+}
+#endif // _WIN32
+
+// Lines the game view takes besides the board rows: score line and grid borders
+const int BOARD_FRAME_ROWS = 3;
+
+// Fit a game's board into columns x rows characters of terminal: the viewport gets what's left after the grid
+// border, and the minimap a third of the viewport each way, counted again from the board
+template <typename Game>
+void fitBoard(Game& game, int columns, int rows, Viewport& viewport, Minimap& minimap) {
+    int boardWidth = (int)game.GetGridSizeHorizontal();
+    int boardHeight = (int)game.GetGridSizeVertical();
+
+    viewport.Resize(boardWidth, boardHeight, columns - 2, rows - BOARD_FRAME_ROWS);
+    minimap.Resize(boardWidth, boardHeight, viewport.GetWidth() / 3, viewport.GetHeight() / 3);
+    minimap.Rebuild(game);
+}
+
+// Draw the game through the viewport starting at row y, with the minimap over the top-right corner of the board
+// if the board doesn't fit
+template <typename Game>
+void drawBoard(FrameRenderer& frame, Game& game, int y, Viewport& viewport, const Minimap& minimap) {
+    viewport.Follow(game.GetSnakeHeadPos());
+    DrawGame(frame, game, y, viewport);
+
+    if (!viewport.IsWhole()) {
+        DrawMinimap(frame, minimap, viewport.GetWidth() - minimap.GetWidth() - 1, y + 2, game.GetSnakeHeadPos());
+    }
+}
+
+// Play games without a terminal as fast as possible, and print throughput
+// Arguments: [--autopilot] [games] [threads] [width] [height] [seed], leaving threads out (or 0) measures scaling from 1 thread up to every core
+int runHeadless(int argc, char* argv[]) {
+    // Let the autopilot play instead of random turns
+    bool autopilot = argc > 0 && std::string(argv[0]) == "--autopilot";
+    if (autopilot) {
+        argc--;
+        argv++;
+    }
+
+    uint64_t games = argc > 0 ? std::stoull(argv[0]) : 10000;
+    int threads = argc > 1 ? std::stoi(argv[1]) : 0;
+    int width = argc > 2 ? std::stoi(argv[2]) : 31;
+    int height = argc > 3 ? std::stoi(argv[3]) : 15;
+
+    BatchRunner runner = BatchRunner(width, height);
+    if (autopilot) runner.SetInputPolicy(AutopilotInputPolicy(Autopilot::DefaultBudget));
+
+    // Fixed seed makes every run play the exact same games
+    if (argc > 4) runner.SetSeed(std::stoull(argv[4]));
+
+    // Thread counts to run, doubling up to hardware concurrency when none given
+    std::vector<int> threadCounts;
+    if (threads > 0) {
+        threadCounts.push_back(threads);
+    } else {
+        int maxThreads = (int)std::thread::hardware_concurrency();
+        if (maxThreads <= 0) maxThreads = 1;
+
+        for (int i = 1; i < maxThreads; i *= 2) threadCounts.push_back(i);
+        threadCounts.push_back(maxThreads);
+    }
+
+    for (size_t i = 0; i < threadCounts.size(); i++) {
+        runner.SetThreadCount(threadCounts[i]);
+        BatchRunner::Result result = runner.Run(games);
+
+        std::cout << result.threads << " threads: "
+        << result.games << " games, "
+        << result.ticks << " ticks in "
+        << result.seconds << " s ("
+        << result.GamesPerSecond() << " games/s, "
+        << result.TicksPerSecond() << " ticks/s, avg score "
+        << (result.games > 0 ? (double)result.totalScore / result.games : 0)
+        << ")\n";
+        std::cout << "  score: sd " << result.scores.GetStdDev()
+        << ", p50 " << result.scores.Percentile(0.50)
+        << ", p99 " << result.scores.Percentile(0.99)
+        << ", max " << result.scores.GetMax()
+        << "; ticks per game: avg " << result.gameTicks.GetMean()
+        << ", p50 " << result.gameTicks.Percentile(0.50)
+        << ", p99 " << result.gameTicks.Percentile(0.99)
+        << ", max " << result.gameTicks.GetMax()
+        << '\n';
+    }
+
+    return 0;
+}
+
+// Re-simulate a recorded session without rendering, and check it ends the way it did when recorded
+// Arguments: file [repeat], repeating the replay is useful for profiling short sessions
+int runReplay(int argc, char* argv[]) {
+    if (argc < 1) {
+        std::cout << "Usage: --replay file [repeat]\n";
+        return 1;
+    }
+
+    InputLog log;
+    if (!log.ReadFile(argv[0])) {
+        std::cout << "Couldn't read input log " << argv[0] << '\n';
+        return 1;
+    }
+
+    int repeat = argc > 1 ? std::stoi(argv[1]) : 1;
+    if (repeat < 1) repeat = 1;
+
+    ReplayResult result;
+    uint64_t totalTicks = 0;
+    double totalSeconds = 0;
+    for (int i = 0; i < repeat; i++) {
+        result = ReplayInputLog(log);
+        totalTicks += result.ticks;
+        totalSeconds += result.seconds;
+    }
+
+    std::cout << (int)log.width << 'x' << (int)log.height << " grid, seed " << log.seed << ": "
+    << result.games << " games, "
+    << result.ticks << " ticks, final score "
+    << result.score << (result.gameWon ? " (won)" : result.gameOver ? " (game over)" : " (still playing)")
+    << '\n';
+    std::cout << totalTicks << " ticks in " << totalSeconds << " s ("
+    << (totalSeconds > 0 ? (double)totalTicks / totalSeconds : 0) << " ticks/s)\n";
+
+    if (!result.valid) {
+        std::cout << "Log is truncated or corrupt\n";
+        return 1;
+    }
+    if (result.mismatches > 0) {
+        std::cout << result.mismatches << " games ended differently than recorded\n";
+        return 1;
+    }
+
+    std::cout << "Every game matched the recording\n";
+    return 0;
+}
+
+// Step SnakeBatch games in lockstep with SnakeGame objects on the same seeds and turns, check every game stays
+// identical after every tick on each kernel the CPU has, then compare throughput
+// Arguments: [games] [ticks] [width] [height] [seed]
+int runBatch(int argc, char* argv[]) {
+    int games = argc > 0 ? std::stoi(argv[0]) : 4096;
+    int ticks = argc > 1 ? std::stoi(argv[1]) : 1000;
+    int width = argc > 2 ? std::stoi(argv[2]) : 16;
+    int height = argc > 3 ? std::stoi(argv[3]) : 16;
+    uint64_t seed = argc > 4 ? std::stoull(argv[4]) : getRandomSeed();
+    if (games < 1) games = 1;
+    if (ticks < 1) ticks = 1;
+
+    std::cout << games << " games of " << width << 'x' << height << ", " << ticks << " ticks, seed " << seed << '\n';
+
+    // Random turns, the same for both sides: usually keep going, sometimes turn
+    // Cycled through during the timed runs, so drawing them isn't timed
+    const int actionTicks = 64;
+    std::vector<uint8_t> actions = std::vector<uint8_t>((size_t)games * actionTicks);
+    GameRng prng = GameRng(seed);
+    for (size_t i = 0; i < actions.size(); i++) {
+        actions[i] = randomBelow(prng, 4) == 0 ? (uint8_t)(randomBelow(prng, 4) + 1) : 0;
+    }
+
+    std::vector<SnakeBatch::Kernel> kernels;
+    std::vector<SnakeBatch::Kernel> allKernels = {SnakeBatch::Kernel::Scalar, SnakeBatch::Kernel::SSE41, SnakeBatch::Kernel::AVX2};
+    for (size_t i = 0; i < allKernels.size(); i++) {
+        if (SnakeBatch::KernelSupported(allKernels[i])) kernels.push_back(allKernels[i]);
+    }
+
+    // Differential check, finished games restart on both sides
+    uint64_t mismatches = 0;
+    std::vector<uint8_t> expected;
+    std::vector<uint8_t> actual;
+    for (size_t k = 0; k < kernels.size(); k++) {
+        SnakeBatch batch = SnakeBatch(games, width, height, seed);
+        batch.SetKernel(kernels[k]);
+
+        std::vector<SnakeGame> reference;
+        reference.reserve(games);
+        for (int i = 0; i < games; i++) reference.push_back(SnakeGame(width, height, seed + i));
+
+        uint64_t kernelMismatches = 0;
+        for (int tick = 0; tick < ticks; tick++) {
+            const uint8_t* tickActions = actions.data() + (size_t)(tick % actionTicks) * games;
+            batch.Step(tickActions);
+
+            for (int i = 0; i < games; i++) {
+                SnakeGame& game = reference[i];
+                if (tickActions[i] != 0) game.ChangeDirection((SnakeTypes::Direction)tickActions[i]);
+                game.Tick();
+
+                expected.resize(game.GetSnapshotSize());
+                actual.resize(batch.GetSnapshotSize(i));
+                game.SaveSnapshot(expected.data());
+                batch.SaveSnapshot(i, actual.data());
+                if (expected != actual) {
+                    // Only the first difference of a game is counted, both sides restart from the reference
+                    kernelMismatches++;
+                    batch.Reset(i);
+                    game.Reset();
+                    continue;
+                }
+
+                if (game.IsGameOver()) {
+                    batch.Reset(i);
+                    game.Reset();
+                }
+            }
+        }
+
+        std::cout << SnakeBatch::KernelName(kernels[k]) << ": " << kernelMismatches << " mismatches\n";
+        mismatches += kernelMismatches;
+    }
+
+    // Throughput, same turns and restarts on every side
+    std::vector<SnakeGame> objects;
+    objects.reserve(games);
+    for (int i = 0; i < games; i++) objects.push_back(SnakeGame(width, height, seed + i));
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < ticks; tick++) {
+        const uint8_t* tickActions = actions.data() + (size_t)(tick % actionTicks) * games;
+        for (int i = 0; i < games; i++) {
+            if (tickActions[i] != 0) objects[i].ChangeDirection((SnakeTypes::Direction)tickActions[i]);
+            objects[i].Tick();
+            if (objects[i].IsGameOver()) objects[i].Reset();
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "SnakeGame objects: " << ((double)games * ticks / seconds) << " game ticks/s\n";
+
+    for (size_t k = 0; k < kernels.size(); k++) {
+        SnakeBatch batch = SnakeBatch(games, width, height, seed);
+        batch.SetKernel(kernels[k]);
+
+        start = std::chrono::steady_clock::now();
+        for (int tick = 0; tick < ticks; tick++) {
+            batch.Step(actions.data() + (size_t)(tick % actionTicks) * games);
+            batch.ResetFinished();
+        }
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "SnakeBatch " << SnakeBatch::KernelName(kernels[k]) << ": " << ((double)games * ticks / seconds) << " game ticks/s\n";
+    }
+
+    if (mismatches > 0) {
+        std::cout << mismatches << " times a batch game differed from SnakeGame\n";
+        return 1;
+    }
+
+    std::cout << "Every game matched SnakeGame\n";
+    return 0;
+}
+
+// Hash of a game's state recomputed from scratch, by restoring a snapshot of it into scratch
+template <typename Game>
+uint64_t rehash(Game& game, Game& scratch, std::vector<uint8_t>& buffer) {
+    buffer.resize(game.GetSnapshotSize());
+    size_t size = game.SaveSnapshot(buffer.data());
+    if (!scratch.RestoreSnapshot(buffer.data(), size)) return ~game.GetHash();
+
+    return scratch.GetHash();
+}
+
+// Does what the last Tick() reported match the game it left: the head on a snake tile, the tail's tile empty,
+// the new fruit where the game has it, and game over for the reason the game gives
+template <typename Game>
+bool eventsMatch(Game& game) {
+    const SnakeTypes::TickEvents& events = game.GetTickEvents();
+    SnakeTypes::Position head = game.GetSnakeHeadPos();
+    SnakeTypes::Position fruit = game.GetFruitPos();
+    SnakeTypes::GameOverCause cause = !game.IsGameOver() ? SnakeTypes::GameOverCause::None
+        : game.IsGameWon() ? SnakeTypes::GameOverCause::FilledGrid : SnakeTypes::GameOverCause::HitSelf;
+
+    if (events.Has(SnakeTypes::TICK_MOVED)) {
+        if (game.GetTile(events.headTo.x, events.headTo.y) != SnakeTypes::Tile::Snake) return false;
+        if (events.headTo.x != head.x || events.headTo.y != head.y) return false;
+    }
+    if (events.Has(SnakeTypes::TICK_TAIL_FREED) && game.GetTile(events.tailFreed.x, events.tailFreed.y) != SnakeTypes::Tile::Empty) return false;
+    if (events.Has(SnakeTypes::TICK_FRUIT_SPAWNED)) {
+        if (events.fruitSpawned.x != fruit.x || events.fruitSpawned.y != fruit.y) return false;
+        if (game.GetTile(fruit.x, fruit.y) != SnakeTypes::Tile::Fruit) return false;
+    }
+
+    return events.Has(SnakeTypes::TICK_GAME_OVER) == game.IsGameOver() && events.cause == cause;
+}
+
+// Play a game with random turns, fruit respawns, length changes and snapshot restores, and compare its
+// incrementally kept hash with a rehash after every one of them, and its tick events with the state they left
+// Returns the amount of mismatches
+template <typename Game>
+uint64_t checkState(const std::string& name, Game game, int ticks, uint64_t seed) {
+    Game scratch = game;
+    Game restored = game;
+    std::vector<uint8_t> buffer;
+    GameRng prng = GameRng(seed);
+    uint64_t mismatches = 0;
+    uint64_t eventMismatches = 0;
+    uint64_t checks = 0;
+
+    for (int i = 0; i < ticks; i++) {
+        if (randomBelow(prng, 4) == 0) game.ChangeDirection((SnakeTypes::Direction)(randomBelow(prng, 4) + 1));
+        if (randomBelow(prng, 64) == 0) game.RespawnFruit();
+        if (randomBelow(prng, 256) == 0) game.SetSnakeLength(randomBelow(prng, 2 * game.GetSnakeLength() + 4));
+
+        // Carry on in a game restored from a snapshot now and then
+        if (randomBelow(prng, 128) == 0) {
+            buffer.resize(game.GetSnapshotSize());
+            size_t size = game.SaveSnapshot(buffer.data());
+            if (!restored.RestoreSnapshot(buffer.data(), size) || restored.GetHash() != game.GetHash()) mismatches++;
+            game = restored;
+        }
+
+        game.Tick();
+
+        mismatches += game.GetHash() != rehash(game, scratch, buffer);
+        eventMismatches += !eventsMatch(game);
+        checks++;
+
+        if (game.IsGameOver()) game.Reset();
+    }
+
+    std::cout << name << ": " << checks << " ticks, " << mismatches << " hash mismatches, " << eventMismatches << " event mismatches\n";
+    return mismatches + eventMismatches;
+}
+
+// Stress a small TranspositionTable from every core, storing entries that can be told apart by their hash, so a
+// probe returning another state's data, e.g. half of a write torn by another thread, is caught
+// Returns the amount of probes that returned wrong data
+uint64_t checkTableThreads(uint64_t seed) {
+    int threadCount = (int)std::thread::hardware_concurrency();
+    if (threadCount < 2) threadCount = 2;
+
+    // A few buckets, so threads keep overwriting each other's entries
+    TranspositionTable table = TranspositionTable(1024);
+    std::vector<uint64_t> hits = std::vector<uint64_t>(threadCount);
+    std::vector<uint64_t> wrong = std::vector<uint64_t>(threadCount);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([&table, &hits, &wrong, seed, t]() {
+            GameRng prng = GameRng(seed + t);
+            for (int i = 0; i < 2000000; i++) {
+                // 256 states, value and move derived from the hash
+                uint64_t hash = ZobristKeys::mix(randomBelow(prng, 256));
+                TranspositionTable::Entry entry;
+                if (i % 2 == 0) {
+                    entry = {(int32_t)(hash >> 32), (uint16_t)randomBelow(prng, 64), (uint8_t)(hash & 3), (uint8_t)(hash >> 8)};
+                    table.Store(hash, entry);
+                } else if (table.Probe(hash, entry)) {
+                    hits[t]++;
+                    if (entry.value != (int32_t)(hash >> 32) || entry.move != (hash & 3) || entry.flags != (uint8_t)(hash >> 8)) wrong[t]++;
+                }
+            }
+        });
+    }
+    for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+
+    uint64_t totalHits = 0;
+    uint64_t totalWrong = 0;
+    for (int t = 0; t < threadCount; t++) {
+        totalHits += hits[t];
+        totalWrong += wrong[t];
+    }
+
+    std::cout << "TranspositionTable, " << threadCount << " threads: " << totalHits << " hits, " << totalWrong << " wrong\n";
+    return totalWrong;
+}
+
+// Probe and Store on one thread: round trips, misses, and which entry of a bucket gets replaced
+// Returns the amount of failed checks
+uint64_t checkTable() {
+    uint64_t failures = 0;
+    TranspositionTable table = TranspositionTable(1 << 16);
+    TranspositionTable::Entry entry;
+
+    // Hashes landing in the same bucket (the table indexes buckets by the low bits)
+    uint64_t a = 0x0123456789abcdefULL;
+    uint64_t b = a + ((uint64_t)1 << 40);
+    uint64_t c = a + ((uint64_t)2 << 40);
+    uint64_t d = a + ((uint64_t)3 << 40);
+    uint64_t e = a + ((uint64_t)4 << 40);
+
+    failures += table.Probe(a, entry);
+
+    // Deepest entry stays in the first slot, the rest take turns in the second
+    table.Store(a, {100, 5, 1, 0});
+    table.Store(b, {200, 3, 2, 0});
+    failures += !(table.Probe(a, entry) && entry.value == 100 && entry.depth == 5 && entry.move == 1);
+    failures += !(table.Probe(b, entry) && entry.value == 200 && entry.depth == 3 && entry.move == 2);
+
+    table.Store(c, {300, 1, 3, 0});
+    failures += table.Probe(b, entry);
+    failures += !(table.Probe(a, entry) && entry.value == 100);
+    failures += !(table.Probe(c, entry) && entry.value == 300);
+
+    // Deeper search replaces the first slot, and the same state always updates in place
+    table.Store(d, {400, 9, 4, 0});
+    failures += table.Probe(a, entry);
+    failures += !(table.Probe(d, entry) && entry.value == 400);
+    table.Store(d, {-400, 2, 1, 7});
+    failures += !(table.Probe(d, entry) && entry.value == -400 && entry.depth == 2 && entry.flags == 7);
+
+    // Other states in the bucket never match
+    failures += table.Probe(e, entry);
+
+    table.Clear();
+    failures += table.Probe(d, entry);
+
+    std::cout << "TranspositionTable: " << table.GetCapacity() << " entries, " << failures << " failed checks\n";
+    return failures;
+}
+
+// Play a crowded arena with random turns and respawns next to a plain model that keeps every snake's body in order,
+// moving every snake at once by the arena's rules, and compare every tile, snake and the free tile count after
+// every tick. Fruits respawn from the arena's RNG, the model only checks they land on empty tiles
+// Returns the amount of mismatches
+uint64_t checkArena(int ticks, uint64_t seed) {
+    const int width = 12;
+    const int height = 8;
+    const int snakeCount = 10;
+    const int fruitCount = 6;
+    const uint32_t area = (uint32_t)(width * height);
+    typedef SnakeTypes::Tile Tile;
+    typedef SnakeTypes::Direction Direction;
+
+    SnakeArena arena = SnakeArena(width, height, snakeCount, fruitCount, seed);
+    GameRng prng = GameRng(seed);
+
+    // Model: tiles, every snake's cells from tail to head, and what it should grow to
+    std::vector<Tile> tiles = std::vector<Tile>(area, Tile::Empty);
+    std::vector<std::deque<uint32_t>> bodies = std::vector<std::deque<uint32_t>>(snakeCount);
+    std::vector<uint32_t> lengths = std::vector<uint32_t>(snakeCount);
+    std::vector<uint16_t> scores = std::vector<uint16_t>(snakeCount);
+    std::vector<uint32_t> targets = std::vector<uint32_t>(snakeCount);
+    std::vector<uint8_t> claims = std::vector<uint8_t>(area);
+    std::vector<bool> dying = std::vector<bool>(snakeCount);
+
+    uint64_t mismatches = 0;
+    uint64_t swaps = 0;
+    uint64_t sharedTargets = 0;
+    uint64_t tailMoves = 0;
+    uint64_t deaths = 0;
+
+    auto cellOf = [width](SnakeTypes::Position pos) { return (uint32_t)pos.y * width + pos.x; };
+    auto step = [width, height](uint32_t cell, Direction direction) {
+        int x = (int)(cell % width);
+        int y = (int)(cell / width);
+        if (direction == Direction::Left) x = x == 0 ? width - 1 : x - 1;
+        if (direction == Direction::Right) x = x == width - 1 ? 0 : x + 1;
+        if (direction == Direction::Up) y = y == 0 ? height - 1 : y - 1;
+        if (direction == Direction::Down) y = y == height - 1 ? 0 : y + 1;
+        return (uint32_t)(y * width + x);
+    };
+    // Take a snake the arena just placed into the model, on a tile that has to be empty
+    auto place = [&](int i) {
+        uint32_t head = cellOf(arena.GetSnakeHeadPos(i));
+        mismatches += tiles[head] != Tile::Empty;
+        tiles[head] = Tile::Snake;
+        bodies[i].assign(1, head);
+        lengths[i] = arena.GetSnakeLength(i);
+        scores[i] = 0;
+    };
+    // Take the fruits the arena has now, eaten ones are already snake in the model, new ones have to be on empty tiles
+    auto takeFruits = [&]() {
+        for (uint32_t cell = 0; cell < area; cell++) {
+            if (tiles[cell] == Tile::Fruit) tiles[cell] = Tile::Empty;
+        }
+        const std::vector<SnakeTypes::Position>& fruits = arena.GetFruits();
+        for (size_t f = 0; f < fruits.size(); f++) {
+            uint32_t cell = cellOf(fruits[f]);
+            mismatches += tiles[cell] != Tile::Empty;
+            tiles[cell] = Tile::Fruit;
+        }
+    };
+
+    for (int i = 0; i < snakeCount; i++) {
+        if (arena.IsAlive(i)) place(i);
+    }
+    takeFruits();
+
+    for (int t = 0; t < ticks; t++) {
+        for (int i = 0; i < snakeCount; i++) {
+            if (!arena.IsAlive(i)) {
+                if (randomBelow(prng, 8) == 0 && arena.RespawnSnake(i)) place(i);
+            } else if (randomBelow(prng, 3) == 0) {
+                arena.ChangeDirection(i, (Direction)(randomBelow(prng, 4) + 1));
+            }
+        }
+
+        // Every head's target against the tiles before the tick
+        std::fill(claims.begin(), claims.end(), 0);
+        for (int i = 0; i < snakeCount; i++) {
+            Direction direction = arena.GetSnakeDirection(i);
+            targets[i] = arena.IsAlive(i) && direction != Direction::None ? step(bodies[i].back(), direction) : area;
+            if (targets[i] < area) claims[targets[i]]++;
+        }
+        for (int i = 0; i < snakeCount; i++) {
+            dying[i] = targets[i] < area && (tiles[targets[i]] == Tile::Snake || claims[targets[i]] > 1);
+            if (targets[i] == area) continue;
+
+            sharedTargets += claims[targets[i]] > 1;
+            for (int j = 0; j < snakeCount; j++) {
+                if (j == i || !arena.IsAlive(j)) continue;
+                swaps += j > i && targets[i] == bodies[j].back() && targets[j] == bodies[i].back();
+                tailMoves += targets[i] == bodies[j].front() && bodies[j].size() >= lengths[j] && targets[j] < area;
+            }
+        }
+
+        // Survivors move onto distinct tiles that weren't snake, then the dead come off the grid
+        for (int i = 0; i < snakeCount; i++) {
+            if (targets[i] == area || dying[i]) continue;
+
+            if (tiles[targets[i]] == Tile::Fruit) {
+                scores[i]++;
+                if (lengths[i] < area) lengths[i]++;
+            }
+            tiles[targets[i]] = Tile::Snake;
+            bodies[i].push_back(targets[i]);
+            if (bodies[i].size() > lengths[i]) {
+                tiles[bodies[i].front()] = Tile::Empty;
+                bodies[i].pop_front();
+            }
+        }
+        for (int i = 0; i < snakeCount; i++) {
+            if (!dying[i]) continue;
+
+            for (size_t k = 0; k < bodies[i].size(); k++) tiles[bodies[i][k]] = Tile::Empty;
+            bodies[i].clear();
+            deaths++;
+        }
+
+        arena.Tick();
+        takeFruits();
+
+        // Compare everything the arena shows
+        uint32_t empty = 0;
+        for (uint32_t cell = 0; cell < area; cell++) {
+            mismatches += arena.GetTile((int)(cell % width), (int)(cell / width)) != tiles[cell];
+            empty += tiles[cell] == Tile::Empty;
+        }
+        mismatches += arena.GetFreeTileCount() != empty;
+        mismatches += arena.GetFruits().size() != (size_t)fruitCount && empty != 0;
+
+        int alive = 0;
+        for (int i = 0; i < snakeCount; i++) {
+            bool modelAlive = !bodies[i].empty();
+            alive += modelAlive;
+            mismatches += arena.IsAlive(i) != modelAlive;
+            if (!modelAlive || !arena.IsAlive(i)) continue;
+
+            mismatches += cellOf(arena.GetSnakeHeadPos(i)) != bodies[i].back();
+            mismatches += cellOf(arena.GetSnakeTailPos(i)) != bodies[i].front();
+            mismatches += arena.GetSnakeLength(i) != lengths[i];
+            mismatches += arena.GetScore(i) != scores[i];
+        }
+        mismatches += arena.GetAliveCount() != alive;
+    }
+
+    std::cout << "SnakeArena " << width << 'x' << height << ", " << snakeCount << " snakes: " << ticks << " ticks, "
+    << swaps << " head-on swaps, " << sharedTargets << " heads sharing a tile, " << tailMoves << " heads onto moving tails, "
+    << deaths << " deaths, " << mismatches << " mismatches\n";
+    return mismatches;
+}
+
+// Check state games keep up to date incrementally against recomputing it: the Zobrist hash and tick events on every
+// grid variant, simultaneous moves in the arena against a plain model, and the transposition table on one thread and
+// from every core
+// Arguments: [ticks] [width] [height] [seed], exit code 1 if anything differs
+int runStateCheck(int argc, char* argv[]) {
+    int ticks = argc > 0 ? std::stoi(argv[0]) : 100000;
+    int width = argc > 1 ? std::stoi(argv[1]) : 31;
+    int height = argc > 2 ? std::stoi(argv[2]) : 15;
+    uint64_t seed = argc > 3 ? std::stoull(argv[3]) : getRandomSeed();
+
+    std::cout << "Seed " << seed << '\n';
+    std::string size = std::to_string(width) + 'x' + std::to_string(height);
+
+    uint64_t failures = 0;
+    failures += checkState("SnakeGame " + size, SnakeGame(width, height, seed), ticks, seed);
+    failures += checkState("PackedSnakeGame " + size, PackedSnakeGame(width, height, seed), ticks, seed);
+    failures += checkState("FixedSnakeGame<31, 15>", FixedSnakeGame<31, 15>(31, 15, seed), ticks, seed);
+    failures += checkState("CowSnakeGame " + size, CowSnakeGame(width, height, seed), ticks, seed);
+    failures += checkState("ChunkedSnakeGame " + size, ChunkedSnakeGame(width, height, seed), ticks, seed);
+    failures += checkArena(ticks, seed);
+    failures += checkTable();
+    failures += checkTableThreads(seed);
+
+    std::cout << (failures == 0 ? "Everything matched\n" : "Found differences\n");
+    return failures == 0 ? 0 : 1;
+}
+
+// Let the tree search play games, thinking for one tick period per move, and compare scores over thread counts
+// Every thread count plays the same seeds, so scores only differ by how much searching got done
+// Arguments: [games] [threads] [tick rate] [max ticks] [width] [height] [seed], leaving threads out (or 0)
+// measures scaling from 1 thread up to every core
+int runSearch(int argc, char* argv[]) {
+    int games = argc > 0 ? std::stoi(argv[0]) : 4;
+    int threads = argc > 1 ? std::stoi(argv[1]) : 0;
+    double tickRate = argc > 2 ? std::stod(argv[2]) : DEFAULT_TICK_RATE;
+    int maxTicks = argc > 3 ? std::stoi(argv[3]) : 150;
+    int width = argc > 4 ? std::stoi(argv[4]) : 31;
+    int height = argc > 5 ? std::stoi(argv[5]) : 15;
+    uint64_t seed = argc > 6 ? std::stoull(argv[6]) : getRandomSeed();
+    if (tickRate <= 0) tickRate = DEFAULT_TICK_RATE;
+
+    std::chrono::steady_clock::duration budget = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1 / tickRate));
+
+    std::cout << games << " games of " << width << 'x' << height << ", at most " << maxTicks << " ticks, "
+    << std::chrono::duration<double, std::milli>(budget).count() << " ms per move, seed " << seed << '\n';
+
+    // Thread counts to run, doubling up to hardware concurrency when none given
+    std::vector<int> threadCounts;
+    if (threads > 0) {
+        threadCounts.push_back(threads);
+    } else {
+        int maxThreads = (int)std::thread::hardware_concurrency();
+        if (maxThreads <= 0) maxThreads = 1;
+
+        for (int i = 1; i < maxThreads; i *= 2) threadCounts.push_back(i);
+        threadCounts.push_back(maxThreads);
+    }
+
+    for (size_t i = 0; i < threadCounts.size(); i++) {
+        MctsPlayer player;
+        player.SetThreadCount(threadCounts[i]);
+        player.SetMoveBudget(budget);
+        player.SetSeed(seed);
+
+        StreamingStats scores;
+        StreamingStats gameTicks;
+        for (int g = 0; g < games; g++) {
+            SnakeGame game = SnakeGame(width, height, seed + g);
+
+            int tick = 0;
+            while (!game.IsGameOver() && tick < maxTicks) {
+                game.ChangeDirection(player.Decide(game));
+                game.Tick();
+                tick++;
+            }
+
+            scores.Add(game.GetScore());
+            gameTicks.Add(tick);
+        }
+
+        MctsPlayer::Stats stats = player.TakeStats();
+        std::cout << stats.threads << " threads: avg score " << scores.GetMean()
+        << " (sd " << scores.GetStdDev()
+        << ", max " << scores.GetMax()
+        << "), avg ticks " << gameTicks.GetMean()
+        << ", " << stats.RolloutsPerSecond() << " rollouts/s, "
+        << stats.RolloutsPerSecondPerCore() << " rollouts/s per core, "
+        << (stats.moves > 0 ? stats.tableHits / stats.moves : 0) << " table hits per move, "
+        << (stats.moves > 0 ? stats.seconds / stats.moves * 1000 : 0) << " ms per move\n";
+    }
+
+    return 0;
+}
+
+#ifndef _WIN32
+// Watch a game another process broadcasts with --spectate, until it quits
+// Arguments: socket
+int runWatch(int argc, char* argv[]) {
+    if (argc < 1) {
+        std::cout << "Usage: --watch socket\n";
+        return 1;
+    }
+
+    SpectatorView view;
+    if (!view.Connect(argv[0])) {
+        std::cout << "Couldn't connect to " << argv[0] << '\n';
+        return 1;
+    }
+
+    std::signal(SIGINT, onQuitSignal);
+    std::signal(SIGTERM, onQuitSignal);
+
+    // Sized once the first keyframe tells the grid size, and again whenever the terminal is resized
+    FrameRenderer frame = FrameRenderer(0, 0);
+    uint32_t width = 0;
+    uint32_t height = 0;
+    int columns = 0;
+    int rows = 0;
+    bool drawn = false;
+
+    // Window onto boards bigger than the terminal, and an overview of the whole board
+    Viewport viewport;
+    Minimap minimap;
+    uint64_t keyframes = 0;
+
+    while (!quitRequested) {
+        // Wake up now and then to notice quit signals while the game is paused
+        int frames = view.Receive(100);
+        if (frames < 0) break;
+        if (frames == 0 || !view.IsSynced()) continue;
+
+        // Status line, board, and two lines for the game's end
+        int terminalColumns = (int)view.GetGridSizeHorizontal() + 2 > 64 ? (int)view.GetGridSizeHorizontal() + 2 : 64;
+        int terminalRows = (int)view.GetGridSizeVertical() + BOARD_FRAME_ROWS + 3;
+        GetTerminalSize(terminalColumns, terminalRows);
+
+        bool refitted = false;
+        if (view.GetGridSizeHorizontal() != width || view.GetGridSizeVertical() != height || terminalColumns != columns || terminalRows != rows) {
+            width = view.GetGridSizeHorizontal();
+            height = view.GetGridSizeVertical();
+            columns = terminalColumns;
+            rows = terminalRows;
+            fitBoard(view, columns, rows - 3, viewport, minimap);
+            frame = FrameRenderer(columns, viewport.GetHeight() + BOARD_FRAME_ROWS + 3);
+            frame.Invalidate();
+            refitted = true;
+        }
+
+        // Keyframes replace the whole board, deltas only the tiles they list, refitting already counted the board
+        if (refitted) {
+            keyframes = view.GetKeyframeCount();
+        } else if (view.GetKeyframeCount() != keyframes) {
+            keyframes = view.GetKeyframeCount();
+            minimap.Rebuild(view);
+        } else {
+            for (size_t i = 0; i < view.ChangedTiles.size(); i++) {
+                const SpectatorView::TileChange& change = view.ChangedTiles[i];
+                minimap.Change(change.pos.x, change.pos.y, change.from, change.to);
+            }
+        }
+        view.ChangedTiles.clear();
+
+        frame.Clear();
+        frame.SetText(0, 0, std::string("Watching ") + argv[0] + ", tick " + std::to_string(view.GetTick()));
+        drawBoard(frame, view, 1, viewport, minimap);
+        if (view.IsGameWon()) frame.SetText(0, viewport.GetHeight() + 4, "The snake filled the grid!");
+        if (view.IsGameOver()) frame.SetText(0, viewport.GetHeight() + 5, "Game Over");
+        frame.Present();
+        drawn = true;
+    }
+
+    if (drawn) frame.Restore();
+    std::cout << (quitRequested ? "Stopped watching\n" : "Feed closed\n");
+    return 0;
+}
+#endif // _WIN32
+
+#ifdef __linux__
+// Host game sessions for clients until interrupted, printing load and capacity every few seconds
+// Arguments: address [threads] [tick rate] [width] [height], address is a loopback TCP port or a socket file
+int runServer(int argc, char* argv[]) {
+    if (argc < 1) {
+        std::cout << "Usage: --server address [threads] [tick rate] [width] [height]\n";
+        return 1;
+    }
+
+    int threads = argc > 1 ? std::stoi(argv[1]) : 0;
+    double tickRate = argc > 2 ? std::stod(argv[2]) : DEFAULT_TICK_RATE;
+    int width = argc > 3 ? std::stoi(argv[3]) : 31;
+    int height = argc > 4 ? std::stoi(argv[4]) : 15;
+
+    GameServer server = GameServer(width, height);
+    server.SetThreadCount(threads);
+    server.SetTickRate(tickRate);
+    if (!server.Start(argv[0])) {
+        std::cout << "Couldn't listen on " << argv[0] << '\n';
+        return 1;
+    }
+
+    std::signal(SIGINT, onQuitSignal);
+    std::signal(SIGTERM, onQuitSignal);
+
+    // Report every 5 seconds, checking for signals in between
+    const int reportTicks = 50;
+    int waited = 0;
+    while (!quitRequested) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (++waited < reportTicks) continue;
+        waited = 0;
+
+        GameServer::Report report = server.TakeReport();
+        double busiest = 0;
+        double busy = 0;
+        for (size_t i = 0; i < report.busy.size(); i++) {
+            busy += report.busy[i];
+            if (report.busy[i] > busiest) busiest = report.busy[i];
+        }
+
+        std::cout << report.sessions << " sessions on " << report.loops << " loops: "
+        << report.TicksPerSecond() << " ticks/s, "
+        << report.missedTicks << " missed, "
+        << report.droppedFrames << " frames dropped; tick latency p50 "
+        << (double)report.tickLatency.Percentile(0.50) / 1000 << " us, p99 "
+        << (double)report.tickLatency.Percentile(0.99) / 1000 << " us, max "
+        << (double)report.tickLatency.GetMax() / 1000 << " us; busy "
+        << (report.loops > 0 ? busy / report.loops : 0) * 100 << "% (busiest loop "
+        << busiest * 100 << "%), ~"
+        << (uint64_t)report.SessionsPerCore() << " sessions per core\n";
+    }
+
+    server.Stop();
+    return 0;
+}
+
+// Play sessions on a running server with random turns, and print what came back
+// Arguments: address [sessions] [seconds]
+int runServerLoad(int argc, char* argv[]) {
+    if (argc < 1) {
+        std::cout << "Usage: --server-load address [sessions] [seconds]\n";
+        return 1;
+    }
+
+    int sessions = argc > 1 ? std::stoi(argv[1]) : 1000;
+    double seconds = argc > 2 ? std::stod(argv[2]) : 10;
+
+    ServerLoadResult result = RunServerLoad(argv[0], sessions, seconds);
+    std::cout << result.connected << " sessions connected, " << result.open << " still open after "
+    << result.seconds << " s: "
+    << result.frames << " frames ("
+    << (result.seconds > 0 ? (double)result.frames / result.seconds : 0) << " frames/s, "
+    << (result.seconds > 0 ? (double)result.bytes / result.seconds / 1024 : 0) << " KiB/s), "
+    << result.restarts << " restarts\n";
+
+    return result.connected == sessions && result.open == result.connected ? 0 : 1;
+}
+#endif // __linux__
+
+int main(int argc, char* argv[]) {
+    // Skip the interactive game entirely in headless, replay, batch, search, state check, watch and server modes
+    if (argc > 1 && std::string(argv[1]) == "--headless") {
+        return runHeadless(argc - 2, argv + 2);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--replay") {
+        return runReplay(argc - 2, argv + 2);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--batch") {
+        return runBatch(argc - 2, argv + 2);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--search") {
+        return runSearch(argc - 2, argv + 2);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--state-check") {
+        return runStateCheck(argc - 2, argv + 2);
+    }
+#ifndef _WIN32
+    if (argc > 1 && std::string(argv[1]) == "--watch") {
+        return runWatch(argc - 2, argv + 2);
+    }
+#endif // _WIN32
+#ifdef __linux__
+    if (argc > 1 && std::string(argv[1]) == "--server") {
+        return runServer(argc - 2, argv + 2);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--server-load") {
+        return runServerLoad(argc - 2, argv + 2);
+    }
+#endif // __linux__
 
-int main() {
-    // How many nanoseconds passed since last frame
-    int64_t nsSinceLast = 0;
+    // Tick and render rates, can be changed with --tick-rate N and --render-rate N
+    double tickRate = DEFAULT_TICK_RATE;
+    double renderRate = DEFAULT_RENDER_RATE;
+    // Latency report file, written at exit and on SIGUSR1 if set with --latency-report FILE
+    std::string latencyReportPath;
+    // Input log file, written at exit if set with --record FILE
+    std::string recordPath;
+    // Socket file to broadcast the game on, if set with --spectate FILE
+    std::string spectatePath;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string(argv[i]) == "--tick-rate") tickRate = std::stod(argv[i + 1]);
+        if (std::string(argv[i]) == "--render-rate") renderRate = std::stod(argv[i + 1]);
+        if (std::string(argv[i]) == "--latency-report") latencyReportPath = argv[i + 1];
+        if (std::string(argv[i]) == "--record") recordPath = argv[i + 1];
+        if (std::string(argv[i]) == "--spectate") spectatePath = argv[i + 1];
+    }
+
+    std::signal(SIGINT, onQuitSignal);
+    std::signal(SIGTERM, onQuitSignal);
+#ifndef _WIN32
+    std::signal(SIGUSR1, onReportSignal);
+#endif // _WIN32
 
     // Could use bools, using bitmask for minimal memory savings
     char buttonMask = 0;
@@ -82,16 +958,85 @@ int main() {
     // Has game over screen been drawn
     bool gameOverScreen = false;
 
-    // Game instance
-    SnakeGame game = SnakeGame(31, 15);
+    // Game instance, fixed size so wrap-around and indexing compile to constants
+    FixedSnakeGame<31, 15> game;
+
+#ifndef _WIN32
+    // Live broadcast to viewers started with --watch, built from the tiles every tick changes
+    SpectatorFeed spectators;
+    bool spectating = !spectatePath.empty();
+    if (spectating) {
+        if (!spectators.Start(spectatePath)) {
+            std::cout << "Couldn't listen on " << spectatePath << '\n';
+            return 1;
+        }
+    }
+
+    // Only spectators need changed tiles, the screen and minimap draw from tick events
+    // (Windows tracks them by default, its renderer still draws from them)
+    if (spectating) game.TrackChangedTiles(true);
+
+    // Terminal frame: status line, score, bordered grid, frametime and game over lines
+    // Boards bigger than the terminal are shown through a viewport following the head, with a minimap
+    // Refitted whenever the terminal is resized
+    Viewport viewport;
+    Minimap minimap;
+    int columns = 0;
+    int rows = 0;
+    FrameRenderer frame = FrameRenderer(0, 0);
+    minimap.Resize(game.GetGridSizeHorizontal(), game.GetGridSizeVertical(), 1, 1);
+    minimap.Rebuild(game);
+
+    // Raw-mode keyboard input, falls back to random inputs if standard input isn't a terminal
+    TerminalInput input;
+    bool terminalInput = input.Start();
+#endif // _WIN32
+
+    // Sleeps until the next tick or render instead of spinning
+    FixedStepScheduler scheduler = FixedStepScheduler(tickRate, renderRate);
+
+    // Ticks run since the last render
+    int ticksSinceRender = 0;
+
+    // Frame statistics line, refreshed once a second
+    std::string frameStats;
+    std::chrono::steady_clock::time_point lastStatsUpdate = std::chrono::steady_clock::now();
+
+#ifndef _WIN32
+    // Plays the game when keys can't be read
+    Autopilot autopilot;
+#endif // _WIN32
+
+    // Time spent in each phase of the loop
+    PhaseLatencies latencies;
+
+    // Every input that changes the game, for replaying the session later
+    bool recording = !recordPath.empty();
+    InputRecorder recorder = InputRecorder(game.GetGridSizeHorizontal(), game.GetGridSizeVertical(), game.GetSeed());
+
+    // Turn the snake, and log the turn if it took effect
+    auto turn = [&game, &recorder, recording](SnakeGame::Direction dir) {
+        SnakeGame::Direction before = game.GetSnakeDirection();
+        game.ChangeDirection(dir);
+        if (recording && game.GetSnakeDirection() != before) recorder.RecordDirection(dir);
+    };
 
     // Main loop
     while (1) {
+        // Sleep until the next tick or render is due
+        scheduler.WaitForNext();
+
+        if (quitRequested) break;
+        if (latencyReportRequested) {
+            latencyReportRequested = 0;
+            if (!latencyReportPath.empty()) latencies.WriteReport(latencyReportPath);
+        }
+
         // Reset button mask
         buttonMask = 0;
 
         // Get time at start of loop
-        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
 #ifdef _WIN32
         // Check high bit of GetKeyState, if it's set, key is down, WASD/arrows = set correct bit of button mask
@@ -112,6 +1057,7 @@ int main() {
                 // Windows-only variable, comment here as a reminder for when cross-platform input gets implemented
                 initialDraw = true;
 
+                if (recording) recorder.RecordRestart(game);
                 game.Reset();
                 gameOverScreen = false;
             }
@@ -120,39 +1066,72 @@ int main() {
         // Exit out of the loop on ESC
         if (GetKeyState(VK_ESCAPE) & 0x8000) break;
 #else // _WIN32
-        // TODO: Implement cross-platform input later
-        // Would probably need a rewrite to run in a window, rather than a terminal
-        // Non-blocking terminal input without waiting for delimiter, apparently fairly complicated
-
-        // As a temporary fix, use completely random inputs
-        if (nsSinceLast % 200 == 11) {
-            game.ChangeDirection(SnakeGame::Direction::Right);
-        } else if (nsSinceLast % 200 == 16) {
-            game.ChangeDirection(SnakeGame::Direction::Up);
-        } else if (nsSinceLast % 200 == 8) {
-            game.ChangeDirection(SnakeGame::Direction::Down);
-        } else if (nsSinceLast % 200 == 7) {
-            game.ChangeDirection(SnakeGame::Direction::Left);
+        // Standard input isn't a terminal, the autopilot steers instead, right before every tick
+        if (terminalInput) {
+            // Keys pressed since last loop, read by the input thread
+            buttonMask |= input.TakeButtons();
+
+            // Restart game on R, if game has ended
+            if (game.IsGameOver() && (buttonMask & BUTTON_RESTART)) {
+                if (recording) recorder.RecordRestart(game);
+                game.Reset();
+                minimap.Rebuild(game);
+                gameOverScreen = false;
+                if (spectating) spectators.Resync();
+            }
         }
 #endif // _WIN32
 
-        if (buttonMask & BUTTON_LEFT) game.ChangeDirection(SnakeGame::Direction::Left);
-        if (buttonMask & BUTTON_UP) game.ChangeDirection(SnakeGame::Direction::Up);
-        if (buttonMask & BUTTON_RIGHT) game.ChangeDirection(SnakeGame::Direction::Right);
-        if (buttonMask & BUTTON_DOWN) game.ChangeDirection(SnakeGame::Direction::Down);
+        if (buttonMask & BUTTON_LEFT) turn(SnakeGame::Direction::Left);
+        if (buttonMask & BUTTON_UP) turn(SnakeGame::Direction::Up);
+        if (buttonMask & BUTTON_RIGHT) turn(SnakeGame::Direction::Right);
+        if (buttonMask & BUTTON_DOWN) turn(SnakeGame::Direction::Down);
+
+        latencies.Record(PhaseLatencies::Input, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
 
         // Break out of loop on exit button
         if (buttonMask & BUTTON_EXIT) break;
 
-        if (nsSinceLast / 1000000 < MIN_MS_FRAMETIME) {
-            // If timer for next frame hasn't been passed, do nothing
-            nsSinceLast += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count();
-            continue;
+        // Run every tick that's due, usually one, more if the loop fell behind
+        int dueTicks = scheduler.TakeDueTicks();
+        for (int i = 0; i < dueTicks; i++) {
+#ifndef _WIN32
+            // Timed apart from the tick, so the tick phase stays the simulation alone
+            if (!terminalInput) {
+                std::chrono::steady_clock::time_point decideStart = std::chrono::steady_clock::now();
+                turn(autopilot.Decide(game));
+                latencies.Record(PhaseLatencies::Decide, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - decideStart).count());
+            }
+#endif // _WIN32
+            // Ticks after game over don't change anything to broadcast
+            bool ticked = !game.IsGameOver();
+            std::chrono::steady_clock::time_point tickStart = std::chrono::steady_clock::now();
+            game.Tick();
+            latencies.Record(PhaseLatencies::Tick, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - tickStart).count());
+            if (recording) recorder.RecordTick();
+
+#ifndef _WIN32
+            minimap.Update(game.GetTickEvents());
+
+            // Only queues frames and sends what sockets take right away, never waits on a viewer
+            if (spectating && ticked) spectators.PublishTick(game);
+#else // _WIN32
+            (void)ticked;
+#endif // _WIN32
         }
+        ticksSinceRender += dueTicks;
 
-        // Tick on every frame
-        // (Unfortunately does tie tickrate to framerate, but since it's a command line game, it doesn't matter here)
-        game.Tick();
+#ifndef _WIN32
+        // New viewers and frames sockets didn't take yet, ticking or not
+        if (spectating) spectators.Update(game);
+#endif // _WIN32
+
+        // Rendering runs at its own capped rate, independent of ticks
+        if (!scheduler.TakeRenderDue()) continue;
+
+        // Render phase covers drawing the frame, up to sending it to the terminal
+        // (on Windows, drawing already writes to the console, so flush only covers the final flush)
+        std::chrono::steady_clock::time_point renderStart = std::chrono::steady_clock::now();
 
         // If game ends, show last frame and quit drawing until restart
         if (game.IsGameOver() && gameOverScreen) {
@@ -160,20 +1139,15 @@ int main() {
         }
 
 #ifdef _WIN32
+        // ChangedTiles only covers the last tick, redraw everything if more than one ran since the last frame
+        if (ticksSinceRender > 1) initialDraw = true;
+
         // Use windows call to redraw over earlier screen to avoid unnecessary writes
         setCursorPosition(0, 0);
-#else // _WIN32
-        // Clear screen, or at least portion of it
-        printChar('\n', 8);
-
-        // Warn user if running unsupported system
-        std::cout << "Input is currently Windows-only, using random inputs\n";
-#endif // _WIN32
 
         // Scoreboard
         std::cout << "Score: " << (int)game.GetScore() << '\n';
 
-#ifdef _WIN32
         // Draw empty game field on initial draw
         if (initialDraw) {
             // Print upper grid border
@@ -242,83 +1216,102 @@ int main() {
         // Set cursor under game field after drawing
         setCursorPosition(0, (int)game.GetGridSizeVertical() + 2);
 #else // _WIN32
-        // Print upper grid border
-        printChar(BORDER_CORNER, 1);
-        printChar(BORDER_HORIZONTAL, game.GetGridSizeHorizontal());
-        printChar(BORDER_CORNER, 1);
-        std::cout << '\n';
-
-        // Print all rows
-        for (uint16_t i = 0; i < game.GetGridSizeVertical(); i++) {
-            // Leftmost grid border
-            std::cout << BORDER_VERTICAL;
-
-            // Print all columns in row i
-            for (uint16_t j = 0; j < game.GetGridSizeHorizontal(); j++) {
-                // Print columns according to tile
-                SnakeGame::Tile tile = game.GetTile(j, i);
-                if (tile == SnakeGame::Tile::Empty) std::cout << TILE_EMPTY;
-                if (tile == SnakeGame::Tile::Snake) {
-                    // Check if tile is snake head
-                    SnakeGame::Position headPos = game.GetSnakeHeadPos();
-                    if (i == (uint16_t)headPos.y && j == (uint16_t)headPos.x) {
-                        // If tile is snake head, print directional head tile
-                        SnakeGame::Direction snakeDir = game.GetSnakeDirection();
-                        if (snakeDir == SnakeGame::Direction::Left) std::cout << TILE_SNAKE_HEAD_LEFT;
-                        if (snakeDir == SnakeGame::Direction::Up) std::cout << TILE_SNAKE_HEAD_UP;
-                        if (snakeDir == SnakeGame::Direction::Right) std::cout << TILE_SNAKE_HEAD_RIGHT;
-                        if (snakeDir == SnakeGame::Direction::Down) std::cout << TILE_SNAKE_HEAD_DOWN;
-
-                        // In case game hasn't started yet, print snake body tile
-                        if (snakeDir == SnakeGame::Direction::None) std::cout << TILE_SNAKE;
-                    } else {
-                        // Not snake head, print snake body tile
-                        std::cout << TILE_SNAKE;
-                    }
-                }
-                if (tile == SnakeGame::Tile::Fruit) std::cout << TILE_FRUIT;
-            }
-            // Rightmost grid border
-            std::cout << BORDER_VERTICAL << '\n';
+        // Refit the board if the terminal changed size, without a terminal the whole board is drawn
+        int terminalColumns = (int)game.GetGridSizeHorizontal() + 2 > 64 ? (int)game.GetGridSizeHorizontal() + 2 : 64;
+        int terminalRows = (int)game.GetGridSizeVertical() + BOARD_FRAME_ROWS + 4;
+        GetTerminalSize(terminalColumns, terminalRows);
+        if (terminalColumns != columns || terminalRows != rows) {
+            columns = terminalColumns;
+            rows = terminalRows;
+            fitBoard(game, columns, rows - 4, viewport, minimap);
+            frame = FrameRenderer(columns, viewport.GetHeight() + BOARD_FRAME_ROWS + 4);
+            frame.Invalidate();
         }
 
-        // Print bottom grid border
-        printChar(BORDER_CORNER, 1);
-        printChar(BORDER_HORIZONTAL, game.GetGridSizeHorizontal());
-        printChar(BORDER_CORNER, 1);
+        // Draw the whole frame in memory, only changed cells get sent to the terminal
+        frame.Clear();
+
+        // Controls, or a warning if keys can't be read
+        if (terminalInput) {
+            frame.SetText(0, 0, "WASD/arrows to move, R to restart, ESC to quit");
+        } else {
+            frame.SetText(0, 0, "Standard input isn't a terminal, autopilot is playing");
+        }
+
+        drawBoard(frame, game, 1, viewport, minimap);
 #endif // _WIN32
 
         // Get timespan between start of loop, and here
-        int64_t span = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count();
+        int64_t span = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+        // Refresh frametime, fps and CPU usage once a second, averaging over that second
+        if (std::chrono::steady_clock::now() - lastStatsUpdate >= std::chrono::seconds(1)) {
+            lastStatsUpdate = std::chrono::steady_clock::now();
 
-        // Print frametime for reference
-        std::cout << '\n'
-        << (float)span / 1000000
-        << " ms ("
-        << (float)nsSinceLast / 1000000
-        << " total ms) ("
-        << 1.f / ((float) nsSinceLast / 1000000000)
-        << " fps)";
+            std::ostringstream stats;
+            stats << (float)span / 1000000
+            << " ms ("
+            << scheduler.GetRenderRate()
+            << " fps) (CPU "
+            << scheduler.GetCpuUsage() * 100
+            << "%) ("
+            << scheduler.GetMissedDeadlines()
+            << " missed ticks)";
+            frameStats = stats.str();
+        }
 
 #ifdef _WIN32
+        std::cout << '\n' << frameStats;
+
         // If using windows-only drawing logic, make sure to clear fps counter trail
         printChar(' ', 16);
+#else // _WIN32
+        frame.SetText(0, viewport.GetHeight() + 4, frameStats);
 #endif // _WIN32
 
-        // Set timer back by millisecond timer converted to nanos
-        nsSinceLast -= MIN_MS_FRAMETIME * 1000000;
-        nsSinceLast += span;
+        ticksSinceRender = 0;
 
         // Basic game-over display
         if (game.IsGameOver()) {
+#ifdef _WIN32
+            if (game.IsGameWon()) std::cout << "\nThe snake filled the grid!";
             std::cout << "\nGame Over, press R to restart!\n";
+#else // _WIN32
+            if (game.IsGameWon()) frame.SetText(0, viewport.GetHeight() + 5, "The snake filled the grid!");
+            frame.SetText(0, viewport.GetHeight() + 6, "Game Over, press R to restart!");
+#endif // _WIN32
             // If game ended, draw screen once and set bool
             gameOverScreen = true;
         }
 
+        std::chrono::steady_clock::time_point flushStart = std::chrono::steady_clock::now();
+        latencies.Record(PhaseLatencies::Render, std::chrono::duration_cast<std::chrono::nanoseconds>(flushStart - renderStart).count());
+
+#ifdef _WIN32
         // Print newline and flush output stream at the end
         std::cout << std::endl;
+#else // _WIN32
+        // Send changed cells to the terminal in one write
+        frame.Present();
+#endif // _WIN32
+
+        latencies.Record(PhaseLatencies::Flush, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - flushStart).count());
     } // Main loop
 
+#ifndef _WIN32
+    // Give the terminal back in the state it was in
+    input.Stop();
+    frame.Restore();
+#endif // _WIN32
+
+    if (recording) {
+        recorder.Finish(game);
+        if (!recorder.GetLog().WriteFile(recordPath)) std::cout << "Couldn't write input log to " << recordPath << '\n';
+    }
+
+    if (!latencyReportPath.empty() && !latencies.WriteReport(latencyReportPath)) {
+        std::cout << "Couldn't write latency report to " << latencyReportPath << '\n';
+    }
+
     return 0;
 }
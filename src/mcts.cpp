@@ -0,0 +1,301 @@
+#include <algorithm> // std::min
+#include <cmath> // std::sqrt, std::log, std::ldexp
+#include <cstdlib> // std::abs
+
+#include "mylib.h" // getRandomSeed()
+#include "mcts.h" // Class declaration
+
+// Exploration weight of UCB1
+const double MCTS_EXPLORATION = 0.7;
+// Default size of the transposition table in bytes
+const size_t MCTS_TABLE_BYTES = 16 << 20;
+// Mean rewards in [0, 1] are stored in transposition table entries as fixed point with this many fraction bits
+const int MCTS_VALUE_BITS = 24;
+
+// Direction that undoes d, ChangeDirection() ignores it
+static SnakeTypes::Direction opposite(SnakeTypes::Direction d) {
+    switch (d) {
+    case SnakeTypes::Direction::Up: return SnakeTypes::Direction::Down;
+    case SnakeTypes::Direction::Down: return SnakeTypes::Direction::Up;
+    case SnakeTypes::Direction::Left: return SnakeTypes::Direction::Right;
+    case SnakeTypes::Direction::Right: return SnakeTypes::Direction::Left;
+    default: return SnakeTypes::Direction::None;
+    }
+}
+
+double MctsPlayer::Stats::RolloutsPerSecond() const {
+    return this->seconds > 0 ? (double)this->rollouts / this->seconds : 0;
+}
+
+double MctsPlayer::Stats::RolloutsPerSecondPerCore() const {
+    return this->threads > 0 ? this->RolloutsPerSecond() / this->threads : 0;
+}
+
+MctsPlayer::MctsPlayer() : root(1, 1, 0), cowRoot(1, 1, 0) {
+    this->threadCount = 0;
+    this->budget = std::chrono::milliseconds(50);
+    this->rolloutDepth = 64;
+    this->seed = getRandomSeed();
+    this->table.reset(new TranspositionTable(MCTS_TABLE_BYTES));
+    this->generation = 0;
+    this->stats = {0, 0, 0, 0, 0};
+}
+
+void MctsPlayer::SetThreadCount(int threads) {
+    this->threadCount = threads < 0 ? 0 : threads;
+
+    // Pool and trees get rebuilt for the new count on the next decision
+    this->pool.reset();
+    this->trees.clear();
+}
+
+void MctsPlayer::SetMoveBudget(std::chrono::steady_clock::duration moveBudget) {
+    this->budget = moveBudget;
+}
+
+void MctsPlayer::SetRolloutDepth(uint32_t depth) {
+    this->rolloutDepth = depth;
+}
+
+void MctsPlayer::SetSeed(uint64_t baseSeed) {
+    this->seed = baseSeed;
+    for (size_t i = 0; i < this->trees.size(); i++) this->trees[i]->rng.seed(baseSeed + i);
+}
+
+void MctsPlayer::SetTableSize(size_t bytes) {
+    this->table.reset(new TranspositionTable(bytes));
+    this->generation = 0;
+}
+
+SnakeTypes::Direction MctsPlayer::Decide(const SnakeGame& game) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    if (!this->pool) {
+        this->pool.reset(new WorkStealingPool(this->threadCount));
+        for (int i = 0; i < this->pool->GetThreadCount(); i++) {
+            this->trees.emplace_back(new Tree{std::vector<Node>(), std::vector<uint32_t>(), std::vector<uint64_t>(), SnakeGame(1, 1, 0), CowSnakeGame(1, 1, 0), GameRng(), 0, 0});
+            this->trees.back()->rng.seed(this->seed + i);
+        }
+    }
+
+    this->root = game;
+    this->forking = this->root.GetGridSizeHorizontal() * this->root.GetGridSizeVertical() >= ForkArea;
+    if (this->forking) {
+        this->snapshot.resize(this->root.GetSnapshotSize());
+        this->cowRoot.RestoreSnapshot(this->snapshot.data(), this->root.SaveSnapshot(this->snapshot.data()));
+    }
+    this->deadline = start + this->budget;
+    this->generation++;
+
+    // Fresh trees, keeping their memory
+    for (size_t i = 0; i < this->trees.size(); i++) {
+        Tree& tree = *this->trees[i];
+        tree.nodes.clear();
+        tree.nodes.push_back({0, 0, {-1, -1, -1, -1}});
+        tree.rollouts = 0;
+        tree.tableHits = 0;
+    }
+
+    for (size_t i = 0; i < this->trees.size(); i++) {
+        this->pool->Submit([this, i]() { this->runSlice(i); });
+    }
+    this->pool->Wait();
+
+    // Most visited direction over every tree
+    uint64_t visits[4] = {0, 0, 0, 0};
+    uint64_t rollouts = 0;
+    uint64_t tableHits = 0;
+    for (size_t i = 0; i < this->trees.size(); i++) {
+        const Node& rootNode = this->trees[i]->nodes[0];
+        for (int d = 0; d < 4; d++) {
+            if (rootNode.children[d] >= 0) visits[d] += this->trees[i]->nodes[rootNode.children[d]].visits;
+        }
+        rollouts += this->trees[i]->rollouts;
+        tableHits += this->trees[i]->tableHits;
+    }
+
+    Direction best = this->root.GetSnakeDirection();
+    uint64_t bestVisits = 0;
+    for (int d = 0; d < 4; d++) {
+        if (visits[d] > bestVisits) {
+            bestVisits = visits[d];
+            best = (Direction)(d + 1);
+        }
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    this->stats.moves++;
+    this->stats.rollouts += rollouts;
+    this->stats.tableHits += tableHits;
+    this->stats.seconds += elapsed.count();
+    this->stats.threads = this->pool->GetThreadCount();
+
+    return best;
+}
+
+MctsPlayer::Stats MctsPlayer::TakeStats() {
+    Stats result = this->stats;
+    this->stats = {0, 0, 0, 0, this->stats.threads};
+    return result;
+}
+
+void MctsPlayer::runSlice(size_t index) {
+    Tree& tree = *this->trees[index];
+
+    // At least one iteration, so every tree has a say even with no budget
+    for (uint32_t i = 0; i < SliceIterations; i++) {
+        if (this->forking) {
+            tree.fork = this->cowRoot.Fork();
+            this->iterate(tree, tree.fork);
+        } else {
+            tree.game = this->root;
+            this->iterate(tree, tree.game);
+        }
+        if (std::chrono::steady_clock::now() >= this->deadline) return;
+    }
+
+    this->pool->Submit([this, index]() { this->runSlice(index); });
+}
+
+template <typename Game>
+void MctsPlayer::iterate(Tree& tree, Game& game) {
+    game.Seed(tree.rng());
+
+    uint16_t startScore = game.GetScore();
+    uint32_t node = 0;
+    tree.path.clear();
+    tree.path.push_back(node);
+    tree.hashes.clear();
+    tree.hashes.push_back(game.GetHash());
+
+    // Selection, down the tree while every direction from the node has been tried
+    while (!game.IsGameOver()) {
+        Direction blocked = opposite(game.GetSnakeDirection());
+        const Node& current = tree.nodes[node];
+
+        int untried = -1;
+        int best = -1;
+        double bestScore = -1;
+        double logVisits = std::log((double)current.visits + 1);
+        for (int d = 0; d < 4; d++) {
+            if ((Direction)(d + 1) == blocked) continue;
+            if (current.children[d] < 0) {
+                untried = d;
+                break;
+            }
+
+            const Node& child = tree.nodes[current.children[d]];
+            double score = child.value / child.visits + MCTS_EXPLORATION * std::sqrt(logVisits / child.visits);
+            if (score > bestScore) {
+                bestScore = score;
+                best = d;
+            }
+        }
+
+        // Expansion, add the first untried direction and roll out from there
+        if (untried >= 0) {
+            game.ChangeDirection((Direction)(untried + 1));
+            game.Tick();
+
+            if (tree.nodes.size() < MaxNodes) {
+                tree.nodes[node].children[untried] = (int32_t)tree.nodes.size();
+                tree.nodes.push_back({0, 0, {-1, -1, -1, -1}});
+                tree.path.push_back((uint32_t)tree.nodes.size() - 1);
+                tree.hashes.push_back(game.GetHash());
+
+                // Start from what's known about the state, if anything got stored for it this decision
+                TranspositionTable::Entry entry;
+                if (this->table->Probe(game.GetHash(), entry) && entry.flags == this->generation) {
+                    Node& added = tree.nodes.back();
+                    added.visits = std::min<uint32_t>(entry.depth, MaxPriorVisits);
+                    added.value = added.visits * std::ldexp((double)entry.value, -MCTS_VALUE_BITS);
+                    tree.tableHits++;
+                }
+            }
+            break;
+        }
+
+        node = (uint32_t)tree.nodes[node].children[best];
+        game.ChangeDirection((Direction)(best + 1));
+        game.Tick();
+        tree.path.push_back(node);
+        tree.hashes.push_back(game.GetHash());
+    }
+
+    // Rollout
+    for (uint32_t i = 0; i < this->rolloutDepth && !game.IsGameOver(); i++) {
+        game.ChangeDirection(this->rolloutDirection(game, tree.rng));
+        game.Tick();
+    }
+
+    // Staying alive is worth half, every fruit eaten halves what's left of the other half
+    int eaten = game.GetScore() - startScore;
+    double reward = (game.IsGameOver() && !game.IsGameWon() ? 0 : 0.5) + 0.5 * (1 - std::ldexp(1.0, -eaten));
+
+    // Backup, sharing the new node's stats, and other nodes' whenever their visits double (storing every node on
+    // every iteration costs a fifth of the rollouts), never the root's, the next decision starts from another root
+    for (size_t i = 0; i < tree.path.size(); i++) {
+        Node& current = tree.nodes[tree.path[i]];
+        current.visits++;
+        current.value += reward;
+        if (i == 0 || (i + 1 < tree.path.size() && (current.visits & (current.visits - 1)) != 0)) continue;
+
+        uint8_t move = 0;
+        uint32_t moveVisits = 0;
+        for (int d = 0; d < 4; d++) {
+            if (current.children[d] >= 0 && tree.nodes[current.children[d]].visits > moveVisits) {
+                moveVisits = tree.nodes[current.children[d]].visits;
+                move = (uint8_t)(d + 1);
+            }
+        }
+
+        int32_t value = (int32_t)std::ldexp(current.value / current.visits, MCTS_VALUE_BITS);
+        uint16_t depth = (uint16_t)std::min<uint32_t>(current.visits, 0xffff);
+        this->table->Store(tree.hashes[i], {value, depth, move, this->generation});
+    }
+
+    tree.rollouts++;
+}
+
+template <typename Game>
+SnakeTypes::Direction MctsPlayer::rolloutDirection(Game& game, GameRng& rng) {
+    int width = (int)game.GetGridSizeHorizontal();
+    int height = (int)game.GetGridSizeVertical();
+    Position head = game.GetSnakeHeadPos();
+    Position fruit = game.GetFruitPos();
+    Direction blocked = opposite(game.GetSnakeDirection());
+
+    // Directions that don't move onto the snake, and which of them get closer to the fruit (around the edges too)
+    Direction safe[4];
+    Direction closer[4];
+    int safeCount = 0;
+    int closerCount = 0;
+    for (int d = 1; d <= 4; d++) {
+        Direction direction = (Direction)d;
+        if (direction == blocked) continue;
+
+        int x = head.x;
+        int y = head.y;
+        if (direction == Direction::Up) y = y == 0 ? height - 1 : y - 1;
+        if (direction == Direction::Down) y = y == height - 1 ? 0 : y + 1;
+        if (direction == Direction::Left) x = x == 0 ? width - 1 : x - 1;
+        if (direction == Direction::Right) x = x == width - 1 ? 0 : x + 1;
+        if (game.GetTile(x, y) == Tile::Snake) continue;
+
+        safe[safeCount++] = direction;
+
+        int dx = std::abs(x - (int)fruit.x);
+        int dy = std::abs(y - (int)fruit.y);
+        int hx = std::abs((int)head.x - (int)fruit.x);
+        int hy = std::abs((int)head.y - (int)fruit.y);
+        if (std::min(dx, width - dx) + std::min(dy, height - dy) < std::min(hx, width - hx) + std::min(hy, height - hy)) {
+            closer[closerCount++] = direction;
+        }
+    }
+
+    // Boxed in, nothing to save
+    if (safeCount == 0) return game.GetSnakeDirection();
+
+    if (closerCount > 0 && (rng() & 1)) return closer[randomBelow(rng, closerCount)];
+    return safe[randomBelow(rng, safeCount)];
+}
@@ -0,0 +1,126 @@
+#ifndef __MCTS_INCLUDED__
+#define __MCTS_INCLUDED__
+
+#include <chrono> // std::chrono::steady_clock
+#include <cstdint> // uint8_t, uint32_t, uint64_t, int32_t
+#include <memory> // std::unique_ptr<T>
+#include <vector> // std::vector<T>
+
+#include "game.h" // SnakeGame, CowSnakeGame
+#include "rng.h" // GameRng
+#include "threadpool.h" // WorkStealingPool
+#include "zobrist.h" // TranspositionTable
+
+// Picks every turn with a Monte Carlo tree search over copies of the game, within a wall-clock budget per move
+//
+// Root-parallel: every thread grows its own tree from the current state, and the trees' visit counts for the
+// four directions are summed to pick the move, so threads never share or lock a tree
+// Trees grow in short slices on a WorkStealingPool, every slice queues the next one until the budget runs out
+//
+// Every iteration copies the game (forks it on big grids, see ForkArea), reseeds the copy's RNG and walks down the tree by UCB1, adds one node, then
+// plays a rollout: safe directions only where there are any, heading for the fruit half the time
+// Reseeding means the search never sees where the game's own RNG will put the next fruit
+//
+// Trees share what they learn through a TranspositionTable keyed by GetHash(): every iteration stores the visits
+// and mean reward of the nodes it went through, and a node added for a state another tree (or another path) already
+// rolled out from starts with those rollouts as a prior
+class MctsPlayer : public SnakeTypes {
+public:
+    // Totals over every Decide() since the last TakeStats()
+    struct Stats {
+        uint64_t moves;
+        uint64_t rollouts;
+        // New nodes seeded from the transposition table
+        uint64_t tableHits;
+        // Wall-clock time spent deciding
+        double seconds;
+        int threads;
+
+        // Rollouts per second of deciding, over all threads
+        double RolloutsPerSecond() const;
+        // Rollouts per second of deciding, per thread
+        double RolloutsPerSecondPerCore() const;
+    };
+
+    MctsPlayer();
+
+    // Set amount of search threads, 0 uses every hardware thread
+    void SetThreadCount(int);
+    // Set wall-clock time a decision may take, e.g. one tick period to decide every tick of a live game
+    void SetMoveBudget(std::chrono::steady_clock::duration);
+    // Set most ticks a rollout plays past the tree
+    void SetRolloutDepth(uint32_t);
+    // Set base seed for reseeding game copies, thread n reseeds from seed + n
+    void SetSeed(uint64_t);
+    // Set size of the transposition table shared by the trees in bytes, emptying it
+    void SetTableSize(size_t);
+
+    // Search from game's current state until the budget runs out, and return the direction to turn to
+    Direction Decide(const SnakeGame&);
+
+    // Return totals since the last call and start over
+    Stats TakeStats();
+
+    // Iterations a slice runs before checking in with the pool
+    static const uint32_t SliceIterations = 32;
+    // Most nodes in one tree, trees stop growing (but keep rolling out) past this
+    static const uint32_t MaxNodes = 1 << 20;
+    // Grid area from which iterations fork a CowSnakeGame instead of copying a SnakeGame (about even at 96x96),
+    // copying costs the whole grid and free tile index, forks only the pages the iteration writes but tick slower
+    static const uint32_t ForkArea = 96 * 96;
+    // Most rollouts a node takes over from the transposition table
+    static const uint32_t MaxPriorVisits = 16;
+
+private:
+    struct Node {
+        uint32_t visits;
+        double value;
+        // Index of the node after turning to each direction (Up, Down, Left, Right), -1 if not added yet
+        int32_t children[4];
+    };
+
+    // One thread's tree, and the scratch space to search it
+    struct Tree {
+        std::vector<Node> nodes;
+        // Nodes visited by the current iteration, and the hash of their states
+        std::vector<uint32_t> path;
+        std::vector<uint64_t> hashes;
+        // Scratch game for the iteration, one or the other depending on grid size
+        SnakeGame game;
+        CowSnakeGame fork;
+        GameRng rng;
+        uint64_t rollouts;
+        uint64_t tableHits;
+    };
+
+    int threadCount;
+    std::chrono::steady_clock::duration budget;
+    uint32_t rolloutDepth;
+    uint64_t seed;
+
+    std::unique_ptr<WorkStealingPool> pool;
+    std::unique_ptr<TranspositionTable> table;
+    // Tags the entries stored by the current decision, rewards count fruit from its root so older entries are ignored
+    uint8_t generation;
+    std::vector<std::unique_ptr<Tree>> trees;
+    // Game being decided on, copied once so trees never read the caller's game, and on big grids moved into a
+    // CowSnakeGame for trees to fork
+    SnakeGame root;
+    std::vector<uint8_t> snapshot;
+    CowSnakeGame cowRoot;
+    bool forking;
+    std::chrono::steady_clock::time_point deadline;
+
+    Stats stats;
+
+    // Grow tree index for a slice, and queue the next slice if there's time left
+    void runSlice(size_t);
+    // One selection, expansion, rollout and backup on a tree, playing in game
+    template <typename Game>
+    void iterate(Tree&, Game&);
+    // Rollout policy's direction for game
+    template <typename Game>
+    Direction rolloutDirection(Game&, GameRng&);
+};
+
+#endif // __MCTS_INCLUDED__
@@ -1,7 +1,9 @@
 #include <string> // std::string
 #include <iostream> // std::cout, std::istream, std::getline
-#include <algorithm> // std::find
-#include <random> // std::mt19937_64, std::uniform_int_distribution, std::random_device
+#include <algorithm> // std::swap, std::sort
+#include <random> // std::random_device
+#include <unordered_set> // std::unordered_set<T>
+#include <stdexcept> // std::invalid_argument
 #include <chrono> // std::chrono::high_resolution_clock, std::chrono::time_point_cast, std::chrono::(nano/micro)seconds
 #include <vector> // std::vector<T>
 
@@ -16,25 +18,14 @@ std::string getString(std::istream& istream, std::string promptMessage) {
     return input;
 }
 
-std::vector<int> getRandomNumbers(int amount, int min, int max, bool unique) {
-    // Return vector
-    std::vector<int> ret;
-
-    // Verify values are valid
-    if (max < min || (unique && max - min < amount)) {
-        throw new std::invalid_argument("Invalid arguments, or too small distribution for requested amount of unique numbers");
-
-        // Return empty vector just in case
-        return ret;
-    }
-
+uint64_t getRandomSeed() {
     // PRNG seed
     uint32_t rdgen = 0;
     try {
         // Get true random number, if supported, for the seed
         std::random_device rd;
         rdgen = rd();
-    } catch (std::exception) {
+    } catch (const std::exception&) {
         // Implementation or device doesn't support random_device, fall back to current timestamp
         std::chrono::high_resolution_clock::time_point curTime = std::chrono::high_resolution_clock::now();
         rdgen = static_cast<uint32_t>(std::chrono::time_point_cast<std::chrono::microseconds>(curTime).time_since_epoch().count());
@@ -45,25 +36,64 @@ std::vector<int> getRandomNumbers(int amount, int min, int max, bool unique) {
     uint32_t time = static_cast<uint32_t>(std::chrono::time_point_cast<std::chrono::nanoseconds>(curTime).time_since_epoch().count());
 
     // OR bit-shifted 32-bit timestamp onto seed, in case random_device fails
-    uint64_t rngSeed = (uint64_t)rdgen << 32 | time;
+    return (uint64_t)rdgen << 32 | time;
+}
+
+// Engine used when the caller doesn't pass one, seeded once per thread instead of on every call
+static GameRng& threadRng() {
+    thread_local GameRng rng(getRandomSeed());
+    return rng;
+}
+
+std::vector<int> getRandomNumbers(int amount, int min, int max, bool unique) {
+    return getRandomNumbers(threadRng(), amount, min, max, unique);
+}
+
+std::vector<int> getRandomNumbers(GameRng& rng, int amount, int min, int max, bool unique) {
+    // Return vector
+    std::vector<int> ret;
+
+    // Verify values are valid
+    if (max < min || (unique && max - min < amount)) {
+        throw std::invalid_argument("Invalid arguments, or too small distribution for requested amount of unique numbers");
+    }
 
-    // Create PRNG engine with seed
-    std::mt19937_64 prng(rngSeed);
+    // Nothing to draw, also keeps negative amounts away from reserve() and the unique loop bounds
+    if (amount <= 0) return ret;
 
-    // Create uniform distribution from PRNG, limits inclusive [min, max]
-    std::uniform_int_distribution<int> dist(min, max); 
+    ret.reserve(amount);
 
-    // Run through generation i times, defined by amount parameter
-    for (int i = 0; i < amount; i++) {
-        // Generate number
-        int gen = dist(prng);
+    // Amount of numbers in range [min, max], wraps to 0 if the range covers every int
+    uint32_t range = (uint32_t)max - (uint32_t)min + 1;
 
-        // If unique is set, only add unique random numbers
-        if (unique && std::find(ret.begin(), ret.end(), gen) != ret.end()) { // if (value is in vector)
-            i--;
-        } else {
-            ret.push_back(gen);
+    if (!unique) {
+        for (int i = 0; i < amount; i++) {
+            uint32_t gen = range == 0 ? (uint32_t)(rng() >> 32) : randomBelow(rng, range);
+            ret.push_back((int)((uint32_t)min + gen));
         }
+
+        return ret;
+    }
+
+    // Floyd's algorithm, every draw picks a new number, so it's O(amount) no matter how full the range gets
+    std::unordered_set<uint32_t> chosen;
+    chosen.reserve(amount);
+
+    for (uint32_t j = range - (uint32_t)amount; j < range; j++) {
+        uint32_t gen = randomBelow(rng, j + 1);
+
+        // If gen was already picked, j can't have been, since earlier draws were all below it
+        if (!chosen.insert(gen).second) {
+            gen = j;
+            chosen.insert(gen);
+        }
+
+        ret.push_back((int)((uint32_t)min + gen));
+    }
+
+    // Floyd's picks come out in a biased order, shuffle them (Fisher-Yates)
+    for (int i = amount - 1; i > 0; i--) {
+        std::swap(ret[i], ret[randomBelow(rng, (uint32_t)i + 1)]);
     }
 
     return ret;
@@ -74,84 +104,69 @@ std::vector<int> getUniqueRandomNumbers(int amount, int min, int max) {
     return getRandomNumbers(amount, min, max, true);
 }
 
+std::vector<int> getUniqueRandomNumbers(GameRng& rng, int amount, int min, int max) {
+    // Run random number gen with unique set
+    return getRandomNumbers(rng, amount, min, max, true);
+}
+
 std::vector<int> sortVectorInt(std::vector<int> vec) {
-    // Very basic and inefficient sort function
+    std::sort(vec.begin(), vec.end());
+    return vec;
+}
 
-    std::vector<int> sorted;
-    int sz = (int)vec.size();
+// Array helpers below are single plain passes, StreamingStats (stats.h) is for streams that need more than one summary
 
-    for (int i = 0; i < sz; i++) {
-        int min = vec[0];
-        int pos = 0;
+// Smallest or largest element, 0 for empty arrays
+template <typename T>
+static T findMin(const T* arr, size_t arrSize) {
+    if (arrSize == 0) return 0;
 
-        for (int ii = 0; ii < sz; ii++) {
-            if (vec[ii] < min) {
-                min = vec[ii];
-                pos = ii;
-            }
-        }
-
-        sorted.push_back(min);
-        vec.erase(vec.begin() + pos);
+    T result = arr[0];
+    for (size_t i = 1; i < arrSize; i++) {
+        if (arr[i] < result) result = arr[i];
     }
 
-    return sorted;
+    return result;
 }
 
-int calcAvgInt(int *arr, size_t arrSize) {
-    if (arrSize <= 0) return 0;
-
-    int total = 0;
+template <typename T>
+static T findMax(const T* arr, size_t arrSize) {
+    if (arrSize == 0) return 0;
 
-    for (int i = 0; i < (int)arrSize; i++) {
-        total += arr[i];
+    T result = arr[0];
+    for (size_t i = 1; i < arrSize; i++) {
+        if (arr[i] > result) result = arr[i];
     }
 
-    return total / (int)arrSize;
+    return result;
 }
 
-int getMaxInt(int *arr, size_t arrSize) {
+int calcAvgInt(int *arr, size_t arrSize) {
     if (arrSize <= 0) return 0;
 
-    int max = arr[0];
-    for (int i = 1; i < (int)arrSize; i++) {
-        max = arr[i] > max ? arr[i] : max;
+    // 64-bit sum can't overflow below 2^32 values, and integer division rounds towards zero
+    int64_t sum = 0;
+    for (size_t i = 0; i < arrSize; i++) {
+        sum += arr[i];
     }
 
-    return max;
+    return (int)(sum / (int64_t)arrSize);
 }
 
-uint16_t getMaxUInt16(uint16_t *arr, size_t arrSize) {
-    if (arrSize <= 0) return 0;
-
-    uint16_t max = arr[0];
-    for (uint16_t i = 1; i < (uint16_t)arrSize; i++) {
-        max = arr[i] > max ? arr[i] : max;
-    }
+int getMaxInt(int *arr, size_t arrSize) {
+    return findMax(arr, arrSize);
+}
 
-    return max;
+uint16_t getMaxUInt16(uint16_t *arr, size_t arrSize) {
+    return findMax(arr, arrSize);
 }
 
 int getMinInt(int *arr, size_t arrSize) {
-    if (arrSize <= 0) return 0;
-
-    int min = arr[0];
-    for (int i = 1; i < (int)arrSize; i++) {
-        min = arr[i] < min ? arr[i] : min;
-    }
-
-    return min;
+    return findMin(arr, arrSize);
 }
 
 uint16_t getMinUInt16(uint16_t *arr, size_t arrSize) {
-    if (arrSize <= 0) return 0;
-
-    uint16_t min = arr[0];
-    for (uint16_t i = 1; i < (uint16_t)arrSize; i++) {
-        min = arr[i] < min ? arr[i] : min;
-    }
-
-    return min;
+    return findMin(arr, arrSize);
 }
 
 void printChar(char c, uint16_t amount) {
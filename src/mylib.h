@@ -1,19 +1,37 @@
 #ifndef __MYLIB_INCLUDED__
 #define __MYLIB_INCLUDED__
 
+#include <iosfwd> // std::istream
+#include <string> // std::string
+#include <vector> // std::vector<T>
+
+#include "rng.h" // GameRng
+
 // Fetch a string from std::istream
 std::string getString(std::istream& istream, std::string promptMessage);
 
+// Get a non-deterministic 64-bit seed from random_device and the current time
+uint64_t getRandomSeed();
+
 // Return n random numbers from range [min, max], either unique or any
+// Throws std::invalid_argument if max < min, or the range has fewer than n unique numbers, n <= 0 returns no numbers
+// Uses an engine owned by the calling thread
 std::vector<int> getRandomNumbers(int amount, int min, int max, bool unique = false);
+// Return n random numbers from range [min, max] drawn from rng, either unique or any
+std::vector<int> getRandomNumbers(GameRng& rng, int amount, int min, int max, bool unique = false);
 // Return n random unique numbers from range [min, max]
 // Alias for getRandomNumbers(amount, min, max, true)
 std::vector<int> getUniqueRandomNumbers(int amount, int min, int max);
+// Return n random unique numbers from range [min, max] drawn from rng
+// Alias for getRandomNumbers(rng, amount, min, max, true)
+std::vector<int> getUniqueRandomNumbers(GameRng& rng, int amount, int min, int max);
 
 // Sort an int vector smallest to largest
 std::vector<int> sortVectorInt(std::vector<int> vec);
 
-// Get average from array of integers
+// Array summaries, 0 for empty arrays
+// For streams of results, or results from several threads, use StreamingStats (stats.h) instead
+// Get average from array of integers, rounded towards zero
 int calcAvgInt(int *arr, size_t arrSize);
 // Get largest number in int array
 int getMaxInt(int *arr, size_t arrSize);
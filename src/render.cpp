@@ -0,0 +1,297 @@
+#include <cstdio> // std::fwrite, std::fflush
+#include <cstring> // std::memcpy
+#include <string> // std::string, std::to_string
+#include <vector> // std::vector<T>
+
+#ifndef _WIN32
+#include <unistd.h> // write(), STDOUT_FILENO
+#include <sys/ioctl.h> // ioctl(), TIOCGWINSZ, winsize
+#include <cerrno> // errno, EINTR
+#endif // _WIN32
+
+#include "render.h" // Class declarations
+
+// Unchanged cells between two changed ones are rewritten instead of moving the cursor,
+// if there are at most this many of them (a cursor move takes 6-10 bytes)
+const int MAX_RUN_GAP = 6;
+
+FrameRenderer::FrameRenderer(int x, int y) {
+    this->columns = x;
+    this->rows = y;
+
+    this->current.assign((size_t)x * y, ' ');
+    // Previous frame starts with characters that are never drawn, so the first frame is sent in full
+    this->previous.assign((size_t)x * y, '\0');
+
+    // Full frame with escape sequences is a rough upper bound
+    this->output.reserve((size_t)x * y * 2);
+
+    this->clearScreen = true;
+}
+
+void FrameRenderer::Clear() {
+    this->current.assign(this->current.size(), ' ');
+}
+
+void FrameRenderer::SetChar(int x, int y, char c) {
+    if (x < 0 || y < 0 || x >= this->columns || y >= this->rows) return;
+
+    this->current[(size_t)y * this->columns + x] = c;
+}
+
+void FrameRenderer::SetText(int x, int y, const std::string& text) {
+    for (size_t i = 0; i < text.size(); i++) {
+        this->SetChar(x + (int)i, y, text[i]);
+    }
+}
+
+const std::string& FrameRenderer::BuildDiff() {
+    this->output.clear();
+
+    if (this->clearScreen) {
+        // Hide cursor, clear terminal
+        this->output += "\x1b[?25l\x1b[2J";
+        this->clearScreen = false;
+    }
+
+    for (int y = 0; y < this->rows; y++) {
+        const char* cur = &this->current[(size_t)y * this->columns];
+        const char* prev = &this->previous[(size_t)y * this->columns];
+
+        int x = 0;
+        while (x < this->columns) {
+            // Skip unchanged cells
+            if (cur[x] == prev[x]) {
+                x++;
+                continue;
+            }
+
+            // Find the end of this run of changes, bridging small unchanged gaps
+            int end = x + 1;
+            int gap = 0;
+            for (int i = end; i < this->columns && gap <= MAX_RUN_GAP; i++) {
+                if (cur[i] != prev[i]) {
+                    end = i + 1;
+                    gap = 0;
+                } else {
+                    gap++;
+                }
+            }
+
+            // Move cursor (1-based row;column), then write the run
+            this->output += "\x1b[";
+            this->output += std::to_string(y + 1);
+            this->output += ';';
+            this->output += std::to_string(x + 1);
+            this->output += 'H';
+            this->output.append(cur + x, end - x);
+
+            x = end;
+        }
+    }
+
+    // Park cursor under the frame, so anything printed after the game doesn't overwrite it
+    if (!this->output.empty()) {
+        this->output += "\x1b[";
+        this->output += std::to_string(this->rows + 1);
+        this->output += ";1H";
+    }
+
+    // Current frame is now on the terminal
+    std::memcpy(this->previous.data(), this->current.data(), this->current.size());
+
+    return this->output;
+}
+
+void FrameRenderer::Present() {
+    this->BuildDiff();
+    this->writeOutput();
+}
+
+void FrameRenderer::Restore() {
+    this->output = "\x1b[" + std::to_string(this->rows + 1) + ";1H\x1b[?25h";
+    this->writeOutput();
+}
+
+void FrameRenderer::writeOutput() {
+    if (this->output.empty()) return;
+
+#ifdef _WIN32
+    // Whole frame in one call to the C runtime
+    std::fwrite(this->output.data(), 1, this->output.size(), stdout);
+    std::fflush(stdout);
+#else // _WIN32
+    // Single write() per frame, only repeated if the terminal accepted part of it
+    size_t written = 0;
+    while (written < this->output.size()) {
+        ssize_t result = write(STDOUT_FILENO, this->output.data() + written, this->output.size() - written);
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        written += (size_t)result;
+    }
+#endif // _WIN32
+}
+
+void FrameRenderer::Invalidate() {
+    this->previous.assign(this->previous.size(), '\0');
+    this->clearScreen = true;
+}
+
+size_t FrameRenderer::GetLastFrameBytes() {
+    return this->output.size();
+}
+
+// Window origin along one axis keeping head in view, see Viewport::Follow()
+static int followAxis(int origin, int head, int size, int board) {
+    if (size >= board) return 0;
+
+    int margin = size / 4;
+    int offset = (head - origin + board) % board;
+
+    if (offset >= size) return ((head - size / 2) % board + board) % board;
+    if (offset < margin) return ((head - margin) % board + board) % board;
+    if (offset > size - 1 - margin) return ((head - (size - 1 - margin)) % board + board) % board;
+    return origin;
+}
+
+Viewport::Viewport() : boardWidth(1), boardHeight(1), width(1), height(1), originX(0), originY(0) {}
+
+void Viewport::Resize(int newBoardWidth, int newBoardHeight, int columns, int rows) {
+    this->boardWidth = newBoardWidth < 1 ? 1 : newBoardWidth;
+    this->boardHeight = newBoardHeight < 1 ? 1 : newBoardHeight;
+    this->width = columns < 1 ? 1 : columns > this->boardWidth ? this->boardWidth : columns;
+    this->height = rows < 1 ? 1 : rows > this->boardHeight ? this->boardHeight : rows;
+
+    // Keep looking at the same place if it's still on the board
+    if (this->width == this->boardWidth || this->originX >= this->boardWidth) this->originX = 0;
+    if (this->height == this->boardHeight || this->originY >= this->boardHeight) this->originY = 0;
+}
+
+void Viewport::Follow(Position head) {
+    this->originX = followAxis(this->originX, head.x, this->width, this->boardWidth);
+    this->originY = followAxis(this->originY, head.y, this->height, this->boardHeight);
+}
+
+int Viewport::GetWidth() const {
+    return this->width;
+}
+
+int Viewport::GetHeight() const {
+    return this->height;
+}
+
+bool Viewport::IsWhole() const {
+    return this->width == this->boardWidth && this->height == this->boardHeight;
+}
+
+int Viewport::TileX(int x) const {
+    int tile = this->originX + x;
+    return tile >= this->boardWidth ? tile - this->boardWidth : tile;
+}
+
+int Viewport::TileY(int y) const {
+    int tile = this->originY + y;
+    return tile >= this->boardHeight ? tile - this->boardHeight : tile;
+}
+
+Minimap::Minimap() : boardWidth(0), boardHeight(0), width(0), height(0) {}
+
+void Minimap::Resize(int newBoardWidth, int newBoardHeight, int columns, int rows) {
+    this->boardWidth = newBoardWidth < 1 ? 1 : newBoardWidth;
+    this->boardHeight = newBoardHeight < 1 ? 1 : newBoardHeight;
+    this->width = columns < 1 ? 1 : columns > this->boardWidth ? this->boardWidth : columns;
+    this->height = rows < 1 ? 1 : rows > this->boardHeight ? this->boardHeight : rows;
+
+    this->snakeCounts.assign((size_t)this->width * this->height, 0);
+    this->fruitCounts.assign((size_t)this->width * this->height, 0);
+}
+
+int Minimap::GetWidth() const {
+    return this->width;
+}
+
+int Minimap::GetHeight() const {
+    return this->height;
+}
+
+char Minimap::GetChar(int x, int y) const {
+    size_t index = (size_t)y * this->width + x;
+    if (this->fruitCounts[index] > 0) return TILE_FRUIT;
+    if (this->snakeCounts[index] == 0) return MINIMAP_EMPTY;
+
+    // Tiles in this block, blocks differ by one tile when the board doesn't divide evenly
+    uint64_t blockWidth = ((uint64_t)(x + 1) * this->boardWidth + this->width - 1) / this->width
+        - ((uint64_t)x * this->boardWidth + this->width - 1) / this->width;
+    uint64_t blockHeight = ((uint64_t)(y + 1) * this->boardHeight + this->height - 1) / this->height
+        - ((uint64_t)y * this->boardHeight + this->height - 1) / this->height;
+
+    return (uint64_t)this->snakeCounts[index] * 2 >= blockWidth * blockHeight ? MINIMAP_SNAKE_DENSE : MINIMAP_SNAKE_SPARSE;
+}
+
+int Minimap::MapX(int x) const {
+    return (int)((uint64_t)x * this->width / this->boardWidth);
+}
+
+int Minimap::MapY(int y) const {
+    return (int)((uint64_t)y * this->height / this->boardHeight);
+}
+
+void Minimap::Update(const TickEvents& events) {
+    // A tick's tiles never overlap: the head can't move onto the tail, and fruit spawns on a tile that was empty
+    if (events.Has(TICK_TAIL_FREED)) this->Change(events.tailFreed.x, events.tailFreed.y, Tile::Snake, Tile::Empty);
+    if (events.Has(TICK_MOVED)) this->Change(events.headTo.x, events.headTo.y, events.Has(TICK_ATE) ? Tile::Fruit : Tile::Empty, Tile::Snake);
+    if (events.Has(TICK_FRUIT_SPAWNED)) this->Change(events.fruitSpawned.x, events.fruitSpawned.y, Tile::Empty, Tile::Fruit);
+}
+
+void Minimap::Change(int x, int y, Tile from, Tile to) {
+    this->count(x, y, from, -1);
+    this->count(x, y, to, 1);
+}
+
+void Minimap::count(int x, int y, Tile tile, int amount) {
+    if (tile == Tile::Empty) return;
+
+    size_t index = (size_t)this->MapY(y) * this->width + this->MapX(x);
+    if (tile == Tile::Snake) this->snakeCounts[index] += amount;
+    if (tile == Tile::Fruit) this->fruitCounts[index] += amount;
+}
+
+bool GetTerminalSize(int& columns, int& rows) {
+#ifdef _WIN32
+    (void)columns;
+    (void)rows;
+    return false;
+#else // _WIN32
+    winsize size;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) != 0 || size.ws_col == 0 || size.ws_row == 0) return false;
+
+    columns = size.ws_col;
+    rows = size.ws_row;
+    return true;
+#endif // _WIN32
+}
+
+void DrawMinimap(FrameRenderer& frame, const Minimap& minimap, int x, int y, SnakeTypes::Position head) {
+    int width = minimap.GetWidth();
+    int height = minimap.GetHeight();
+
+    frame.SetChar(x, y, BORDER_CORNER);
+    frame.SetChar(x + width + 1, y, BORDER_CORNER);
+    frame.SetChar(x, y + height + 1, BORDER_CORNER);
+    frame.SetChar(x + width + 1, y + height + 1, BORDER_CORNER);
+    for (int j = 0; j < width; j++) {
+        frame.SetChar(x + j + 1, y, BORDER_HORIZONTAL);
+        frame.SetChar(x + j + 1, y + height + 1, BORDER_HORIZONTAL);
+    }
+
+    for (int i = 0; i < height; i++) {
+        frame.SetChar(x, y + i + 1, BORDER_VERTICAL);
+        frame.SetChar(x + width + 1, y + i + 1, BORDER_VERTICAL);
+        for (int j = 0; j < width; j++) frame.SetChar(x + j + 1, y + i + 1, minimap.GetChar(j, i));
+    }
+
+    frame.SetChar(x + minimap.MapX(head.x) + 1, y + minimap.MapY(head.y) + 1, MINIMAP_HEAD);
+}
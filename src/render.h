@@ -0,0 +1,229 @@
+#ifndef __RENDER_INCLUDED__
+#define __RENDER_INCLUDED__
+
+#include <cstddef> // size_t
+#include <cstdint> // uint8_t, uint32_t
+#include <string> // std::string
+#include <vector> // std::vector<T>
+
+#include "game.h" // SnakeTypes
+
+// Grid characters
+
+const char TILE_EMPTY = ' ';
+const char TILE_SNAKE = 'S';
+const char TILE_SNAKE_HEAD_LEFT = '<';
+const char TILE_SNAKE_HEAD_UP = '^';
+const char TILE_SNAKE_HEAD_RIGHT = '>';
+const char TILE_SNAKE_HEAD_DOWN = 'V';
+const char TILE_FRUIT = 'o';
+const char BORDER_VERTICAL = '|';
+const char BORDER_HORIZONTAL = '-';
+const char BORDER_CORNER = '+';
+
+// Minimap characters
+const char MINIMAP_EMPTY = '.';
+const char MINIMAP_SNAKE_SPARSE = ':';
+const char MINIMAP_SNAKE_DENSE = '#';
+const char MINIMAP_HEAD = '@';
+
+// END Grid characters
+
+// Character grid for a whole terminal frame
+// Every frame is drawn in full into memory, but only cells that differ from the previous frame
+// are sent to the terminal, as ANSI cursor moves and writes, in a single write()
+class FrameRenderer {
+public:
+    // Frame of columns x rows characters, drawn from the top-left corner of the terminal
+    FrameRenderer(int, int);
+
+    // Fill the frame with spaces
+    void Clear();
+    // Set character at column x, row y (ignored if outside the frame)
+    void SetChar(int x, int y, char c);
+    // Write text starting at column x, row y, clipped to the frame width
+    void SetText(int x, int y, const std::string& text);
+
+    // Build escape sequences for every cell that changed since the last frame, and remember this frame
+    // Returns the built output, which stays valid until the next call
+    const std::string& BuildDiff();
+    // Build diff and send it to standard output with a single write
+    void Present();
+    // Clear the terminal and redraw every cell on the next frame
+    void Invalidate();
+    // Show the cursor again, under the frame, once done drawing
+    void Restore();
+
+    // Bytes of output built for the last frame
+    size_t GetLastFrameBytes();
+
+private:
+    int columns;
+    int rows;
+    // Frame being drawn
+    std::vector<char> current;
+    // Frame currently on the terminal
+    std::vector<char> previous;
+    // Escape sequences for the last frame, reused between frames
+    std::string output;
+    // Clear terminal before the next frame
+    bool clearScreen;
+
+    // Send output to standard output with a single write
+    void writeOutput();
+};
+
+// Window onto a board too big for the terminal, scrolling to keep the snake head in view
+// The board wraps around its edges like the snake does, so the window does too: it starts anywhere, and a window
+// past the right or bottom edge shows the left or top of the board. A board that fits is shown whole, unscrolled
+class Viewport : public SnakeTypes {
+public:
+    Viewport();
+
+    // Board of boardWidth x boardHeight tiles, showing at most columns x rows of them
+    void Resize(int boardWidth, int boardHeight, int columns, int rows);
+    // Scroll just enough to keep the head a quarter of the window away from its edges, or centre on it if it's out of view
+    void Follow(Position head);
+
+    // Tiles shown across and down
+    int GetWidth() const;
+    int GetHeight() const;
+    // Is the whole board shown
+    bool IsWhole() const;
+    // Board column and row shown at column x, row y of the window
+    int TileX(int x) const;
+    int TileY(int y) const;
+
+private:
+    int boardWidth;
+    int boardHeight;
+    int width;
+    int height;
+    // Board tile at the top-left of the window
+    int originX;
+    int originY;
+};
+
+// Downscaled overview of a whole board, every character stands for a block of tiles
+// Only keeps how many snake and fruit tiles every block holds, updated from every tick's events (which say what
+// each changed tile held before), so keeping it current costs as much as the changes and never allocates, and
+// drawing it as much as its size, whatever the board size
+class Minimap : public SnakeTypes {
+public:
+    Minimap();
+
+    // Board of boardWidth x boardHeight tiles, shown as at most columns x rows characters
+    // Forgets what it knew of the board, Rebuild() after
+    void Resize(int boardWidth, int boardHeight, int columns, int rows);
+    // Read the whole board, after resizing or loading another game
+    template <typename Game>
+    void Rebuild(Game&);
+    // Apply what a Tick() did (GetTickEvents()) without reading the board
+    void Update(const TickEvents&);
+    // Tile (x, y) changed from one tile to another
+    void Change(int x, int y, Tile from, Tile to);
+
+    // Characters across and down
+    int GetWidth() const;
+    int GetHeight() const;
+    // Character for column x, row y: fruit, mostly snake, some snake, or empty
+    char GetChar(int x, int y) const;
+    // Column and row standing for board tile (x, y)
+    int MapX(int x) const;
+    int MapY(int y) const;
+
+private:
+    int boardWidth;
+    int boardHeight;
+    int width;
+    int height;
+    // Snake and fruit tiles per character
+    std::vector<uint32_t> snakeCounts;
+    std::vector<uint32_t> fruitCounts;
+
+    // Add or take back tile (x, y) from its character's counts
+    void count(int x, int y, Tile, int amount);
+};
+
+// Columns and rows of the terminal on standard output, returns false if it isn't a terminal
+bool GetTerminalSize(int& columns, int& rows);
+
+// Draw the score line, grid border and the tiles viewport shows into the frame, starting at row y
+// Takes 3 + viewport height rows and 2 + viewport width columns
+template <typename Game>
+void DrawGame(FrameRenderer& frame, Game& game, int y, const Viewport& viewport) {
+    int width = viewport.GetWidth();
+    int height = viewport.GetHeight();
+
+    // Scoreboard
+    frame.SetText(0, y, "Score: " + std::to_string((int)game.GetScore()));
+
+    // Upper and bottom grid borders
+    frame.SetChar(0, y + 1, BORDER_CORNER);
+    frame.SetChar(width + 1, y + 1, BORDER_CORNER);
+    frame.SetChar(0, y + height + 2, BORDER_CORNER);
+    frame.SetChar(width + 1, y + height + 2, BORDER_CORNER);
+    for (int j = 0; j < width; j++) {
+        frame.SetChar(j + 1, y + 1, BORDER_HORIZONTAL);
+        frame.SetChar(j + 1, y + height + 2, BORDER_HORIZONTAL);
+    }
+
+    SnakeTypes::Position headPos = game.GetSnakeHeadPos();
+    SnakeTypes::Direction snakeDir = game.GetSnakeDirection();
+
+    // Print all visible rows
+    for (int i = 0; i < height; i++) {
+        // Leftmost and rightmost grid border
+        frame.SetChar(0, y + i + 2, BORDER_VERTICAL);
+        frame.SetChar(width + 1, y + i + 2, BORDER_VERTICAL);
+
+        int tileY = viewport.TileY(i);
+
+        // Print all visible columns in row i
+        for (int j = 0; j < width; j++) {
+            int tileX = viewport.TileX(j);
+            SnakeTypes::Tile tile = game.GetTile(tileX, tileY);
+            char c = TILE_EMPTY;
+
+            if (tile == SnakeTypes::Tile::Fruit) c = TILE_FRUIT;
+            if (tile == SnakeTypes::Tile::Snake) {
+                c = TILE_SNAKE;
+
+                // If tile is snake head, print directional head tile
+                if (tileY == (int)headPos.y && tileX == (int)headPos.x) {
+                    if (snakeDir == SnakeTypes::Direction::Left) c = TILE_SNAKE_HEAD_LEFT;
+                    if (snakeDir == SnakeTypes::Direction::Up) c = TILE_SNAKE_HEAD_UP;
+                    if (snakeDir == SnakeTypes::Direction::Right) c = TILE_SNAKE_HEAD_RIGHT;
+                    if (snakeDir == SnakeTypes::Direction::Down) c = TILE_SNAKE_HEAD_DOWN;
+                }
+            }
+
+            frame.SetChar(j + 1, y + i + 2, c);
+        }
+    }
+}
+
+// Draw the score line, grid border and every tile of a game into the frame, starting at row y
+// Takes 3 + grid height rows
+template <typename Game>
+void DrawGame(FrameRenderer& frame, Game& game, int y) {
+    Viewport viewport;
+    viewport.Resize(game.GetGridSizeHorizontal(), game.GetGridSizeVertical(), game.GetGridSizeHorizontal(), game.GetGridSizeVertical());
+    DrawGame(frame, game, y, viewport);
+}
+
+// Draw a bordered minimap with its top-left corner at column x, row y, marking the head
+// Takes 2 + minimap width columns and 2 + minimap height rows
+void DrawMinimap(FrameRenderer& frame, const Minimap& minimap, int x, int y, SnakeTypes::Position head);
+
+template <typename Game>
+void Minimap::Rebuild(Game& game) {
+    this->snakeCounts.assign(this->snakeCounts.size(), 0);
+    this->fruitCounts.assign(this->fruitCounts.size(), 0);
+
+    for (int y = 0; y < this->boardHeight; y++) {
+        for (int x = 0; x < this->boardWidth; x++) this->count(x, y, game.GetTile(x, y), 1);
+    }
+}
+
+#endif // __RENDER_INCLUDED__
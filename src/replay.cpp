@@ -0,0 +1,184 @@
+#include <chrono> // std::chrono::steady_clock, std::chrono::duration<T>
+#include <fstream> // std::ofstream, std::ifstream
+#include <iterator> // std::istreambuf_iterator<T>
+
+#include "replay.h" // Class declarations
+
+// File signature and format version
+const char LOG_MAGIC[4] = {'S', 'N', 'K', 'R'};
+const uint8_t LOG_VERSION = 2;
+// Magic, version, padding, width, height, seed
+const size_t LOG_HEADER_SIZE = 24;
+// Magic, version, width, height, padding, seed, with one byte per size
+const uint8_t LOG_VERSION_NARROW = 1;
+const size_t LOG_HEADER_SIZE_NARROW = 16;
+
+// Bits of the state byte after restart and end events
+const uint8_t STATE_OVER = 1;
+const uint8_t STATE_WON = 2;
+
+bool InputLog::WriteFile(const std::string& path) const {
+    std::ofstream file = std::ofstream(path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+
+    uint8_t header[LOG_HEADER_SIZE] = {0};
+    for (int i = 0; i < 4; i++) header[i] = (uint8_t)LOG_MAGIC[i];
+    header[4] = LOG_VERSION;
+    for (int i = 0; i < 4; i++) header[8 + i] = (uint8_t)(this->width >> (8 * i));
+    for (int i = 0; i < 4; i++) header[12 + i] = (uint8_t)(this->height >> (8 * i));
+    for (int i = 0; i < 8; i++) header[16 + i] = (uint8_t)(this->seed >> (8 * i));
+
+    file.write((const char*)header, LOG_HEADER_SIZE);
+    file.write((const char*)this->events.data(), (std::streamsize)this->events.size());
+
+    return (bool)file;
+}
+
+bool InputLog::ReadFile(const std::string& path) {
+    std::ifstream file = std::ifstream(path, std::ios::binary);
+    if (!file) return false;
+
+    std::vector<uint8_t> data = std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (data.size() < LOG_HEADER_SIZE_NARROW) return false;
+
+    for (int i = 0; i < 4; i++) {
+        if (data[i] != (uint8_t)LOG_MAGIC[i]) return false;
+    }
+
+    size_t headerSize;
+    size_t seedOffset;
+    if (data[4] == LOG_VERSION && data.size() >= LOG_HEADER_SIZE) {
+        this->width = 0;
+        this->height = 0;
+        for (int i = 0; i < 4; i++) this->width |= (uint32_t)data[8 + i] << (8 * i);
+        for (int i = 0; i < 4; i++) this->height |= (uint32_t)data[12 + i] << (8 * i);
+        headerSize = LOG_HEADER_SIZE;
+        seedOffset = 16;
+    } else if (data[4] == LOG_VERSION_NARROW) {
+        this->width = data[5];
+        this->height = data[6];
+        headerSize = LOG_HEADER_SIZE_NARROW;
+        seedOffset = 8;
+    } else {
+        return false;
+    }
+
+    this->seed = 0;
+    for (int i = 0; i < 8; i++) this->seed |= (uint64_t)data[seedOffset + i] << (8 * i);
+    this->events.assign(data.begin() + headerSize, data.end());
+
+    return true;
+}
+
+InputRecorder::InputRecorder(int width, int height, uint64_t seed) {
+    this->log.width = (uint32_t)width;
+    this->log.height = (uint32_t)height;
+    this->log.seed = seed;
+    this->pendingTicks = 0;
+}
+
+void InputRecorder::RecordTick() {
+    this->pendingTicks++;
+}
+
+void InputRecorder::RecordDirection(SnakeTypes::Direction dir) {
+    this->writeEvent((uint8_t)dir);
+}
+
+const InputLog& InputRecorder::GetLog() {
+    return this->log;
+}
+
+void InputRecorder::writeEvent(uint8_t event) {
+    // Tick count as a varint, 7 bits per byte with the high bit set on every byte but the last
+    // A turn within 127 ticks of the previous event takes 2 bytes in total
+    uint64_t ticks = this->pendingTicks;
+    while (ticks >= 0x80) {
+        this->log.events.push_back((uint8_t)(ticks | 0x80));
+        ticks >>= 7;
+    }
+    this->log.events.push_back((uint8_t)ticks);
+    this->log.events.push_back(event);
+
+    this->pendingTicks = 0;
+}
+
+void InputRecorder::recordGameEnd(uint8_t event, uint16_t score, bool over, bool won) {
+    this->writeEvent(event);
+    this->log.events.push_back((uint8_t)score);
+    this->log.events.push_back((uint8_t)(score >> 8));
+    this->log.events.push_back((uint8_t)((over ? STATE_OVER : 0) | (won ? STATE_WON : 0)));
+}
+
+double ReplayResult::TicksPerSecond() const {
+    return this->seconds > 0 ? (double)this->ticks / this->seconds : 0;
+}
+
+ReplayResult ReplayInputLog(const InputLog& log) {
+    ReplayResult result = {false, 0, 0, 0, 0, false, false, 0};
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    SnakeGame game = SnakeGame((int)log.width, (int)log.height, log.seed);
+
+    const uint8_t* pos = log.events.data();
+    const uint8_t* end = pos + log.events.size();
+
+    while (pos < end) {
+        // Ticks before the event
+        uint64_t ticks = 0;
+        int shift = 0;
+        while (pos < end && (*pos & 0x80) && shift < 63) {
+            ticks |= (uint64_t)(*pos & 0x7f) << shift;
+            shift += 7;
+            pos++;
+        }
+        if (pos >= end) break;
+        ticks |= (uint64_t)*pos++ << shift;
+
+        // Ticks after game over don't do anything, skip them
+        for (uint64_t i = 0; i < ticks && !game.IsGameOver(); i++) {
+            game.Tick();
+            result.ticks++;
+        }
+
+        if (pos >= end) break;
+        uint8_t event = *pos++;
+
+        if (event >= 1 && event <= 4) {
+            game.ChangeDirection((SnakeGame::Direction)event);
+            continue;
+        }
+
+        if (event != InputRecorder::EVENT_RESTART && event != InputRecorder::EVENT_END) break;
+
+        // Check the game that just ended against the recording
+        if (end - pos < 3) break;
+        uint16_t score = (uint16_t)(pos[0] | pos[1] << 8);
+        uint8_t state = pos[2];
+        pos += 3;
+
+        result.games++;
+        bool over = (state & STATE_OVER) != 0;
+        bool won = (state & STATE_WON) != 0;
+        if (game.GetScore() != score || game.IsGameOver() != over || game.IsGameWon() != won) {
+            result.mismatches++;
+        }
+
+        if (event == InputRecorder::EVENT_END) {
+            result.valid = true;
+            break;
+        }
+
+        game.Reset();
+    }
+
+    result.score = game.GetScore();
+    result.gameOver = game.IsGameOver();
+    result.gameWon = game.IsGameWon();
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    result.seconds = elapsed.count();
+
+    return result;
+}
@@ -0,0 +1,95 @@
+#ifndef __REPLAY_INCLUDED__
+#define __REPLAY_INCLUDED__
+
+#include <cstdint> // uint8_t, uint16_t, uint32_t, uint64_t
+#include <string> // std::string
+#include <vector> // std::vector<T>
+
+#include "game.h" // SnakeTypes
+
+// Everything needed to play a session again: grid size, RNG seed, and every input with the tick it happened on
+//
+// File format, little-endian:
+//   header: "SNKR", version (1 byte, 2), 0, 0, 0, width (4 bytes), height (4 bytes), seed (8 bytes)
+//     (version 1 logs, from before grids could be wider than 255, are still read:
+//      "SNKR", 1, width (1 byte), height (1 byte), 0, seed (8 bytes))
+//   events: ticks since the previous event (LEB128 varint), then an event byte
+//     1-4: ChangeDirection(), same values as SnakeTypes::Direction
+//     5: game restarted, 6: end of log, both followed by the score (2 bytes) and state (1 byte, 1 = over, 2 = won)
+//        of the game that just ended, so replays can be checked against them
+struct InputLog {
+    uint32_t width;
+    uint32_t height;
+    uint64_t seed;
+    // Encoded events, after the header
+    std::vector<uint8_t> events;
+
+    // Write header and events to a file, returns false if it can't be written
+    bool WriteFile(const std::string& path) const;
+    // Read a log written by WriteFile(), returns false if the file can't be read or isn't a log
+    bool ReadFile(const std::string& path);
+};
+
+// Builds an InputLog while a game is played
+// Only direction changes that took effect are logged, so held keys don't grow the log
+class InputRecorder {
+public:
+    // Log for a game of width x height, seeded with seed
+    InputRecorder(int width, int height, uint64_t seed);
+
+    // Count one call to Tick()
+    void RecordTick();
+    // Log a call to ChangeDirection() that changed the snake's direction
+    void RecordDirection(SnakeTypes::Direction);
+    // Log the end of the current game, call right before Reset()
+    template <typename Game>
+    void RecordRestart(Game& game) {
+        this->recordGameEnd(EVENT_RESTART, game.GetScore(), game.IsGameOver(), game.IsGameWon());
+    }
+    // Log the end of the session, nothing can be recorded after this
+    template <typename Game>
+    void Finish(Game& game) {
+        this->recordGameEnd(EVENT_END, game.GetScore(), game.IsGameOver(), game.IsGameWon());
+    }
+
+    // Log recorded so far
+    const InputLog& GetLog();
+
+    // Event bytes
+    static const uint8_t EVENT_RESTART = 5;
+    static const uint8_t EVENT_END = 6;
+
+private:
+    InputLog log;
+    // Ticks since the last logged event
+    uint64_t pendingTicks;
+
+    // Append pending tick count and an event byte
+    void writeEvent(uint8_t);
+    // Append a restart or end event, with the state of the game that ended
+    void recordGameEnd(uint8_t, uint16_t, bool, bool);
+};
+
+// Totals from replaying a log
+struct ReplayResult {
+    // Log decoded all the way to its end event
+    bool valid;
+    uint64_t ticks;
+    // Games in the log, every restart plus the last one
+    uint32_t games;
+    // Games whose score or over/won state differed from what was recorded
+    uint32_t mismatches;
+    // State of the last game
+    uint16_t score;
+    bool gameOver;
+    bool gameWon;
+    double seconds;
+
+    // Game ticks per wall-clock second
+    double TicksPerSecond() const;
+};
+
+// Feed a log back into a fresh SnakeGame as fast as possible, no rendering or frame pacing
+ReplayResult ReplayInputLog(const InputLog&);
+
+#endif // __REPLAY_INCLUDED__
@@ -0,0 +1,114 @@
+#ifndef __RINGBUFFER_INCLUDED__
+#define __RINGBUFFER_INCLUDED__
+
+#include <cstddef> // size_t
+#include <utility> // std::move
+#include <vector> // std::vector<T>
+
+// Fixed-capacity circular buffer, pushing to the back and popping from the front are both constant time
+// Storage is only allocated by Reset(), or as the buffer grows if Reset() was asked not to preallocate
+// Pushing into a buffer already holding Capacity() elements is not checked
+// Storage can be any container with std::vector's resize/clear/size/operator[]
+template <typename T, typename Storage = std::vector<T>>
+class RingBuffer {
+public:
+    RingBuffer() : limit(0), first(0), count(0) {}
+
+    // Empty the buffer, and make room for n elements (only reallocates if capacity changes)
+    // Without preallocate, storage starts small and doubles whenever a push finds it full, up to n elements
+    void Reset(size_t capacity, bool preallocate = true) {
+        size_t initial = preallocate || capacity < MIN_STORAGE ? capacity : MIN_STORAGE;
+
+        if (this->buffer.size() != initial) {
+            this->buffer.clear();
+            this->buffer.resize(initial);
+            this->buffer.shrink_to_fit();
+        }
+
+        this->limit = capacity;
+        this->first = 0;
+        this->count = 0;
+    }
+
+    // Amount of stored elements
+    size_t Size() const {
+        return this->count;
+    }
+
+    // Maximum amount of stored elements
+    size_t Capacity() const {
+        return this->limit;
+    }
+
+    bool Empty() const {
+        return this->count == 0;
+    }
+
+    // Oldest element
+    // Elements are only written by PushBack(), reads never go through the storage's non-const accessors, so
+    // storage that copies on write (CowArray) isn't copied by reading
+    const T& Front() const {
+        return this->buffer[this->first];
+    }
+
+    // Newest element
+    const T& Back() const {
+        return (*this)[this->count - 1];
+    }
+
+    // Element i, counted from the oldest element
+    const T& operator[](size_t i) const {
+        size_t pos = this->first + i;
+        if (pos >= this->buffer.size()) pos -= this->buffer.size();
+
+        return this->buffer[pos];
+    }
+
+    // Add new element after the newest one
+    void PushBack(const T& value) {
+        if (this->count == this->buffer.size()) this->grow();
+
+        size_t pos = this->first + this->count;
+        if (pos >= this->buffer.size()) pos -= this->buffer.size();
+
+        this->buffer[pos] = value;
+        this->count++;
+    }
+
+    // Remove oldest element
+    void PopFront() {
+        this->first++;
+        if (this->first == this->buffer.size()) this->first = 0;
+
+        this->count--;
+    }
+
+private:
+    // Smallest storage of a buffer that grows
+    static const size_t MIN_STORAGE = 64;
+
+    // Backing storage, holds every element up to limit, or as many as fit so far for buffers that grow
+    Storage buffer;
+    // Maximum amount of stored elements
+    size_t limit;
+    // Index of the oldest element
+    size_t first;
+    // Amount of stored elements
+    size_t count;
+
+    // Double the storage (up to limit), oldest element moves to the start
+    void grow() {
+        size_t size = this->buffer.size() * 2;
+        if (size > this->limit) size = this->limit;
+        if (size <= this->buffer.size()) return;
+
+        Storage grown;
+        grown.resize(size);
+        for (size_t i = 0; i < this->count; i++) grown[i] = (*this)[i];
+
+        this->buffer = std::move(grown);
+        this->first = 0;
+    }
+};
+
+#endif // __RINGBUFFER_INCLUDED__
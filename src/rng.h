@@ -0,0 +1,91 @@
+#ifndef __RNG_INCLUDED__
+#define __RNG_INCLUDED__
+
+#include <cstdint> // uint64_t
+
+#ifdef SNAKE_RNG_MT19937
+#include <random> // std::mt19937_64
+#endif // SNAKE_RNG_MT19937
+
+// xoshiro256** by Blackman & Vigna, small and fast 64-bit PRNG with 256 bits of state
+// Usable anywhere a standard UniformRandomBitGenerator is expected
+class Xoshiro256 {
+public:
+    typedef uint64_t result_type;
+
+    Xoshiro256() {
+        seed(0);
+    }
+
+    explicit Xoshiro256(uint64_t value) {
+        seed(value);
+    }
+
+    // Expand a 64-bit seed into the full state with splitmix64, as recommended by the authors
+    void seed(uint64_t value) {
+        for (int i = 0; i < 4; i++) {
+            value += 0x9E3779B97F4A7C15ULL;
+            uint64_t z = value;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            this->state[i] = z ^ (z >> 31);
+        }
+    }
+
+    static constexpr result_type min() {
+        return 0;
+    }
+
+    static constexpr result_type max() {
+        return ~(result_type)0;
+    }
+
+    result_type operator()() {
+        uint64_t result = rotl(this->state[1] * 5, 7) * 9;
+        uint64_t t = this->state[1] << 17;
+
+        this->state[2] ^= this->state[0];
+        this->state[3] ^= this->state[1];
+        this->state[1] ^= this->state[2];
+        this->state[0] ^= this->state[3];
+
+        this->state[2] ^= t;
+        this->state[3] = rotl(this->state[3], 45);
+
+        return result;
+    }
+
+private:
+    uint64_t state[4];
+
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+};
+
+// Engine owned by every game, build with -DSNAKE_RNG_MT19937 to use the standard Mersenne Twister instead
+#ifdef SNAKE_RNG_MT19937
+typedef std::mt19937_64 GameRng;
+#else // SNAKE_RNG_MT19937
+typedef Xoshiro256 GameRng;
+#endif // SNAKE_RNG_MT19937
+
+// Uniform random number from range [0, bound), bound must be above 0
+// Lemire's multiply-and-shift method, only divides when the rare biased case is hit
+template <typename Engine>
+uint32_t randomBelow(Engine& engine, uint32_t bound) {
+    uint64_t m = (uint64_t)(uint32_t)(engine() >> 32) * bound;
+    uint32_t low = (uint32_t)m;
+
+    if (low < bound) {
+        uint32_t threshold = (uint32_t)(-bound) % bound;
+        while (low < threshold) {
+            m = (uint64_t)(uint32_t)(engine() >> 32) * bound;
+            low = (uint32_t)m;
+        }
+    }
+
+    return (uint32_t)(m >> 32);
+}
+
+#endif // __RNG_INCLUDED__
@@ -0,0 +1,141 @@
+#include <atomic> // std::atomic<T>
+#include <chrono> // std::chrono::steady_clock, std::chrono::duration<T>
+#include <thread> // std::thread
+#include <vector> // std::vector<T>
+
+#include "mylib.h" // getRandomSeed()
+#include "autopilot.h" // Autopilot
+#include "runner.h" // Class declaration
+
+double BatchRunner::Result::GamesPerSecond() const {
+    return this->seconds > 0 ? (double)this->games / this->seconds : 0;
+}
+
+double BatchRunner::Result::TicksPerSecond() const {
+    return this->seconds > 0 ? (double)this->ticks / this->seconds : 0;
+}
+
+BatchRunner::BatchRunner(int x, int y) {
+    this->gridSizeHorizontal = x;
+    this->gridSizeVertical = y;
+    this->threadCount = 0;
+    this->maxTicksPerGame = 100000;
+    this->seed = getRandomSeed();
+
+    // Default to a policy that turns every now and then
+    this->inputPolicy = RandomInputPolicy(10);
+}
+
+void BatchRunner::SetThreadCount(int threads) {
+    this->threadCount = threads < 0 ? 0 : threads;
+}
+
+void BatchRunner::SetMaxTicksPerGame(uint32_t ticks) {
+    this->maxTicksPerGame = ticks;
+}
+
+void BatchRunner::SetInputPolicy(InputPolicy policy) {
+    this->inputPolicy = policy;
+}
+
+void BatchRunner::SetSeed(uint64_t baseSeed) {
+    this->seed = baseSeed;
+}
+
+BatchRunner::Result BatchRunner::Run(uint64_t games) {
+    // Resolve thread count, hardware_concurrency may return 0 if unknown
+    int threads = this->threadCount;
+    if (threads == 0) threads = (int)std::thread::hardware_concurrency();
+    if (threads <= 0) threads = 1;
+
+    // Index of next unplayed game, shared by every worker
+    std::atomic<uint64_t> nextGame(0);
+
+    // Per-worker totals, written once per worker and summed after joining
+    std::vector<Result> workerTotals(threads, Result{0, 0, 0, 1, 0, StreamingStats(), StreamingStats()});
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([this, games, t, &nextGame, &workerTotals]() {
+            // Thread-local copy of the policy
+            InputPolicy policy = this->inputPolicy;
+
+            // One game instance per worker, reset between games
+            SnakeGame game(this->gridSizeHorizontal, this->gridSizeVertical);
+
+            // Count locally, so workers don't share cache lines while playing
+            Result totals = {0, 0, 0, 1, 0, StreamingStats(), StreamingStats()};
+
+            uint64_t gameIndex;
+            while ((gameIndex = nextGame.fetch_add(1, std::memory_order_relaxed)) < games) {
+                game.Seed(this->seed + gameIndex);
+                game.Reset();
+
+                uint32_t tick = 0;
+                while (!game.IsGameOver() && tick < this->maxTicksPerGame) {
+                    game.ChangeDirection(policy(game, tick));
+                    game.Tick();
+                    tick++;
+                }
+
+                totals.games++;
+                totals.ticks += tick;
+                totals.totalScore += game.GetScore();
+                totals.scores.Add(game.GetScore());
+                totals.gameTicks.Add(tick);
+            }
+
+            workerTotals[t] = totals;
+        });
+    }
+
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    // Sum worker totals
+    Result result = {0, 0, 0, threads, elapsed.count(), StreamingStats(), StreamingStats()};
+    for (size_t i = 0; i < workerTotals.size(); i++) {
+        result.games += workerTotals[i].games;
+        result.ticks += workerTotals[i].ticks;
+        result.totalScore += workerTotals[i].totalScore;
+        result.scores.Merge(workerTotals[i].scores);
+        result.gameTicks.Merge(workerTotals[i].gameTicks);
+    }
+
+    return result;
+}
+
+BatchRunner::InputPolicy RandomInputPolicy(int turnChance) {
+    // Every thread's copy gets its own engine
+    GameRng prng;
+
+    return [turnChance, prng](SnakeGame& game, uint32_t tick) mutable {
+        // Derive inputs from the game seed, but don't replay the same numbers the game draws
+        if (tick == 0) prng.seed(~game.GetSeed());
+
+        // Keep going straight, unless the snake hasn't started moving yet
+        if (game.GetSnakeDirection() != SnakeGame::Direction::None && (int)randomBelow(prng, 100) >= turnChance) {
+            return game.GetSnakeDirection();
+        }
+
+        return (SnakeGame::Direction)(randomBelow(prng, 4) + 1);
+    };
+}
+
+BatchRunner::InputPolicy AutopilotInputPolicy(uint32_t budget) {
+    // Every thread's copy gets its own distance field
+    Autopilot autopilot;
+    autopilot.SetBudget(budget);
+
+    return [autopilot](SnakeGame& game, uint32_t tick) mutable {
+        // New game, the field from the last one is no use
+        if (tick == 0) autopilot.Invalidate();
+
+        return autopilot.Decide(game);
+    };
+}
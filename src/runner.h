@@ -0,0 +1,70 @@
+#ifndef __RUNNER_INCLUDED__
+#define __RUNNER_INCLUDED__
+
+#include <cstdint> // uint32_t, uint64_t
+#include <functional> // std::function<T>
+
+#include "game.h" // SnakeGame
+#include "stats.h" // StreamingStats
+
+// Runs many independent games without rendering or frame pacing, spread over worker threads
+class BatchRunner {
+public:
+    // Picks the direction for the next tick, called once before every Tick()
+    // Every worker thread gets its own copy, so state captured by value is never shared between threads
+    typedef std::function<SnakeGame::Direction(SnakeGame&, uint32_t tick)> InputPolicy;
+
+    // Totals from a single Run() call
+    struct Result {
+        uint64_t games;
+        uint64_t ticks;
+        uint64_t totalScore;
+        int threads;
+        double seconds;
+        // Final score and ticks played of every game
+        StreamingStats scores;
+        StreamingStats gameTicks;
+
+        // Finished games per wall-clock second
+        double GamesPerSecond() const;
+        // Game ticks per wall-clock second, over all threads
+        double TicksPerSecond() const;
+    };
+
+    // Games use a variable-size rectangle (see SnakeTypes::ClampGridSize())
+    BatchRunner(int, int);
+
+    // Set amount of worker threads, 0 uses every hardware thread
+    void SetThreadCount(int);
+    // Set tick limit for a single game, so policies that never die can't stall a run
+    void SetMaxTicksPerGame(uint32_t);
+    // Set input policy used by every game
+    void SetInputPolicy(InputPolicy);
+    // Set base RNG seed, game n of a run is seeded with seed + n, so runs are reproducible
+    void SetSeed(uint64_t);
+
+    // Play n games to completion and return totals
+    Result Run(uint64_t);
+
+private:
+    // Grid size for every game
+    int gridSizeHorizontal;
+    int gridSizeVertical;
+    // Worker thread count, 0 = hardware concurrency
+    int threadCount;
+    // Tick limit per game
+    uint32_t maxTicksPerGame;
+    // Policy copied into every worker
+    InputPolicy inputPolicy;
+    // Base seed for games
+    uint64_t seed;
+};
+
+// Turns to a random direction with the given chance (0-100) on every tick
+// Reseeded from the game's seed at tick 0, so seeded games play out the same every time
+BatchRunner::InputPolicy RandomInputPolicy(int turnChance);
+
+// Steers towards the fruit with an Autopilot, visiting at most budget tiles per decision
+BatchRunner::InputPolicy AutopilotInputPolicy(uint32_t budget);
+
+#endif // __RUNNER_INCLUDED__
@@ -0,0 +1,129 @@
+#include <chrono> // std::chrono::duration<T>, std::chrono::duration_cast
+#include <ctime> // std::clock, CLOCKS_PER_SEC
+#include <thread> // std::this_thread::sleep_until
+
+#ifdef _WIN32
+#include <Windows.h> // GetProcessTimes()
+#endif // _WIN32
+
+#include "scheduler.h" // Class declaration
+
+// CPU time used by every thread of the process so far, in seconds
+static double processCpuSeconds() {
+#ifdef _WIN32
+    // std::clock() measures wall time on Windows, ask for kernel + user time instead
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) return 0;
+
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+
+    // FILETIME counts 100 ns intervals
+    return (double)(k.QuadPart + u.QuadPart) / 10000000.0;
+#else // _WIN32
+    return (double)std::clock() / CLOCKS_PER_SEC;
+#endif // _WIN32
+}
+
+// Convert a rate in Hz to a clock period
+static FixedStepScheduler::Clock::duration periodFromRate(double rate) {
+    if (rate <= 0) rate = 1;
+
+    return std::chrono::duration_cast<FixedStepScheduler::Clock::duration>(std::chrono::duration<double>(1.0 / rate));
+}
+
+FixedStepScheduler::FixedStepScheduler(double tickRate, double renderRate) {
+    this->tickPeriod = periodFromRate(tickRate);
+    this->renderPeriod = periodFromRate(renderRate);
+
+    Clock::time_point now = Clock::now();
+    this->nextTick = now + this->tickPeriod;
+    this->nextRender = now;
+    this->missedDeadlines = 0;
+
+    this->cpuWindowStart = now;
+    this->cpuWindowCpuSeconds = processCpuSeconds();
+
+    this->renderWindowStart = now;
+    this->renderWindowCount = 0;
+}
+
+void FixedStepScheduler::WaitForNext() {
+    Clock::time_point deadline = this->nextTick < this->nextRender ? this->nextTick : this->nextRender;
+
+    // Returns immediately if the deadline already passed
+    std::this_thread::sleep_until(deadline);
+}
+
+int FixedStepScheduler::TakeDueTicks() {
+    Clock::time_point now = Clock::now();
+    if (now < this->nextTick) return 0;
+
+    // Whole tick periods since the deadline, plus the tick that was due
+    int64_t due = (now - this->nextTick) / this->tickPeriod + 1;
+
+    // Every tick past the first one is running late by at least a full period
+    this->missedDeadlines += (uint64_t)(due - 1);
+
+    if (due > MaxCatchUpTicks) {
+        // Too far behind, drop the rest and start counting from now
+        this->nextTick = now + this->tickPeriod;
+        return MaxCatchUpTicks;
+    }
+
+    this->nextTick += this->tickPeriod * due;
+    return (int)due;
+}
+
+bool FixedStepScheduler::TakeRenderDue() {
+    Clock::time_point now = Clock::now();
+    if (now < this->nextRender) return false;
+
+    // Renders aren't caught up on, just schedule the next one a period from the last deadline (or now, if far behind)
+    this->nextRender += this->renderPeriod;
+    if (this->nextRender < now) this->nextRender = now + this->renderPeriod;
+
+    this->renderWindowCount++;
+    return true;
+}
+
+void FixedStepScheduler::SetTickRate(double rate) {
+    this->nextTick -= this->tickPeriod;
+    this->tickPeriod = periodFromRate(rate);
+    this->nextTick += this->tickPeriod;
+}
+
+void FixedStepScheduler::SetRenderRate(double rate) {
+    this->renderPeriod = periodFromRate(rate);
+}
+
+uint64_t FixedStepScheduler::GetMissedDeadlines() {
+    return this->missedDeadlines;
+}
+
+double FixedStepScheduler::GetCpuUsage() {
+    Clock::time_point now = Clock::now();
+    double cpuNow = processCpuSeconds();
+
+    double wall = std::chrono::duration<double>(now - this->cpuWindowStart).count();
+    double cpu = cpuNow - this->cpuWindowCpuSeconds;
+
+    this->cpuWindowStart = now;
+    this->cpuWindowCpuSeconds = cpuNow;
+
+    return wall > 0 ? cpu / wall : 0;
+}
+
+double FixedStepScheduler::GetRenderRate() {
+    Clock::time_point now = Clock::now();
+    double wall = std::chrono::duration<double>(now - this->renderWindowStart).count();
+    double rate = wall > 0 ? (double)this->renderWindowCount / wall : 0;
+
+    this->renderWindowStart = now;
+    this->renderWindowCount = 0;
+
+    return rate;
+}
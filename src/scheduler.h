@@ -0,0 +1,56 @@
+#ifndef __SCHEDULER_INCLUDED__
+#define __SCHEDULER_INCLUDED__
+
+#include <chrono> // std::chrono::steady_clock
+#include <cstdint> // uint64_t
+
+// Fixed-timestep loop timing
+// Ticks run at a fixed rate, renders at an independent capped rate, and the thread sleeps in between
+// instead of spinning, so an idle game uses next to no CPU
+class FixedStepScheduler {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // Ticks per second, and maximum renders per second
+    FixedStepScheduler(double, double);
+
+    // Sleep until the next tick or render is due
+    void WaitForNext();
+    // Returns how many ticks are due now, and moves the tick deadline past them
+    // Falls behind by at most MaxCatchUpTicks, anything more is dropped and counted as missed
+    int TakeDueTicks();
+    // Returns true (once) if a render is due now
+    bool TakeRenderDue();
+
+    // Set tick rate (ticks per second), takes effect from the next tick
+    void SetTickRate(double);
+    // Set maximum render rate (renders per second)
+    void SetRenderRate(double);
+
+    // Ticks that ran late by a whole tick period or more, since construction
+    uint64_t GetMissedDeadlines();
+    // Process CPU time divided by wall time since the previous call, 1.0 = one core fully busy
+    double GetCpuUsage();
+    // Renders per second since the previous call to this
+    double GetRenderRate();
+
+    // Most ticks run back to back after falling behind
+    static const int MaxCatchUpTicks = 5;
+
+private:
+    Clock::duration tickPeriod;
+    Clock::duration renderPeriod;
+    Clock::time_point nextTick;
+    Clock::time_point nextRender;
+    uint64_t missedDeadlines;
+
+    // CPU usage measurement window
+    Clock::time_point cpuWindowStart;
+    double cpuWindowCpuSeconds;
+
+    // Render rate measurement window
+    Clock::time_point renderWindowStart;
+    uint64_t renderWindowCount;
+};
+
+#endif // __SCHEDULER_INCLUDED__
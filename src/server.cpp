@@ -0,0 +1,669 @@
+#ifdef __linux__
+#include <atomic> // std::atomic<T>
+#include <cerrno> // errno, EINTR, EAGAIN, EWOULDBLOCK
+#include <chrono> // std::chrono::steady_clock, std::chrono::nanoseconds
+#include <cstring> // std::memcpy
+#include <mutex> // std::mutex, std::lock_guard<T>
+#include <string> // std::string, std::stoi
+#include <thread> // std::thread
+#include <vector> // std::vector<T>
+
+#include <arpa/inet.h> // htons(), htonl()
+#include <fcntl.h> // fcntl(), F_GETFL, F_SETFL, O_NONBLOCK
+#include <netinet/in.h> // sockaddr_in, INADDR_LOOPBACK, IPPROTO_TCP
+#include <netinet/tcp.h> // TCP_NODELAY
+#include <pthread.h> // pthread_setaffinity_np()
+#include <sched.h> // cpu_set_t, CPU_ZERO, CPU_SET
+#include <sys/epoll.h> // epoll_create1(), epoll_ctl(), epoll_wait(), EPOLLEXCLUSIVE
+#include <sys/eventfd.h> // eventfd()
+#include <sys/socket.h> // socket(), bind(), listen(), accept4(), connect(), recv()
+#include <sys/stat.h> // lstat(), S_ISSOCK
+#include <sys/un.h> // sockaddr_un
+#include <unistd.h> // read(), write(), close(), unlink()
+
+#include "mylib.h" // getRandomSeed(), randomBelow()
+#include "game.h" // SnakeGame
+#include "rng.h" // GameRng
+#include "spectator.h" // SpectatorFrame, FrameQueue, AppendSpectatorKeyframe(), AppendSpectatorDelta()
+#include "timerwheel.h" // TimerWheel
+
+#include "server.h" // Class declarations
+
+// Most bytes queued for one client before its deltas get dropped for a keyframe
+const size_t SERVER_MAX_BACKLOG = 64 * 1024;
+// Events handled per epoll_wait()
+const int SERVER_MAX_EVENTS = 256;
+// Connections one loop accepts per wake-up, leaving the rest to wake other loops
+const int SERVER_ACCEPT_BATCH = 4;
+// How often loops hand their totals over to TakeReport()
+const int64_t SERVER_STATS_INTERVAL_NS = 100000000;
+// Timer wheel resolution
+const int64_t SERVER_WHEEL_NS = 1000000;
+
+// epoll user data of the listening and wake-up descriptors, sessions use (generation << 32) | index
+const uint64_t EVENT_LISTENER = 0xffffffff;
+const uint64_t EVENT_WAKE = 0xfffffffe;
+
+typedef std::chrono::steady_clock Clock;
+
+// Is the address a TCP port
+static bool isPort(const std::string& address) {
+    if (address.empty() || address.size() > 5) return false;
+    for (size_t i = 0; i < address.size(); i++) {
+        if (address[i] < '0' || address[i] > '9') return false;
+    }
+    return std::stoi(address) <= 65535;
+}
+
+// Fill in the socket address for a port on loopback or a socket file, returns its size, 0 if the path doesn't fit
+static socklen_t serverAddress(const std::string& address, sockaddr_storage& storage) {
+    storage = {};
+
+    if (isPort(address)) {
+        sockaddr_in* inet = (sockaddr_in*)&storage;
+        inet->sin_family = AF_INET;
+        inet->sin_port = htons((uint16_t)std::stoi(address));
+        inet->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        return sizeof(sockaddr_in);
+    }
+
+    sockaddr_un* local = (sockaddr_un*)&storage;
+    if (address.empty() || address.size() >= sizeof(local->sun_path)) return 0;
+    local->sun_family = AF_UNIX;
+    std::memcpy(local->sun_path, address.c_str(), address.size() + 1);
+    return sizeof(sockaddr_un);
+}
+
+// Small frames go out right away instead of waiting to be merged
+static void setNoDelay(int fd, const sockaddr_storage& address) {
+    if (address.ss_family != AF_INET) return;
+
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+}
+
+static int64_t nanosecondsSince(Clock::time_point epoch) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch).count();
+}
+
+// One event loop and the sessions it accepted
+class ServerLoop {
+public:
+    ServerLoop(int listener, int width, int height, double tickRate, Clock::time_point epoch);
+    ~ServerLoop();
+
+    // Set up the epoll instance, returns false if it can't
+    bool Open();
+    // Handle events until Wake() is called after running is cleared
+    void Run();
+    // Interrupt epoll_wait() from another thread
+    void Wake();
+
+    std::atomic<bool> running;
+    std::atomic<uint64_t> sessionCount;
+
+    // Totals handed over to TakeReport(), guarded by statsLock
+    std::mutex statsLock;
+    uint64_t reportTicks;
+    uint64_t reportMissed;
+    uint64_t reportDropped;
+    int64_t reportBusyNs;
+    int64_t reportWindowStart;
+    LatencyHistogram reportLatency;
+
+private:
+    struct Session {
+        int fd;
+        // Bumped when the slot is reused, so events for an earlier connection are recognised
+        uint32_t generation;
+        bool open;
+        SnakeGame game;
+        FrameQueue queue;
+        // Ticks run, tick period and the next tick's deadline, in nanoseconds since the loop's epoch
+        uint64_t ticks;
+        int64_t period;
+        int64_t deadline;
+        // Set while waiting for the byte after SERVER_TICK_RATE
+        bool readingRate;
+    };
+
+    int listener;
+    int epoll;
+    int wake;
+    int gridSizeHorizontal;
+    int gridSizeVertical;
+    int64_t defaultPeriod;
+    Clock::time_point epoch;
+
+    std::vector<Session> sessions;
+    std::vector<uint32_t> freeSessions;
+    TimerWheel wheel;
+    // Sessions due this turn, and the frame being built, reused between turns
+    std::vector<uint32_t> due;
+    std::vector<uint8_t> frame;
+
+    // Totals since they were last handed over
+    uint64_t ticks;
+    uint64_t missed;
+    uint64_t dropped;
+    int64_t busyNs;
+    LatencyHistogram latency;
+    int64_t lastPublish;
+
+    void acceptSessions();
+    // Read and apply a session's commands, returns false if it has to be closed
+    bool readCommands(Session&, int64_t now);
+    // Tick a session that's due, and schedule its next tick
+    void tick(uint32_t index, int64_t now);
+    // Queue a keyframe if the session waits for one, and send what's queued, returns false if it has to be closed
+    bool flush(Session&);
+    // Put a session's next deadline on the wheel
+    void schedule(uint32_t index);
+    void close(uint32_t index);
+    // Hand totals over to TakeReport()
+    void publishStats();
+};
+
+ServerLoop::ServerLoop(int listenFd, int width, int height, double tickRate, Clock::time_point start) :
+    running(true), sessionCount(0), reportTicks(0), reportMissed(0), reportDropped(0), reportBusyNs(0), reportWindowStart(0),
+    listener(listenFd), epoll(-1), wake(-1), gridSizeHorizontal(width), gridSizeVertical(height),
+    defaultPeriod((int64_t)(1e9 / tickRate)), epoch(start), wheel(0), ticks(0), missed(0), dropped(0), busyNs(0), lastPublish(0) {}
+
+ServerLoop::~ServerLoop() {
+    for (uint32_t i = 0; i < this->sessions.size(); i++) {
+        if (this->sessions[i].open) this->close(i);
+    }
+
+    if (this->epoll >= 0) ::close(this->epoll);
+    if (this->wake >= 0) ::close(this->wake);
+}
+
+bool ServerLoop::Open() {
+    this->epoll = epoll_create1(EPOLL_CLOEXEC);
+    this->wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (this->epoll < 0 || this->wake < 0) return false;
+
+    // Every loop waits on the listening socket, EPOLLEXCLUSIVE wakes only one of them per connection
+    epoll_event listenEvent = {};
+    listenEvent.events = EPOLLIN | EPOLLEXCLUSIVE;
+    listenEvent.data.u64 = EVENT_LISTENER;
+
+    epoll_event wakeEvent = {};
+    wakeEvent.events = EPOLLIN;
+    wakeEvent.data.u64 = EVENT_WAKE;
+
+    return epoll_ctl(this->epoll, EPOLL_CTL_ADD, this->listener, &listenEvent) == 0
+        && epoll_ctl(this->epoll, EPOLL_CTL_ADD, this->wake, &wakeEvent) == 0;
+}
+
+void ServerLoop::Wake() {
+    uint64_t one = 1;
+    while (write(this->wake, &one, sizeof(one)) < 0 && errno == EINTR) {}
+}
+
+void ServerLoop::Run() {
+    epoll_event events[SERVER_MAX_EVENTS];
+
+    while (this->running.load(std::memory_order_relaxed)) {
+        // Sleep until the earliest wheel slot with a session in it, or the next stats hand-over
+        int64_t now = nanosecondsSince(this->epoch);
+        int64_t wait = SERVER_STATS_INTERVAL_NS;
+        int64_t slots = this->wheel.GetTimeToNext();
+        if (slots >= 0) {
+            int64_t next = (int64_t)(this->wheel.GetTime() + slots) * SERVER_WHEEL_NS;
+            if (next - now < wait) wait = next - now;
+        }
+        int timeout = wait <= 0 ? 0 : (int)((wait + 999999) / 1000000);
+
+        int ready = epoll_wait(this->epoll, events, SERVER_MAX_EVENTS, timeout);
+        int64_t busyStart = nanosecondsSince(this->epoch);
+
+        for (int i = 0; i < ready; i++) {
+            uint64_t data = events[i].data.u64;
+
+            if (data == EVENT_LISTENER) {
+                this->acceptSessions();
+                continue;
+            }
+            if (data == EVENT_WAKE) {
+                uint64_t value;
+                while (read(this->wake, &value, sizeof(value)) < 0 && errno == EINTR) {}
+                continue;
+            }
+
+            // Sessions closed earlier in this batch may have been reused since
+            uint32_t index = (uint32_t)data;
+            if (index >= this->sessions.size()) continue;
+            Session& session = this->sessions[index];
+            if (!session.open || session.generation != (uint32_t)(data >> 32)) continue;
+
+            bool keep = true;
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) keep = this->readCommands(session, busyStart);
+            if (keep) keep = this->flush(session);
+            if (!keep) this->close(index);
+        }
+
+        // Tick every session whose deadline passed
+        int64_t ticked = nanosecondsSince(this->epoch);
+        this->due.clear();
+        this->wheel.Advance((uint64_t)(ticked / SERVER_WHEEL_NS), this->due);
+        for (size_t i = 0; i < this->due.size(); i++) this->tick(this->due[i], ticked);
+
+        int64_t end = nanosecondsSince(this->epoch);
+        this->busyNs += end - busyStart;
+        if (end - this->lastPublish >= SERVER_STATS_INTERVAL_NS) {
+            this->publishStats();
+            this->lastPublish = end;
+        }
+    }
+
+    this->publishStats();
+}
+
+void ServerLoop::acceptSessions() {
+    for (int i = 0; i < SERVER_ACCEPT_BATCH; i++) {
+        sockaddr_storage address;
+        socklen_t size = sizeof(address);
+        int fd = accept4(this->listener, (sockaddr*)&address, &size, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            // Nobody else waiting, another loop took it, or out of descriptors (it stays in the listen backlog)
+            return;
+        }
+        setNoDelay(fd, address);
+
+        // Reuse a closed session's slot, its game keeps its memory
+        uint32_t index;
+        if (!this->freeSessions.empty()) {
+            index = this->freeSessions.back();
+            this->freeSessions.pop_back();
+        } else {
+            index = (uint32_t)this->sessions.size();
+            this->sessions.push_back({-1, 0, false, SnakeGame(this->gridSizeHorizontal, this->gridSizeVertical, getRandomSeed()),
+                FrameQueue(), 0, 0, 0, false});
+            this->sessions.back().game.TrackChangedTiles(true);
+        }
+
+        Session& session = this->sessions[index];
+        session.fd = fd;
+        session.open = true;
+        session.generation++;
+        session.game.Seed(getRandomSeed());
+        session.game.Reset();
+        session.queue = FrameQueue();
+        session.ticks = 0;
+        session.period = this->defaultPeriod;
+        session.deadline = nanosecondsSince(this->epoch) + session.period;
+        session.readingRate = false;
+        // Counted as soon as it's open, close() takes it back off on any failure below
+        this->sessionCount.fetch_add(1, std::memory_order_relaxed);
+
+        epoll_event event = {};
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.u64 = (uint64_t)session.generation << 32 | index;
+        if (epoll_ctl(this->epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+            this->close(index);
+            continue;
+        }
+
+        this->schedule(index);
+
+        // Keyframe goes out right away
+        if (!this->flush(session)) this->close(index);
+    }
+}
+
+bool ServerLoop::readCommands(Session& session, int64_t now) {
+    uint8_t buffer[256];
+
+    // Edge-triggered, read until the socket is drained
+    while (1) {
+        ssize_t got = recv(session.fd, buffer, sizeof(buffer), 0);
+        if (got < 0 && errno == EINTR) continue;
+        if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        if (got <= 0) return false;
+
+        for (ssize_t i = 0; i < got; i++) {
+            uint8_t command = buffer[i];
+
+            if (session.readingRate) {
+                if (command == 0) return false;
+                session.readingRate = false;
+                session.period = 1000000000 / command;
+
+                // New rate counts from now
+                session.deadline = now + session.period;
+                if (!session.game.IsGameOver()) this->schedule((uint32_t)(&session - this->sessions.data()));
+            } else if (command >= (uint8_t)SnakeTypes::Direction::Up && command <= (uint8_t)SnakeTypes::Direction::Right) {
+                session.game.ChangeDirection((SnakeTypes::Direction)command);
+            } else if (command == SERVER_RESTART) {
+                if (!session.game.IsGameOver()) continue;
+
+                session.game.Reset();
+                session.queue.Resync();
+                session.deadline = now + session.period;
+                this->schedule((uint32_t)(&session - this->sessions.data()));
+            } else if (command == SERVER_TICK_RATE) {
+                session.readingRate = true;
+            } else {
+                return false;
+            }
+        }
+    }
+}
+
+void ServerLoop::tick(uint32_t index, int64_t now) {
+    Session& session = this->sessions[index];
+    if (!session.open) return;
+
+    session.game.Tick();
+    session.ticks++;
+
+    this->frame.clear();
+    AppendSpectatorDelta(session.game, session.ticks, this->frame);
+    this->dropped += session.queue.PushDelta(this->frame.data(), this->frame.size(), SERVER_MAX_BACKLOG);
+
+    if (!this->flush(session)) {
+        this->close(index);
+        return;
+    }
+
+    this->ticks++;
+    this->latency.Record(nanosecondsSince(this->epoch) - session.deadline);
+
+    // Nothing left to tick once the game is over, a restart schedules it again
+    if (session.game.IsGameOver()) return;
+
+    // Fell a whole period behind, skip the ticks missed instead of running them late back to back
+    session.deadline += session.period;
+    if (session.deadline <= now) {
+        int64_t behind = (now - session.deadline) / session.period + 1;
+        this->missed += (uint64_t)behind;
+        session.deadline += behind * session.period;
+    }
+
+    this->schedule(index);
+}
+
+bool ServerLoop::flush(Session& session) {
+    // A keyframe goes out once everything older did, the send may drain the queue for one right away
+    for (int i = 0; i < 2; i++) {
+        if (session.queue.WantsKeyframe()) {
+            this->frame.clear();
+            AppendSpectatorKeyframe(session.game, session.ticks, this->frame);
+            session.queue.PushKeyframe(this->frame.data(), this->frame.size());
+        }
+
+        if (!session.queue.Send(session.fd)) return false;
+        if (!session.queue.WantsKeyframe()) break;
+    }
+
+    return true;
+}
+
+void ServerLoop::schedule(uint32_t index) {
+    // Rounded up to the wheel's resolution, so ticks never run early
+    int64_t deadline = this->sessions[index].deadline;
+    this->wheel.Schedule(index, (uint64_t)((deadline + SERVER_WHEEL_NS - 1) / SERVER_WHEEL_NS));
+}
+
+void ServerLoop::close(uint32_t index) {
+    Session& session = this->sessions[index];
+    if (!session.open) return;
+
+    // Closing removes it from the epoll instance too
+    ::close(session.fd);
+    session.fd = -1;
+    session.open = false;
+    this->wheel.Cancel(index);
+    this->freeSessions.push_back(index);
+    this->sessionCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void ServerLoop::publishStats() {
+    std::lock_guard<std::mutex> lock(this->statsLock);
+
+    this->reportTicks += this->ticks;
+    this->reportMissed += this->missed;
+    this->reportDropped += this->dropped;
+    this->reportBusyNs += this->busyNs;
+    this->reportLatency.Merge(this->latency);
+
+    this->ticks = 0;
+    this->missed = 0;
+    this->dropped = 0;
+    this->busyNs = 0;
+    this->latency.Reset();
+}
+
+double GameServer::Report::TicksPerSecond() const {
+    return this->seconds > 0 ? (double)this->ticks / this->seconds : 0;
+}
+
+double GameServer::Report::SessionsPerCore() const {
+    double busyCores = 0;
+    for (size_t i = 0; i < this->busy.size(); i++) busyCores += this->busy[i];
+
+    return busyCores > 0 ? (double)this->sessions / busyCores : 0;
+}
+
+GameServer::GameServer(int x, int y) {
+    SnakeTypes::ClampGridSize(x, y);
+    this->gridSizeHorizontal = x;
+    this->gridSizeVertical = y;
+    this->threadCount = 0;
+    this->tickRate = 15;
+    this->listener = -1;
+}
+
+GameServer::~GameServer() {
+    this->Stop();
+}
+
+void GameServer::SetThreadCount(int threads) {
+    this->threadCount = threads < 0 ? 0 : threads;
+}
+
+void GameServer::SetTickRate(double rate) {
+    this->tickRate = rate < 1 ? 1 : rate > 1000 ? 1000 : rate;
+}
+
+bool GameServer::Start(const std::string& address) {
+    this->Stop();
+
+    sockaddr_storage storage;
+    socklen_t size = serverAddress(address, storage);
+    if (size == 0) return false;
+
+    if (storage.ss_family == AF_UNIX) {
+        // A socket file left by a server that didn't shut down would fail bind(), anything else at the path is kept
+        struct stat existing;
+        if (lstat(address.c_str(), &existing) == 0 && S_ISSOCK(existing.st_mode)) unlink(address.c_str());
+    }
+
+    int fd = socket(storage.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+
+    int on = 1;
+    if (storage.ss_family == AF_INET) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    if (bind(fd, (sockaddr*)&storage, size) != 0 || listen(fd, SOMAXCONN) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    this->listener = fd;
+    if (storage.ss_family == AF_UNIX) this->path = address;
+
+    // Resolve thread count, hardware_concurrency may return 0 if unknown
+    int threads = this->threadCount;
+    if (threads == 0) threads = (int)std::thread::hardware_concurrency();
+    if (threads <= 0) threads = 1;
+
+    this->epoch = Clock::now();
+    for (int i = 0; i < threads; i++) {
+        this->loops.emplace_back(new ServerLoop(fd, this->gridSizeHorizontal, this->gridSizeVertical, this->tickRate, this->epoch));
+        if (!this->loops.back()->Open()) {
+            this->Stop();
+            return false;
+        }
+    }
+
+    int cores = (int)std::thread::hardware_concurrency();
+    for (int i = 0; i < threads; i++) {
+        this->threads.emplace_back(&ServerLoop::Run, this->loops[i].get());
+
+        // One loop per core, so loops don't take turns on a core while others sit idle
+        if (cores > 0) {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(i % cores, &cpus);
+            pthread_setaffinity_np(this->threads.back().native_handle(), sizeof(cpus), &cpus);
+        }
+    }
+
+    return true;
+}
+
+void GameServer::Stop() {
+    for (size_t i = 0; i < this->loops.size(); i++) {
+        this->loops[i]->running.store(false, std::memory_order_relaxed);
+        this->loops[i]->Wake();
+    }
+    for (size_t i = 0; i < this->threads.size(); i++) this->threads[i].join();
+
+    this->threads.clear();
+    this->loops.clear();
+
+    if (this->listener < 0) return;
+
+    ::close(this->listener);
+    if (!this->path.empty()) unlink(this->path.c_str());
+    this->listener = -1;
+    this->path.clear();
+}
+
+GameServer::Report GameServer::TakeReport() {
+    Report report = {(int)this->loops.size(), 0, 0, 0, 0, 0, LatencyHistogram(), std::vector<double>()};
+
+    for (size_t i = 0; i < this->loops.size(); i++) {
+        ServerLoop& loop = *this->loops[i];
+        std::lock_guard<std::mutex> lock(loop.statsLock);
+
+        int64_t now = nanosecondsSince(this->epoch);
+        int64_t window = now - loop.reportWindowStart;
+        if (i == 0) report.seconds = (double)window / 1e9;
+
+        report.sessions += loop.sessionCount.load(std::memory_order_relaxed);
+        report.ticks += loop.reportTicks;
+        report.missedTicks += loop.reportMissed;
+        report.droppedFrames += loop.reportDropped;
+        report.tickLatency.Merge(loop.reportLatency);
+        report.busy.push_back(window > 0 ? (double)loop.reportBusyNs / (double)window : 0);
+
+        loop.reportTicks = 0;
+        loop.reportMissed = 0;
+        loop.reportDropped = 0;
+        loop.reportBusyNs = 0;
+        loop.reportWindowStart = now;
+        loop.reportLatency.Reset();
+    }
+
+    return report;
+}
+
+ServerLoadResult RunServerLoad(const std::string& address, int sessions, double seconds) {
+    ServerLoadResult result = {0, 0, 0, 0, 0, 0};
+
+    sockaddr_storage storage;
+    socklen_t size = serverAddress(address, storage);
+    if (size == 0) return result;
+
+    int epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll < 0) return result;
+
+    // Every client's socket, and bytes received that don't make a whole frame yet
+    std::vector<int> fds;
+    std::vector<std::vector<uint8_t>> received;
+
+    for (int i = 0; i < sessions; i++) {
+        int fd = socket(storage.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) break;
+
+        // Blocking connect, then non-blocking from there on
+        if (connect(fd, (sockaddr*)&storage, size) != 0) {
+            ::close(fd);
+            break;
+        }
+        int flags = fcntl(fd, F_GETFL, 0);
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        setNoDelay(fd, storage);
+
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.u64 = fds.size();
+        epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event);
+
+        fds.push_back(fd);
+        received.emplace_back();
+    }
+    result.connected = (int)fds.size();
+    result.open = result.connected;
+
+    GameRng rng = GameRng(getRandomSeed());
+    epoll_event events[SERVER_MAX_EVENTS];
+    uint8_t buffer[64 * 1024];
+
+    Clock::time_point start = Clock::now();
+    while (result.open > 0 && std::chrono::duration<double>(Clock::now() - start).count() < seconds) {
+        int ready = epoll_wait(epoll, events, SERVER_MAX_EVENTS, 100);
+
+        for (int i = 0; i < ready; i++) {
+            size_t client = (size_t)events[i].data.u64;
+            int fd = fds[client];
+            if (fd < 0) continue;
+
+            ssize_t got = recv(fd, buffer, sizeof(buffer), 0);
+            if (got < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) continue;
+            if (got <= 0) {
+                ::close(fd);
+                fds[client] = -1;
+                result.open--;
+                continue;
+            }
+            result.bytes += (uint64_t)got;
+
+            std::vector<uint8_t>& pending = received[client];
+            pending.insert(pending.end(), buffer, buffer + got);
+
+            // Answer every whole frame: start over once the game ends, or turn every now and then
+            size_t offset = 0;
+            while (pending.size() - offset >= sizeof(SpectatorFrame::Header)) {
+                SpectatorFrame::Header header;
+                std::memcpy(&header, pending.data() + offset, sizeof(header));
+                if (header.size < sizeof(header) || pending.size() - offset < header.size) break;
+                offset += header.size;
+                result.frames++;
+
+                uint8_t command = 0;
+                if (header.flags & SnakeTypes::SNAPSHOT_GAME_OVER) {
+                    command = SERVER_RESTART;
+                    result.restarts++;
+                } else if (randomBelow(rng, 8) == 0) {
+                    command = (uint8_t)(1 + randomBelow(rng, 4));
+                }
+                if (command != 0) send(fd, &command, 1, MSG_DONTWAIT | MSG_NOSIGNAL);
+            }
+            pending.erase(pending.begin(), pending.begin() + offset);
+        }
+    }
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    for (size_t i = 0; i < fds.size(); i++) {
+        if (fds[i] >= 0) ::close(fds[i]);
+    }
+    ::close(epoll);
+
+    return result;
+}
+#endif // __linux__
@@ -0,0 +1,108 @@
+#ifndef __SERVER_INCLUDED__
+#define __SERVER_INCLUDED__
+
+#ifdef __linux__
+#include <chrono> // std::chrono::steady_clock
+#include <cstdint> // uint8_t, uint64_t
+#include <memory> // std::unique_ptr<T>
+#include <string> // std::string
+#include <thread> // std::thread
+#include <vector> // std::vector<T>
+
+#include "latency.h" // LatencyHistogram
+
+// Commands clients send a GameServer, one byte each
+// 1-4 turn the snake, same values as SnakeTypes::Direction
+const uint8_t SERVER_RESTART = 5; // Start over, once the game is over
+const uint8_t SERVER_TICK_RATE = 6; // Followed by one byte, ticks per second (1-255)
+
+class ServerLoop;
+
+// Hosts many independent SnakeGame sessions, one per client connection, over loopback TCP or a Unix domain socket
+//
+// Clients send the commands above, anything else disconnects them. The server sends SpectatorFrame frames
+// (see spectator.h): a keyframe on connect and after starting over, then a delta after every tick
+//
+// One event loop thread per core, each with its own epoll instance, sessions and timer wheel, all waiting on the same
+// listening socket (the kernel wakes one loop per connection). A session lives on the loop that accepted it, so
+// sessions are never shared between threads. The wheel ticks every session at its own rate, at 1 ms resolution,
+// and a session that falls more than a tick behind skips the ticks it missed instead of running them back to back
+class GameServer {
+public:
+    // Totals over the time since the previous TakeReport() (or Start())
+    struct Report {
+        int loops;
+        // Connected sessions when the report was taken
+        uint64_t sessions;
+        uint64_t ticks;
+        // Ticks skipped by sessions that fell behind
+        uint64_t missedTicks;
+        // Frames dropped for clients that didn't read fast enough (see FrameQueue)
+        uint64_t droppedFrames;
+        double seconds;
+        // Time from every tick's deadline until its frame was handed to the socket, over every session
+        LatencyHistogram tickLatency;
+        // Fraction of the time each loop spent working instead of waiting, 0-1
+        std::vector<double> busy;
+
+        // Session ticks per wall-clock second, over every loop
+        double TicksPerSecond() const;
+        // Sessions a fully busy core could run at the current tick rates, from how busy the loops were
+        double SessionsPerCore() const;
+    };
+
+    // Sessions play on a variable-size rectangle (see SnakeTypes::ClampGridSize())
+    GameServer(int, int);
+    // Stops the server
+    ~GameServer();
+
+    // Owns threads and sockets
+    GameServer(const GameServer&) = delete;
+    GameServer& operator=(const GameServer&) = delete;
+
+    // Set amount of event loops, 0 uses every hardware thread, takes effect on the next Start()
+    void SetThreadCount(int);
+    // Set the tick rate new sessions start with (ticks per second, clamped to 1-1000), clients can change their own
+    void SetTickRate(double);
+
+    // Listen on a loopback TCP port (address is a number) or a Unix domain socket file (anything else), and start
+    // the event loops, returns false if the socket can't be set up
+    bool Start(const std::string& address);
+    // Disconnect every client and stop the event loops
+    void Stop();
+
+    // Totals since the previous call
+    Report TakeReport();
+
+private:
+    int gridSizeHorizontal;
+    int gridSizeVertical;
+    int threadCount;
+    double tickRate;
+
+    int listener;
+    // Socket file to remove on Stop(), empty for TCP
+    std::string path;
+    // Loops count time from here
+    std::chrono::steady_clock::time_point epoch;
+    std::vector<std::unique_ptr<ServerLoop>> loops;
+    std::vector<std::thread> threads;
+};
+
+// Totals from RunServerLoad()
+struct ServerLoadResult {
+    // Sessions that connected, and that were still connected at the end
+    int connected;
+    int open;
+    uint64_t frames;
+    uint64_t bytes;
+    uint64_t restarts;
+    double seconds;
+};
+
+// Open sessions on a GameServer at address and play them with random turns for a while, restarting games that end,
+// from a single thread, for sizing servers
+ServerLoadResult RunServerLoad(const std::string& address, int sessions, double seconds);
+#endif // __linux__
+
+#endif // __SERVER_INCLUDED__
@@ -0,0 +1,137 @@
+#include <exception> // std::exception
+
+#include "batch.h" // SnakeBatch
+
+// Export the API when building the library on Windows
+#define SNAKE_API_EXPORTS
+#include "snakeapi.h" // Function declarations
+
+// Opaque handle handed to C callers
+struct snake_batch {
+    SnakeBatch batch;
+
+    snake_batch(int games, int width, int height, uint64_t seed) : batch(games, width, height, seed) {}
+};
+
+// Is game an index into the batch
+static bool validGame(snake_batch* batch, int game) {
+    return batch != nullptr && game >= 0 && game < batch->batch.GetGameCount();
+}
+
+int snake_api_version(void) {
+    return SNAKE_API_VERSION;
+}
+
+snake_batch* snake_batch_create(int games, int width, int height, uint64_t seed) {
+    if (games < 1 || width < 1 || height < 1) return nullptr;
+
+    // Allocation failures can't cross the C boundary as exceptions
+    try {
+        return new snake_batch(games, width, height, seed);
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
+void snake_batch_destroy(snake_batch* batch) {
+    delete batch;
+}
+
+int snake_batch_games(snake_batch* batch) {
+    if (batch == nullptr) return -1;
+
+    return batch->batch.GetGameCount();
+}
+
+int snake_batch_width(snake_batch* batch) {
+    if (batch == nullptr) return -1;
+
+    return (int)batch->batch.GetGridSizeHorizontal();
+}
+
+int snake_batch_height(snake_batch* batch) {
+    if (batch == nullptr) return -1;
+
+    return (int)batch->batch.GetGridSizeVertical();
+}
+
+int snake_batch_bind(snake_batch* batch, uint8_t* grids, int32_t* scores, int32_t* dones) {
+    if (batch == nullptr) return -1;
+
+    batch->batch.UseBuffers(grids, scores, dones);
+    return 0;
+}
+
+int snake_batch_step(snake_batch* batch, const uint8_t* actions) {
+    if (batch == nullptr) return -1;
+
+    batch->batch.Step(actions);
+    return 0;
+}
+
+int snake_batch_reset(snake_batch* batch, int game) {
+    if (!validGame(batch, game)) return -1;
+
+    batch->batch.Reset(game);
+    return 0;
+}
+
+int snake_batch_reset_all(snake_batch* batch) {
+    if (batch == nullptr) return -1;
+
+    batch->batch.ResetAll();
+    return 0;
+}
+
+int snake_batch_reset_done(snake_batch* batch) {
+    if (batch == nullptr) return -1;
+
+    return batch->batch.ResetFinished();
+}
+
+const uint8_t* snake_batch_grids(snake_batch* batch) {
+    if (batch == nullptr) return nullptr;
+
+    return batch->batch.GetAllTiles();
+}
+
+const int32_t* snake_batch_scores(snake_batch* batch) {
+    if (batch == nullptr) return nullptr;
+
+    return batch->batch.GetScores();
+}
+
+const int32_t* snake_batch_dones(snake_batch* batch) {
+    if (batch == nullptr) return nullptr;
+
+    return batch->batch.GetGameOverFlags();
+}
+
+int snake_batch_won(snake_batch* batch, int game) {
+    if (!validGame(batch, game)) return -1;
+
+    return batch->batch.IsGameWon(game) ? 1 : 0;
+}
+
+int snake_batch_head(snake_batch* batch, int game, uint32_t* x, uint32_t* y) {
+    if (!validGame(batch, game)) return -1;
+
+    SnakeTypes::Position head = batch->batch.GetSnakeHeadPos(game);
+    if (x != nullptr) *x = head.x;
+    if (y != nullptr) *y = head.y;
+    return 0;
+}
+
+size_t snake_batch_snapshot(snake_batch* batch, int game, uint8_t* buffer, size_t size) {
+    if (!validGame(batch, game)) return 0;
+
+    size_t needed = batch->batch.GetSnapshotSize(game);
+    if (buffer != nullptr && size >= needed) batch->batch.SaveSnapshot(game, buffer);
+    return needed;
+}
+
+const char* snake_batch_kernel(snake_batch* batch) {
+    if (batch == nullptr) return nullptr;
+
+    return SnakeBatch::KernelName(batch->batch.GetKernel());
+}
@@ -0,0 +1,97 @@
+#ifndef __SNAKEAPI_INCLUDED__
+#define __SNAKEAPI_INCLUDED__
+
+#include <stddef.h> /* size_t */
+#include <stdint.h> /* uint8_t, int32_t, uint32_t, uint64_t */
+
+/**
+*
+* C API for driving batches of games from other languages, build.sh builds it into build/libsnake.so
+*
+* A batch is many games of one size stepped together (see SnakeBatch in batch.h). Once the caller gives it buffers
+* with snake_batch_bind(), every snake_batch_step() writes the grids, scores and done flags straight into them,
+* nothing is copied or allocated per step:
+*   grids: games * width * height bytes, game after game, each row-major (tile = y * width + x), SNAKE_TILE_* values
+*   scores: one int32_t per game, fruits eaten since the game was last reset
+*   dones: one int32_t per game, 1 once the game is over (the snake hit itself or filled the grid)
+*
+* Functions never throw or abort, invalid arguments and failed allocations return -1, 0 or NULL
+* The API is stable: functions keep their signatures and behaviour, new ones raise SNAKE_API_VERSION
+*
+* */
+
+#define SNAKE_API_VERSION 1
+
+/* Tile values in grid buffers */
+#define SNAKE_TILE_EMPTY 0
+#define SNAKE_TILE_SNAKE 1
+#define SNAKE_TILE_FRUIT 2
+
+/* Action values, SNAKE_ACTION_NONE keeps going the same way, turning back onto the snake is ignored */
+#define SNAKE_ACTION_NONE 0
+#define SNAKE_ACTION_UP 1
+#define SNAKE_ACTION_DOWN 2
+#define SNAKE_ACTION_LEFT 3
+#define SNAKE_ACTION_RIGHT 4
+
+#ifdef _WIN32
+#ifdef SNAKE_API_EXPORTS
+#define SNAKE_API __declspec(dllexport)
+#else /* SNAKE_API_EXPORTS */
+#define SNAKE_API __declspec(dllimport)
+#endif /* SNAKE_API_EXPORTS */
+#else /* _WIN32 */
+#define SNAKE_API __attribute__((visibility("default")))
+#endif /* _WIN32 */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct snake_batch snake_batch;
+
+/* SNAKE_API_VERSION the library was built with */
+SNAKE_API int snake_api_version(void);
+
+/* Create games of width x height (clamped like SnakeGame), game i seeded with seed + i, NULL on failure */
+SNAKE_API snake_batch* snake_batch_create(int games, int width, int height, uint64_t seed);
+SNAKE_API void snake_batch_destroy(snake_batch* batch);
+
+SNAKE_API int snake_batch_games(snake_batch* batch);
+/* Grid size after clamping */
+SNAKE_API int snake_batch_width(snake_batch* batch);
+SNAKE_API int snake_batch_height(snake_batch* batch);
+
+/* Keep grids, scores and dones in caller-owned buffers from now on (see above), NULL leaves that one where it is
+ * The current state is copied in once, buffers must stay valid until the batch is destroyed or bound again */
+SNAKE_API int snake_batch_bind(snake_batch* batch, uint8_t* grids, int32_t* scores, int32_t* dones);
+
+/* Turn every game by actions[game] (SNAKE_ACTION_* values, NULL for no turns), then move every game that isn't done */
+SNAKE_API int snake_batch_step(snake_batch* batch, const uint8_t* actions);
+/* Start one game over, or every game, or every done game (returns how many) */
+SNAKE_API int snake_batch_reset(snake_batch* batch, int game);
+SNAKE_API int snake_batch_reset_all(snake_batch* batch);
+SNAKE_API int snake_batch_reset_done(snake_batch* batch);
+
+/* Current grids, scores and dones, the caller's buffers once bound */
+SNAKE_API const uint8_t* snake_batch_grids(snake_batch* batch);
+SNAKE_API const int32_t* snake_batch_scores(snake_batch* batch);
+SNAKE_API const int32_t* snake_batch_dones(snake_batch* batch);
+
+/* 1 if the game's snake filled the whole grid */
+SNAKE_API int snake_batch_won(snake_batch* batch, int game);
+/* Position of the game's snake head */
+SNAKE_API int snake_batch_head(snake_batch* batch, int game, uint32_t* x, uint32_t* y);
+
+/* Write the game as a SnakeGame snapshot if it fits in size bytes, returns the snapshot size either way (0 if the
+ * game doesn't exist) */
+SNAKE_API size_t snake_batch_snapshot(snake_batch* batch, int game, uint8_t* buffer, size_t size);
+
+/* Instruction set stepping runs on: "scalar", "sse4.1" or "avx2" */
+SNAKE_API const char* snake_batch_kernel(snake_batch* batch);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __SNAKEAPI_INCLUDED__ */
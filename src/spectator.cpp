@@ -0,0 +1,377 @@
+#ifndef _WIN32
+#include <cerrno> // errno, EINTR, EAGAIN, EWOULDBLOCK
+#include <fcntl.h> // fcntl(), F_GETFL, F_SETFL, O_NONBLOCK
+#include <poll.h> // poll(), pollfd
+#include <sys/socket.h> // socket(), bind(), listen(), accept(), connect(), send(), MSG_NOSIGNAL
+#include <sys/stat.h> // lstat(), S_ISSOCK
+#include <sys/un.h> // sockaddr_un
+#include <unistd.h> // read(), close(), unlink()
+#include <utility> // std::move
+
+#include "spectator.h" // Class declarations
+
+// Bytes read from the feed at once
+const size_t RECEIVE_CHUNK = 64 * 1024;
+
+#ifdef MSG_NOSIGNAL
+// A viewer that went away fails the send instead of killing the game with SIGPIPE
+const int SEND_FLAGS = MSG_NOSIGNAL;
+#else // MSG_NOSIGNAL
+// SO_NOSIGPIPE is set on every viewer socket instead
+const int SEND_FLAGS = 0;
+#endif // MSG_NOSIGNAL
+
+// Fill in a socket address for a socket file, returns false if the path doesn't fit
+static bool socketAddress(const std::string& path, sockaddr_un& address) {
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) return false;
+
+    address = {};
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+static bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+// Size of the frame starting at offset of a buffer of frames
+static size_t queuedFrameSize(const std::vector<uint8_t>& queue, size_t offset) {
+    uint32_t size;
+    std::memcpy(&size, queue.data() + offset + offsetof(SpectatorFrame::Header, size), sizeof(size));
+    return size;
+}
+
+FrameQueue::FrameQueue() : sent(0), needsKeyframe(true) {}
+
+uint64_t FrameQueue::PushDelta(const uint8_t* frame, size_t size, size_t maxBacklog) {
+    // The keyframe it's waiting for replaces this delta
+    if (this->needsKeyframe) return 1;
+
+    // Forget the frames that went out, so the queue starts with the frame being sent
+    size_t start = 0;
+    while (start < this->sent && start + queuedFrameSize(this->pending, start) <= this->sent) {
+        start += queuedFrameSize(this->pending, start);
+    }
+    if (start > 0) {
+        this->pending.erase(this->pending.begin(), this->pending.begin() + start);
+        this->sent -= start;
+    }
+
+    if (this->pending.size() - this->sent + size <= maxBacklog) {
+        this->pending.insert(this->pending.end(), frame, frame + size);
+        return 0;
+    }
+
+    // Fell behind, drop every frame that didn't start going out, this one included
+    size_t keep = this->sent > 0 ? queuedFrameSize(this->pending, 0) : 0;
+    uint64_t dropped = 1;
+    for (size_t offset = keep; offset < this->pending.size(); offset += queuedFrameSize(this->pending, offset)) dropped++;
+
+    this->pending.resize(keep);
+    this->needsKeyframe = true;
+    return dropped;
+}
+
+bool FrameQueue::WantsKeyframe() {
+    return this->needsKeyframe && this->sent == this->pending.size();
+}
+
+void FrameQueue::PushKeyframe(const uint8_t* frame, size_t size) {
+    if (this->sent == this->pending.size()) {
+        this->pending.clear();
+        this->sent = 0;
+    }
+
+    this->pending.insert(this->pending.end(), frame, frame + size);
+    this->needsKeyframe = false;
+}
+
+void FrameQueue::Resync() {
+    this->needsKeyframe = true;
+}
+
+bool FrameQueue::Send(int fd) {
+    while (this->sent < this->pending.size()) {
+        ssize_t written = send(fd, this->pending.data() + this->sent, this->pending.size() - this->sent, MSG_DONTWAIT | SEND_FLAGS);
+        if (written > 0) {
+            this->sent += (size_t)written;
+            continue;
+        }
+
+        if (written < 0 && errno == EINTR) continue;
+        // Socket buffer is full, the rest waits for the next call
+        if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        // Disconnected
+        return false;
+    }
+
+    // Everything went out, keep the memory for the next frames
+    this->pending.clear();
+    this->sent = 0;
+    return true;
+}
+
+size_t FrameQueue::GetBacklog() {
+    return this->pending.size() - this->sent;
+}
+
+SpectatorFeed::SpectatorFeed() : listener(-1), ticks(0), droppedFrames(0) {}
+
+SpectatorFeed::~SpectatorFeed() {
+    this->Stop();
+}
+
+bool SpectatorFeed::Start(const std::string& socketPath) {
+    this->Stop();
+
+    sockaddr_un address;
+    if (!socketAddress(socketPath, address)) return false;
+
+    // A socket file left by a feed that didn't shut down would fail bind(), anything else at the path is kept
+    struct stat existing;
+    if (lstat(socketPath.c_str(), &existing) == 0 && S_ISSOCK(existing.st_mode)) unlink(socketPath.c_str());
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+
+    if (bind(fd, (sockaddr*)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0 || !setNonBlocking(fd)) {
+        close(fd);
+        return false;
+    }
+
+    this->listener = fd;
+    this->path = socketPath;
+    this->ticks = 0;
+    this->droppedFrames = 0;
+    return true;
+}
+
+void SpectatorFeed::Stop() {
+    while (!this->viewers.empty()) this->drop(this->viewers.size() - 1);
+
+    if (this->listener < 0) return;
+
+    close(this->listener);
+    unlink(this->path.c_str());
+    this->listener = -1;
+}
+
+void SpectatorFeed::Resync() {
+    for (size_t i = 0; i < this->viewers.size(); i++) this->viewers[i].queue.Resync();
+}
+
+size_t SpectatorFeed::GetViewerCount() {
+    return this->viewers.size();
+}
+
+uint64_t SpectatorFeed::GetDroppedFrames() {
+    return this->droppedFrames;
+}
+
+void SpectatorFeed::acceptViewers() {
+    while (1) {
+        int fd = accept(this->listener, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            // Nobody else waiting, or out of descriptors (they stay in the listen backlog until some free up)
+            return;
+        }
+
+        if (!setNonBlocking(fd)) {
+            close(fd);
+            continue;
+        }
+
+#ifdef SO_NOSIGPIPE
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif // SO_NOSIGPIPE
+
+        this->viewers.push_back({fd, FrameQueue()});
+    }
+}
+
+bool SpectatorFeed::keyframeWanted() {
+    for (size_t i = 0; i < this->viewers.size(); i++) {
+        if (this->viewers[i].queue.WantsKeyframe()) return true;
+    }
+
+    return false;
+}
+
+void SpectatorFeed::queueKeyframe() {
+    for (size_t i = 0; i < this->viewers.size(); i++) {
+        // Viewers still sending older frames get theirs once done, it's built from the game as it is then
+        FrameQueue& queue = this->viewers[i].queue;
+        if (queue.WantsKeyframe()) queue.PushKeyframe(this->frame.data(), this->frame.size());
+    }
+}
+
+void SpectatorFeed::queueDelta() {
+    for (size_t i = 0; i < this->viewers.size(); i++) {
+        this->droppedFrames += this->viewers[i].queue.PushDelta(this->frame.data(), this->frame.size(), MaxBacklog);
+    }
+}
+
+void SpectatorFeed::flush() {
+    for (size_t i = 0; i < this->viewers.size();) {
+        if (this->viewers[i].queue.Send(this->viewers[i].fd)) {
+            i++;
+        } else {
+            // Last viewer moves into this slot, check it next
+            this->drop(i);
+        }
+    }
+}
+
+void SpectatorFeed::drop(size_t index) {
+    close(this->viewers[index].fd);
+    if (index + 1 < this->viewers.size()) this->viewers[index] = std::move(this->viewers.back());
+    this->viewers.pop_back();
+}
+
+SpectatorView::SpectatorView() : fd(-1), synced(false), keyframes(0), last() {}
+
+SpectatorView::~SpectatorView() {
+    if (this->fd >= 0) close(this->fd);
+}
+
+bool SpectatorView::Connect(const std::string& path) {
+    sockaddr_un address;
+    if (!socketAddress(path, address)) return false;
+
+    if (this->fd >= 0) close(this->fd);
+    this->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (this->fd < 0) return false;
+
+    if (connect(this->fd, (sockaddr*)&address, sizeof(address)) != 0) {
+        close(this->fd);
+        this->fd = -1;
+        return false;
+    }
+
+    this->received.clear();
+    this->synced = false;
+    return true;
+}
+
+int SpectatorView::Receive(int timeout) {
+    if (this->fd < 0) return -1;
+
+    pollfd pfd = {this->fd, POLLIN, 0};
+    int ready = poll(&pfd, 1, timeout);
+    if (ready < 0) return errno == EINTR ? 0 : -1;
+    if (ready == 0) return 0;
+
+    // Read straight into the end of the buffer
+    size_t used = this->received.size();
+    this->received.resize(used + RECEIVE_CHUNK);
+    ssize_t got = read(this->fd, this->received.data() + used, RECEIVE_CHUNK);
+    if (got <= 0) {
+        this->received.resize(used);
+        // Nothing read means the feed closed
+        return got < 0 && errno == EINTR ? 0 : -1;
+    }
+    this->received.resize(used + (size_t)got);
+
+    // Apply every whole frame, a partial one stays for the next call
+    int frames = 0;
+    size_t offset = 0;
+    while (this->received.size() - offset >= sizeof(SpectatorFrame::Header)) {
+        size_t size = queuedFrameSize(this->received, offset);
+        if (size < sizeof(SpectatorFrame::Header)) return -1;
+        if (this->received.size() - offset < size) break;
+
+        if (!this->Apply(this->received.data() + offset, size)) return -1;
+        offset += size;
+        frames++;
+    }
+    this->received.erase(this->received.begin(), this->received.begin() + offset);
+
+    return frames;
+}
+
+bool SpectatorView::Apply(const uint8_t* frame, size_t size) {
+    SpectatorFrame::Header header;
+    if (size < sizeof(header)) return false;
+    std::memcpy(&header, frame, sizeof(header));
+
+    if (header.magic != SpectatorFrame::MAGIC || header.size != size) return false;
+    if (header.width == 0 || header.height == 0 || header.headX >= header.width || header.headY >= header.height) return false;
+
+    uint64_t area = (uint64_t)header.width * header.height;
+    const uint8_t* body = frame + sizeof(header);
+
+    if (header.type == SpectatorFrame::KEYFRAME) {
+        if (header.count != area || size != sizeof(header) + area) return false;
+
+        this->tiles.assign(body, body + area);
+        this->synced = true;
+        this->keyframes++;
+    } else if (header.type == SpectatorFrame::DELTA) {
+        // Deltas only apply to the grid the last keyframe set up
+        if (!this->synced || header.width != this->last.width || header.height != this->last.height) return false;
+        if (size != sizeof(header) + (uint64_t)header.count * 5) return false;
+
+        for (uint32_t i = 0; i < header.count; i++) {
+            uint32_t cell;
+            std::memcpy(&cell, body + (size_t)i * 4, 4);
+            if (cell >= area) return false;
+            Tile from = (Tile)this->tiles[cell];
+            this->tiles[cell] = body[(size_t)header.count * 4 + i];
+            this->ChangedTiles.push_back({{(Coord)(cell % header.width), (Coord)(cell / header.width)}, from, (Tile)this->tiles[cell]});
+        }
+    } else {
+        return false;
+    }
+
+    this->last = header;
+    return true;
+}
+
+bool SpectatorView::IsSynced() {
+    return this->synced;
+}
+
+uint64_t SpectatorView::GetTick() {
+    return this->last.tick;
+}
+
+uint32_t SpectatorView::GetGridSizeHorizontal() {
+    return this->last.width;
+}
+
+uint32_t SpectatorView::GetGridSizeVertical() {
+    return this->last.height;
+}
+
+SnakeTypes::Tile SpectatorView::GetTile(int x, int y) {
+    return (Tile)this->tiles[(size_t)y * this->last.width + x];
+}
+
+uint16_t SpectatorView::GetScore() {
+    return this->last.score;
+}
+
+SnakeTypes::Direction SpectatorView::GetSnakeDirection() {
+    return (Direction)this->last.direction;
+}
+
+SnakeTypes::Position SpectatorView::GetSnakeHeadPos() {
+    return {(Coord)this->last.headX, (Coord)this->last.headY};
+}
+
+bool SpectatorView::IsGameOver() {
+    return (this->last.flags & SNAPSHOT_GAME_OVER) != 0;
+}
+
+bool SpectatorView::IsGameWon() {
+    return (this->last.flags & SNAPSHOT_GAME_WON) != 0;
+}
+
+uint64_t SpectatorView::GetKeyframeCount() {
+    return this->keyframes;
+}
+#endif // _WIN32
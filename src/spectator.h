@@ -0,0 +1,293 @@
+#ifndef __SPECTATOR_INCLUDED__
+#define __SPECTATOR_INCLUDED__
+
+#ifndef _WIN32
+#include <cstddef> // size_t
+#include <cstdint> // uint8_t, uint16_t, uint32_t, uint64_t
+#include <cstring> // std::memcpy
+#include <string> // std::string
+#include <vector> // std::vector<T>
+
+#include "game.h" // SnakeTypes
+
+// Frames sent from a SpectatorFeed to its viewers
+// Every frame is a header followed by its body, in the byte order of the machine (the socket is local):
+//   Keyframe: width * height tiles, one byte each, row-major
+//   Delta: count tile indices (y * width + x), four bytes each, then the new value of each of those tiles, one byte each
+struct SpectatorFrame {
+    struct Header {
+        // MAGIC
+        uint32_t magic;
+        // Bytes in the whole frame, header included
+        uint32_t size;
+        // Ticks the feed had published when the frame was built
+        uint64_t tick;
+        // KEYFRAME or DELTA
+        uint32_t type;
+        uint32_t width;
+        uint32_t height;
+        uint32_t headX;
+        uint32_t headY;
+        // Tiles in the body
+        uint32_t count;
+        uint16_t score;
+        uint8_t direction;
+        // SnakeTypes::SNAPSHOT_GAME_OVER and SNAPSHOT_GAME_WON bits
+        uint8_t flags;
+    };
+
+    static const uint32_t MAGIC = 0x43455053; // "SPEC"
+    static const uint32_t KEYFRAME = 1;
+    static const uint32_t DELTA = 2;
+};
+
+// Append a keyframe of the whole game to out
+template <typename Game>
+void AppendSpectatorKeyframe(Game& game, uint64_t tick, std::vector<uint8_t>& out);
+// Append a delta of the game's last Tick() to out, built from its ChangedTiles
+template <typename Game>
+void AppendSpectatorDelta(Game& game, uint64_t tick, std::vector<uint8_t>& out);
+
+// Frames waiting to go out on one non-blocking socket
+// Bytes the socket didn't take stay queued for the next Send(). A queue that would grow past its backlog limit drops
+// its queued deltas (all but a partly sent frame, or the reader would lose track of where frames start) and waits
+// for a keyframe, so a slow reader costs memory up to the limit, never time
+class FrameQueue {
+public:
+    FrameQueue();
+
+    // Queue a delta, unless waiting for a keyframe, or it would take more than maxBacklog bytes queued
+    // Returns how many deltas got dropped instead, this one included
+    uint64_t PushDelta(const uint8_t* frame, size_t size, size_t maxBacklog);
+    // Is it waiting for a keyframe, with nothing older left to send
+    bool WantsKeyframe();
+    // Queue a keyframe, deltas get queued again after it
+    void PushKeyframe(const uint8_t* frame, size_t size);
+    // Drop deltas until the next keyframe, for when the whole game changed
+    void Resync();
+
+    // Send as much as the socket takes, returns false if it's disconnected
+    bool Send(int fd);
+    // Bytes queued that didn't go out yet
+    size_t GetBacklog();
+
+private:
+    // Frames queued, from sent onwards nothing went out yet
+    std::vector<uint8_t> pending;
+    size_t sent;
+    // Deltas are no use until a keyframe, none get queued meanwhile
+    bool needsKeyframe;
+};
+
+// Broadcasts a live game to local viewers over a Unix domain socket
+// A viewer gets a keyframe of the whole grid when it connects, then one delta frame per tick built from the
+// game's ChangedTiles, with the score and head direction. Frames are built once and queued to every viewer
+//
+// Nothing blocks the game loop: sockets are non-blocking, and every viewer has its own FrameQueue, so a viewer that
+// falls MaxBacklog bytes behind skips to a fresh keyframe once its socket drains instead of stalling the game
+class SpectatorFeed : public SnakeTypes {
+public:
+    // Most bytes queued for one viewer before it falls back to keyframes (a keyframe bigger than this still goes out)
+    static const size_t MaxBacklog = 64 * 1024;
+
+    SpectatorFeed();
+    // Stops the feed
+    ~SpectatorFeed();
+
+    // Owns sockets
+    SpectatorFeed(const SpectatorFeed&) = delete;
+    SpectatorFeed& operator=(const SpectatorFeed&) = delete;
+
+    // Listen on a socket file at path, replacing a stale socket file there, returns false if it can't
+    bool Start(const std::string& path);
+    // Disconnect every viewer and remove the socket file
+    void Stop();
+
+    // Accept new viewers, queue keyframes for viewers waiting for one, and send what's queued, call once per loop
+    template <typename Game>
+    void Update(Game& game);
+    // Queue the last Tick()'s changes to every viewer, then Update(), call after every Tick() that ran
+    // The game has to track its changed tiles (see TrackChangedTiles())
+    template <typename Game>
+    void PublishTick(Game& game);
+    // The whole game changed (Reset(), RestoreSnapshot()), send every viewer a keyframe instead of the next delta
+    void Resync();
+
+    // Connected viewers
+    size_t GetViewerCount();
+    // Delta frames dropped for viewers that fell behind
+    uint64_t GetDroppedFrames();
+
+private:
+    struct Viewer {
+        int fd;
+        FrameQueue queue;
+    };
+
+    // Listening socket, -1 when stopped
+    int listener;
+    std::string path;
+    std::vector<Viewer> viewers;
+    uint64_t ticks;
+    uint64_t droppedFrames;
+    // Frame being built, reused between frames
+    std::vector<uint8_t> frame;
+
+    // Accept every pending connection
+    void acceptViewers();
+    // Is a viewer waiting for a keyframe with nothing left queued
+    bool keyframeWanted();
+    // Queue the built frame as a keyframe to every viewer waiting for one
+    void queueKeyframe();
+    // Queue the built frame as a delta to every viewer
+    void queueDelta();
+    // Send what's queued to every viewer, dropping viewers that disconnected
+    void flush();
+    // Disconnect a viewer
+    void drop(size_t index);
+};
+
+// Append a frame header, and room for a body of count tiles, returns where the body starts
+template <typename Game>
+uint8_t* appendSpectatorHeader(Game& game, uint64_t tick, uint32_t type, uint32_t count, std::vector<uint8_t>& out) {
+    size_t bodySize = type == SpectatorFrame::KEYFRAME ? count : (size_t)count * 5;
+
+    SpectatorFrame::Header header = {};
+    header.magic = SpectatorFrame::MAGIC;
+    header.size = (uint32_t)(sizeof(header) + bodySize);
+    header.tick = tick;
+    header.type = type;
+    header.width = game.GetGridSizeHorizontal();
+    header.height = game.GetGridSizeVertical();
+    header.headX = game.GetSnakeHeadPos().x;
+    header.headY = game.GetSnakeHeadPos().y;
+    header.count = count;
+    header.score = game.GetScore();
+    header.direction = (uint8_t)game.GetSnakeDirection();
+    header.flags = (game.IsGameOver() ? SnakeTypes::SNAPSHOT_GAME_OVER : 0) | (game.IsGameWon() ? SnakeTypes::SNAPSHOT_GAME_WON : 0);
+
+    // Keeps its capacity, so frames only allocate while out grows past its biggest size yet
+    size_t start = out.size();
+    out.resize(start + sizeof(header) + bodySize);
+    std::memcpy(out.data() + start, &header, sizeof(header));
+    return out.data() + start + sizeof(header);
+}
+
+template <typename Game>
+void AppendSpectatorKeyframe(Game& game, uint64_t tick, std::vector<uint8_t>& out) {
+    uint32_t width = game.GetGridSizeHorizontal();
+    uint32_t height = game.GetGridSizeVertical();
+    uint8_t* tiles = appendSpectatorHeader(game, tick, SpectatorFrame::KEYFRAME, width * height, out);
+
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            tiles[y * width + x] = (uint8_t)game.GetTile((int)x, (int)y);
+        }
+    }
+}
+
+template <typename Game>
+void AppendSpectatorDelta(Game& game, uint64_t tick, std::vector<uint8_t>& out) {
+    // Tile indices, then their tiles, as they are now (a tile listed twice gets the same value twice)
+    uint32_t count = (uint32_t)game.ChangedTiles.size();
+    uint8_t* body = appendSpectatorHeader(game, tick, SpectatorFrame::DELTA, count, out);
+    uint32_t width = game.GetGridSizeHorizontal();
+
+    for (uint32_t i = 0; i < count; i++) {
+        SnakeTypes::Position pos = game.ChangedTiles[i];
+        uint32_t cell = (uint32_t)pos.y * width + pos.x;
+        std::memcpy(body + (size_t)i * 4, &cell, 4);
+        body[(size_t)count * 4 + i] = (uint8_t)game.GetTile(pos.x, pos.y);
+    }
+}
+
+template <typename Game>
+void SpectatorFeed::Update(Game& game) {
+    if (this->listener < 0) return;
+
+    this->acceptViewers();
+
+    // One keyframe serves every viewer that joined or fell behind since the last one
+    if (this->keyframeWanted()) {
+        this->frame.clear();
+        AppendSpectatorKeyframe(game, this->ticks, this->frame);
+        this->queueKeyframe();
+    }
+
+    this->flush();
+}
+
+template <typename Game>
+void SpectatorFeed::PublishTick(Game& game) {
+    if (this->listener < 0) return;
+
+    this->ticks++;
+
+    if (!this->viewers.empty()) {
+        this->frame.clear();
+        AppendSpectatorDelta(game, this->ticks, this->frame);
+        this->queueDelta();
+    }
+
+    this->Update(game);
+}
+
+// Viewer side of a SpectatorFeed: rebuilds the broadcast game from its frames
+// Has the same getters as a game, so DrawGame() draws it like one
+class SpectatorView : public SnakeTypes {
+public:
+    SpectatorView();
+    // Disconnects
+    ~SpectatorView();
+
+    // Owns a socket
+    SpectatorView(const SpectatorView&) = delete;
+    SpectatorView& operator=(const SpectatorView&) = delete;
+
+    // Connect to a feed's socket file, returns false if it can't
+    bool Connect(const std::string& path);
+    // Wait up to timeout milliseconds (-1 for no limit) for data from the feed, and apply every whole frame received
+    // Returns frames applied, or -1 once the feed is gone or sent something that isn't a valid frame
+    int Receive(int timeout);
+    // Apply one frame, returns false if it isn't valid (a delta before any keyframe isn't)
+    bool Apply(const uint8_t* frame, size_t size);
+
+    // Has a keyframe arrived yet, the getters below only mean something once it has
+    bool IsSynced();
+    // Ticks the feed had published at the last frame
+    uint64_t GetTick();
+
+    uint32_t GetGridSizeHorizontal();
+    uint32_t GetGridSizeVertical();
+    Tile GetTile(int x, int y);
+    uint16_t GetScore();
+    Direction GetSnakeDirection();
+    Position GetSnakeHeadPos();
+    bool IsGameOver();
+    bool IsGameWon();
+
+    // Tile a delta changed, and what it held before and after
+    struct TileChange {
+        Position pos;
+        Tile from;
+        Tile to;
+    };
+
+    // Keyframes applied since connecting, every one replaces the whole grid
+    uint64_t GetKeyframeCount();
+    // Tiles deltas changed since the caller last cleared this, in order, may list a tile more than once
+    std::vector<TileChange> ChangedTiles;
+
+private:
+    int fd;
+    // Bytes received that don't make a whole frame yet
+    std::vector<uint8_t> received;
+
+    bool synced;
+    uint64_t keyframes;
+    SpectatorFrame::Header last;
+    std::vector<uint8_t> tiles;
+};
+#endif // _WIN32
+
+#endif // __SPECTATOR_INCLUDED__
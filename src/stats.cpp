@@ -0,0 +1,166 @@
+#include <cmath> // std::sqrt
+
+#include "latency.h" // LatencyHistogram bucket helpers
+
+#include "stats.h" // Class declaration
+
+StreamingStats::StreamingStats() {
+    this->Reset();
+}
+
+void StreamingStats::Add(int64_t value) {
+    this->count++;
+
+    // Welford's update, the running mean moves by the difference over the count
+    double delta = (double)value - this->mean;
+    this->mean += delta / (double)this->count;
+    this->m2 += delta * ((double)value - this->mean);
+
+    this->addToSum((uint64_t)value, value < 0 ? ~(uint64_t)0 : 0);
+
+    if (this->count == 1 || value < this->min) this->min = value;
+    if (this->count == 1 || value > this->max) this->max = value;
+
+    if (value >= 0) {
+        addToSketch(this->positive, (uint64_t)value);
+    } else {
+        // Negated without overflowing on the smallest int64_t
+        addToSketch(this->negative, (uint64_t)(-(value + 1)) + 1);
+    }
+}
+
+void StreamingStats::Merge(const StreamingStats& other) {
+    if (other.count == 0) return;
+    if (this->count == 0) {
+        *this = other;
+        return;
+    }
+
+    // Chan et al.'s pairwise combination of two Welford accumulators
+    uint64_t total = this->count + other.count;
+    double delta = other.mean - this->mean;
+    this->mean += delta * (double)other.count / (double)total;
+    this->m2 += other.m2 + delta * delta * (double)this->count * (double)other.count / (double)total;
+    this->count = total;
+
+    this->addToSum(other.sumLow, other.sumHigh);
+
+    if (other.min < this->min) this->min = other.min;
+    if (other.max > this->max) this->max = other.max;
+
+    if (other.positive.size() > this->positive.size()) this->positive.resize(other.positive.size(), 0);
+    for (size_t i = 0; i < other.positive.size(); i++) this->positive[i] += other.positive[i];
+
+    if (other.negative.size() > this->negative.size()) this->negative.resize(other.negative.size(), 0);
+    for (size_t i = 0; i < other.negative.size(); i++) this->negative[i] += other.negative[i];
+}
+
+void StreamingStats::Reset() {
+    this->count = 0;
+    this->mean = 0;
+    this->m2 = 0;
+    this->min = 0;
+    this->max = 0;
+    this->sumLow = 0;
+    this->sumHigh = 0;
+    this->positive.clear();
+    this->negative.clear();
+}
+
+uint64_t StreamingStats::GetCount() const {
+    return this->count;
+}
+
+double StreamingStats::GetMean() const {
+    return this->mean;
+}
+
+int64_t StreamingStats::GetTruncatedMean() const {
+    if (this->count == 0) return 0;
+
+    // Divide the magnitude of the sum, then put the sign back, so the quotient rounds towards zero
+    bool negative = (this->sumHigh >> 63) != 0;
+    uint64_t low = this->sumLow;
+    uint64_t high = this->sumHigh;
+    if (negative) {
+        low = ~low + 1;
+        high = ~high + (low == 0);
+    }
+
+    // Long division one bit at a time, the quotient fits 64 bits since the mean lies between min and max
+    uint64_t quotient = 0;
+    uint64_t remainder = 0;
+    for (int i = 127; i >= 0; i--) {
+        uint64_t bit = (i >= 64 ? high >> (i - 64) : low >> i) & 1;
+        bool overflow = (remainder >> 63) != 0;
+        remainder = remainder << 1 | bit;
+
+        if (overflow || remainder >= this->count) {
+            remainder -= this->count;
+            if (i < 64) quotient |= (uint64_t)1 << i;
+        }
+    }
+
+    return negative ? -(int64_t)(quotient - 1) - 1 : (int64_t)quotient;
+}
+
+double StreamingStats::GetVariance() const {
+    return this->count > 1 ? this->m2 / (double)this->count : 0;
+}
+
+double StreamingStats::GetStdDev() const {
+    return std::sqrt(this->GetVariance());
+}
+
+int64_t StreamingStats::GetMin() const {
+    return this->min;
+}
+
+int64_t StreamingStats::GetMax() const {
+    return this->max;
+}
+
+int64_t StreamingStats::Percentile(double p) const {
+    if (this->count == 0) return 0;
+
+    // Rank of the wanted value, 1-based, same rounding as LatencyHistogram
+    uint64_t rank = (uint64_t)(p * (double)this->count + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > this->count) rank = this->count;
+
+    // Negative values first, largest magnitude first, their upper edge is the smallest magnitude in the bucket
+    uint64_t seen = 0;
+    for (size_t i = this->negative.size(); i-- > 0;) {
+        seen += this->negative[i];
+        if (seen >= rank) {
+            uint64_t magnitude = LatencyHistogram::BucketLowerBound((int)i);
+            int64_t edge = magnitude == 0 ? 0 : -(int64_t)(magnitude - 1) - 1;
+            return edge < this->max ? edge : this->max;
+        }
+    }
+
+    for (size_t i = 0; i < this->positive.size(); i++) {
+        seen += this->positive[i];
+        if (seen >= rank) {
+            // Bucket edge can't be past the largest value
+            uint64_t bound = LatencyHistogram::BucketUpperBound((int)i);
+            return bound < (uint64_t)this->max ? (int64_t)bound : this->max;
+        }
+    }
+
+    return this->max;
+}
+
+void StreamingStats::addToSum(uint64_t low, uint64_t high) {
+    uint64_t sum = this->sumLow + low;
+    this->sumHigh += high + (sum < low);
+    this->sumLow = sum;
+}
+
+void StreamingStats::addToSketch(std::vector<uint64_t>& sketch, uint64_t magnitude) {
+    size_t index = (size_t)LatencyHistogram::BucketIndex(magnitude);
+
+    // Grows once per new largest bucket, which stops happening quickly for bounded values
+    if (index >= sketch.size()) sketch.resize(index + 1, 0);
+    sketch[index]++;
+}
@@ -0,0 +1,62 @@
+#ifndef __STATS_INCLUDED__
+#define __STATS_INCLUDED__
+
+#include <cstdint> // int64_t, uint64_t
+#include <vector> // std::vector<T>
+
+// Summary of a stream of integers (scores, ticks per game, ...) that never stores the values themselves
+// Mean and variance use Welford's method, so they don't overflow or lose precision on long streams, and
+// min and max are exact. Percentiles come from a sketch with LatencyHistogram's log-linear buckets (one per
+// value below 64, 32 per power of two past that), so they're within ~3% of the real value
+// Accumulators merge, so every thread can keep its own and combine them at the end
+class StreamingStats {
+public:
+    StreamingStats();
+
+    // Add one value
+    void Add(int64_t);
+    // Add every value another accumulator has seen
+    void Merge(const StreamingStats&);
+    // Forget every value
+    void Reset();
+
+    // Amount of values added
+    uint64_t GetCount() const;
+    // Mean, 0 without values
+    double GetMean() const;
+    // Mean rounded towards zero, exact however many values were added (GetMean() can be off by a rounding error,
+    // enough to truncate to the wrong integer), 0 without values
+    int64_t GetTruncatedMean() const;
+    // Population variance and standard deviation, 0 with fewer than two values
+    double GetVariance() const;
+    double GetStdDev() const;
+    // Smallest and largest value, 0 without values
+    int64_t GetMin() const;
+    int64_t GetMax() const;
+    // Value at or under which fraction p (0-1) of values fall, rounded up to its bucket's edge
+    // (but never past the largest value), 0 without values
+    int64_t Percentile(double p) const;
+
+private:
+    uint64_t count;
+    double mean;
+    // Sum of squared differences from the mean
+    double m2;
+    int64_t min;
+    int64_t max;
+    // Exact sum of every value, a 128-bit two's complement number
+    uint64_t sumLow;
+    uint64_t sumHigh;
+
+    // Values per bucket, for values >= 0 and for the magnitude of negative values
+    // Only as long as the largest bucket used, so small values take little memory and merge quickly
+    std::vector<uint64_t> positive;
+    std::vector<uint64_t> negative;
+
+    // Add a 128-bit two's complement number to the sum
+    void addToSum(uint64_t low, uint64_t high);
+    // Count one value in a sketch
+    static void addToSketch(std::vector<uint64_t>&, uint64_t magnitude);
+};
+
+#endif // __STATS_INCLUDED__
@@ -0,0 +1,109 @@
+#include <utility> // std::move
+
+#include "threadpool.h" // Class declaration
+
+// Pool and worker index of the current thread, so tasks submitted from a worker go to its own queue
+static thread_local WorkStealingPool* currentPool = nullptr;
+static thread_local int currentWorker = -1;
+
+WorkStealingPool::WorkStealingPool(int threadCount) : stopping(false), queued(0), pending(0), stolen(0), nextWorker(0) {
+    // hardware_concurrency may return 0 if unknown
+    if (threadCount <= 0) threadCount = (int)std::thread::hardware_concurrency();
+    if (threadCount <= 0) threadCount = 1;
+
+    for (int i = 0; i < threadCount; i++) this->workers.emplace_back(new Worker());
+    for (int i = 0; i < threadCount; i++) this->threads.emplace_back(&WorkStealingPool::work, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    this->Wait();
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->wake.notify_all();
+
+    for (size_t i = 0; i < this->threads.size(); i++) this->threads[i].join();
+}
+
+void WorkStealingPool::Submit(Task task) {
+    int index = currentPool == this ? currentWorker : (int)(this->nextWorker++ % this->workers.size());
+
+    this->pending++;
+    {
+        std::lock_guard<std::mutex> lock(this->workers[index]->mutex);
+        this->workers[index]->tasks.push_back(std::move(task));
+        this->queued++;
+    }
+
+    // Taking the lock makes sure a worker about to sleep either sees the task or gets woken
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+    }
+    this->wake.notify_one();
+}
+
+void WorkStealingPool::Wait() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->idle.wait(lock, [this]() { return this->pending.load() == 0; });
+}
+
+int WorkStealingPool::GetThreadCount() const {
+    return (int)this->workers.size();
+}
+
+uint64_t WorkStealingPool::GetStolenCount() const {
+    return this->stolen.load();
+}
+
+bool WorkStealingPool::take(int index, Task& task) {
+    {
+        Worker& own = *this->workers[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            this->queued--;
+            return true;
+        }
+    }
+
+    for (size_t i = 1; i < this->workers.size(); i++) {
+        Worker& other = *this->workers[(index + i) % this->workers.size()];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if (!other.tasks.empty()) {
+            task = std::move(other.tasks.front());
+            other.tasks.pop_front();
+            this->queued--;
+            this->stolen++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void WorkStealingPool::work(int index) {
+    currentPool = this;
+    currentWorker = index;
+
+    Task task;
+    while (true) {
+        if (this->take(index, task)) {
+            task();
+            task = nullptr;
+
+            // Last task done, wake Wait()
+            if (--this->pending == 0) {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->idle.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->wake.wait(lock, [this]() { return this->stopping || this->queued.load() > 0; });
+        if (this->stopping) return;
+    }
+}
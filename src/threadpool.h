@@ -0,0 +1,71 @@
+#ifndef __THREADPOOL_INCLUDED__
+#define __THREADPOOL_INCLUDED__
+
+#include <atomic> // std::atomic<T>
+#include <condition_variable> // std::condition_variable
+#include <cstdint> // uint64_t
+#include <deque> // std::deque<T>
+#include <functional> // std::function<T>
+#include <memory> // std::unique_ptr<T>
+#include <mutex> // std::mutex
+#include <thread> // std::thread
+#include <vector> // std::vector<T>
+
+// Fixed set of worker threads running short tasks, for work that's handed out many times a second
+// Every worker has its own queue: tasks a worker submits go to its own queue and it runs the newest first,
+// tasks submitted from outside are spread over the queues, and a worker with an empty queue steals the oldest
+// task of another worker, so busy or descheduled workers don't hold up the rest
+// Idle workers sleep until there's something to run
+class WorkStealingPool {
+public:
+    typedef std::function<void()> Task;
+
+    // Pool of n worker threads, 0 uses every hardware thread
+    explicit WorkStealingPool(int);
+    // Waits for every task to finish
+    ~WorkStealingPool();
+
+    // Owns its threads
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Queue a task, tasks may submit more tasks
+    void Submit(Task);
+    // Block until every submitted task has finished, including tasks submitted by tasks
+    // Not to be called from a task
+    void Wait();
+
+    // Worker threads
+    int GetThreadCount() const;
+    // Tasks run by another worker than the one they were queued on, since construction
+    uint64_t GetStolenCount() const;
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    // Sleeping workers and Wait() block on these
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    bool stopping;
+
+    // Tasks in queues, and tasks submitted but not finished
+    std::atomic<uint64_t> queued;
+    std::atomic<uint64_t> pending;
+    std::atomic<uint64_t> stolen;
+    // Queue the next task from outside the pool goes to
+    std::atomic<uint32_t> nextWorker;
+
+    // Take a task for worker index, its own newest or another's oldest
+    bool take(int, Task&);
+    // Worker thread loop
+    void work(int);
+};
+
+#endif // __THREADPOOL_INCLUDED__
@@ -0,0 +1,95 @@
+#include "timerwheel.h" // Class declaration
+
+// End of a slot's list
+const uint32_t NO_TIMER = 0xffffffff;
+
+TimerWheel::TimerWheel(uint64_t now) : current(now + 1), count(0) {
+    this->heads.assign(SlotCount, NO_TIMER);
+}
+
+void TimerWheel::Schedule(uint32_t id, uint64_t deadline) {
+    if (id >= this->scheduled.size()) {
+        this->next.resize((size_t)id + 1, NO_TIMER);
+        this->prev.resize((size_t)id + 1, NO_TIMER);
+        this->slots.resize((size_t)id + 1, 0);
+        this->deadlines.resize((size_t)id + 1, 0);
+        this->scheduled.resize((size_t)id + 1, 0);
+    }
+
+    if (this->scheduled[id]) this->unlink(id);
+    else this->count++;
+
+    // Past deadlines go in the next slot Advance() looks at
+    uint32_t slot = (uint32_t)((deadline > this->current ? deadline : this->current) % SlotCount);
+
+    this->deadlines[id] = deadline;
+    this->slots[id] = slot;
+    this->scheduled[id] = 1;
+    this->prev[id] = NO_TIMER;
+    this->next[id] = this->heads[slot];
+    if (this->heads[slot] != NO_TIMER) this->prev[this->heads[slot]] = id;
+    this->heads[slot] = id;
+}
+
+void TimerWheel::Cancel(uint32_t id) {
+    if (!this->IsScheduled(id)) return;
+
+    this->unlink(id);
+    this->scheduled[id] = 0;
+    this->count--;
+}
+
+bool TimerWheel::IsScheduled(uint32_t id) {
+    return id < this->scheduled.size() && this->scheduled[id];
+}
+
+void TimerWheel::Advance(uint64_t now, std::vector<uint32_t>& due) {
+    if (now + 1 < this->current) return;
+
+    // Every slot at most once, a jump of more than a whole turn still finds every due timer on its one pass
+    // Advancing to the same time again only looks at the slot timers scheduled in the past went to
+    uint64_t last = now < this->current ? this->current : now - this->current >= SlotCount ? this->current + SlotCount - 1 : now;
+    for (uint64_t time = this->current; time <= last && this->count > 0; time++) {
+        uint32_t id = this->heads[time % SlotCount];
+
+        while (id != NO_TIMER) {
+            uint32_t following = this->next[id];
+
+            if (this->deadlines[id] <= now) {
+                this->unlink(id);
+                this->scheduled[id] = 0;
+                this->count--;
+                due.push_back(id);
+            }
+
+            id = following;
+        }
+    }
+
+    if (now + 1 > this->current) this->current = now + 1;
+}
+
+int64_t TimerWheel::GetTimeToNext() {
+    if (this->count == 0) return -1;
+
+    for (uint32_t i = 0; i < SlotCount; i++) {
+        if (this->heads[(this->current + i) % SlotCount] != NO_TIMER) return (int64_t)i + 1;
+    }
+
+    return SlotCount;
+}
+
+uint64_t TimerWheel::GetTime() {
+    return this->current - 1;
+}
+
+uint32_t TimerWheel::GetCount() {
+    return this->count;
+}
+
+void TimerWheel::unlink(uint32_t id) {
+    if (this->prev[id] != NO_TIMER) this->next[this->prev[id]] = this->next[id];
+    else this->heads[this->slots[id]] = this->next[id];
+
+    if (this->next[id] != NO_TIMER) this->prev[this->next[id]] = this->prev[id];
+}
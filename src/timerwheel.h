@@ -0,0 +1,57 @@
+#ifndef __TIMERWHEEL_INCLUDED__
+#define __TIMERWHEEL_INCLUDED__
+
+#include <cstddef> // size_t
+#include <cstdint> // uint8_t, uint32_t, uint64_t, int64_t
+#include <vector> // std::vector<T>
+
+// Hashed timing wheel, for keeping thousands of repeating timers
+// Timers are identified by index, and a timer due at time t sits in slot t % SlotCount, in an intrusive list,
+// so scheduling, cancelling and expiring a timer are O(1) however many there are. Deadlines further than
+// SlotCount away share slots with nearer ones, and stay put until a pass over their slot finds them due
+// Time is counted in whatever unit the caller picks (the resolution), it only has to never go backwards
+class TimerWheel {
+public:
+    static const uint32_t SlotCount = 1024;
+
+    // Wheel starting at time now
+    TimerWheel(uint64_t now);
+
+    // Set timer id (any index, storage grows to fit) to expire at deadline, replacing any earlier deadline
+    // A deadline that already passed expires on the next Advance()
+    void Schedule(uint32_t id, uint64_t deadline);
+    // Stop a timer from expiring (does nothing if it isn't scheduled)
+    void Cancel(uint32_t id);
+    bool IsScheduled(uint32_t id);
+
+    // Move time forward to now, and append every timer that expired to due, in no particular order
+    // Expired timers aren't scheduled anymore
+    void Advance(uint64_t now, std::vector<uint32_t>& due);
+    // Time from the current time until the earliest slot with a timer in it, at most SlotCount, -1 without timers
+    // Never later than the next deadline, but a far deadline can make it earlier
+    int64_t GetTimeToNext();
+
+    // Time the wheel is at, the last Advance() (or the starting time)
+    uint64_t GetTime();
+    // Scheduled timers
+    uint32_t GetCount();
+
+private:
+    // Next time Advance() has to look at
+    uint64_t current;
+    uint32_t count;
+
+    // First timer in every slot
+    std::vector<uint32_t> heads;
+    // Per timer: neighbours in its slot's list, its slot, deadline, and whether it's scheduled
+    std::vector<uint32_t> next;
+    std::vector<uint32_t> prev;
+    std::vector<uint32_t> slots;
+    std::vector<uint64_t> deadlines;
+    std::vector<uint8_t> scheduled;
+
+    // Take a timer out of its slot's list
+    void unlink(uint32_t id);
+};
+
+#endif // __TIMERWHEEL_INCLUDED__
@@ -0,0 +1,66 @@
+#include <cstring> // std::memcpy
+
+#include "zobrist.h" // Class declarations
+
+TranspositionTable::TranspositionTable(size_t bytes) {
+    size_t count = 1;
+    while (count * 2 * sizeof(Bucket) <= bytes) count *= 2;
+
+    this->buckets.reset(new Bucket[count]);
+    this->mask = count - 1;
+    this->Clear();
+}
+
+bool TranspositionTable::Probe(uint64_t hash, Entry& entry) const {
+    const Bucket& bucket = this->buckets[hash & this->mask];
+
+    for (int i = 0; i < 4; i += 2) {
+        uint64_t check = bucket.words[i].load(std::memory_order_relaxed);
+        uint64_t data = bucket.words[i + 1].load(std::memory_order_relaxed);
+
+        // Empty entries, other states and torn writes all fail the check
+        if ((check ^ data) == hash && (check | data) != 0) {
+            entry = unpack(data);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TranspositionTable::Store(uint64_t hash, const Entry& entry) {
+    Bucket& bucket = this->buckets[hash & this->mask];
+    uint64_t data = pack(entry);
+
+    // Same state or a deeper search takes the first entry, anything else goes in the second
+    uint64_t check = bucket.words[0].load(std::memory_order_relaxed);
+    uint64_t kept = bucket.words[1].load(std::memory_order_relaxed);
+    int slot = 2;
+    if ((check ^ kept) == hash || (check | kept) == 0 || unpack(kept).depth <= entry.depth) slot = 0;
+
+    bucket.words[slot].store(hash ^ data, std::memory_order_relaxed);
+    bucket.words[slot + 1].store(data, std::memory_order_relaxed);
+}
+
+void TranspositionTable::Clear() {
+    for (size_t i = 0; i <= this->mask; i++) {
+        for (int j = 0; j < 4; j++) this->buckets[i].words[j].store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t TranspositionTable::GetCapacity() const {
+    return (this->mask + 1) * 2;
+}
+
+uint64_t TranspositionTable::pack(const Entry& entry) {
+    uint64_t data;
+    static_assert(sizeof(Entry) == sizeof(data), "Entry must pack into 64 bits");
+    std::memcpy(&data, &entry, sizeof(data));
+    return data;
+}
+
+TranspositionTable::Entry TranspositionTable::unpack(uint64_t data) {
+    Entry entry;
+    std::memcpy(&entry, &data, sizeof(entry));
+    return entry;
+}
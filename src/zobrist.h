@@ -0,0 +1,99 @@
+#ifndef __ZOBRIST_INCLUDED__
+#define __ZOBRIST_INCLUDED__
+
+#include <atomic> // std::atomic<T>
+#include <cstddef> // size_t
+#include <cstdint> // uint8_t, uint16_t, uint32_t, uint64_t, int32_t
+#include <memory> // std::unique_ptr<T>
+
+// Zobrist keys for game state hashes (see BasicSnakeGame::GetHash()), a state hashes to the XOR of the keys of
+// every tile holding something, the head position, the direction and the length
+// Keys are computed from what they stand for instead of looked up in tables of random numbers, so any grid size
+// works without memory, and every game and thread agrees on them. Each kind of key gets its own range of inputs
+struct ZobristKeys {
+    // Key of a tile holding tile (a SnakeTypes::Tile value), 0 for empty tiles, so an empty grid hashes to 0
+    static uint64_t Tile(uint32_t cell, uint8_t tile) {
+        return tile == 0 ? 0 : mix((uint64_t)cell << 2 | tile);
+    }
+
+    static uint64_t Head(uint32_t cell) {
+        // Tile values only go up to 2, 3 is left for heads
+        return mix((uint64_t)cell << 2 | 3);
+    }
+
+    static uint64_t Direction(uint8_t direction) {
+        return mix((uint64_t)1 << 63 | direction);
+    }
+
+    static uint64_t Length(uint32_t length) {
+        return mix((uint64_t)1 << 62 | length);
+    }
+
+    // Moves pay for a few keys every tick, so where the compiler has 128-bit integers, keys take a single
+    // multiply: the high and low halves of a 64x64-bit product, folded (as in wyhash)
+    // MurmurHash3's 64-bit finalizer otherwise, keys differ between the two but never persist
+    static uint64_t mix(uint64_t value) {
+#ifdef __SIZEOF_INT128__
+        unsigned __int128 product = (unsigned __int128)(value ^ 0x2d358dccaa6c78a5ULL) * 0x8bb84b93962eacc9ULL;
+        return (uint64_t)product ^ (uint64_t)(product >> 64);
+#else // __SIZEOF_INT128__
+        value ^= value >> 33;
+        value *= 0xff51afd7ed558ccdULL;
+        value ^= value >> 33;
+        value *= 0xc4ceb9fe1a85ec53ULL;
+        value ^= value >> 33;
+        return value;
+#endif // __SIZEOF_INT128__
+    }
+};
+
+// Fixed-size cache of search results keyed by state hash, shared by any number of threads without locks
+// Buckets hold two entries: one kept for the deepest search of the states landing there, one always replaced
+// Every entry is two 64-bit words written separately, the hash XORed with the data, and the data, so an entry
+// torn by two threads writing at once no longer matches any hash and reads as missing instead of as wrong data
+// Different states with the same hash share entries, callers should treat results as hints
+class TranspositionTable {
+public:
+    // What search code keeps about a state, packed into 64 bits
+    struct Entry {
+        // Score or estimate of the state, meaning is up to the caller
+        int32_t value;
+        // How much search the value is based on (depth, rollouts, ...), deeper entries are kept over shallower ones
+        uint16_t depth;
+        // Best direction found from the state
+        uint8_t move;
+        // Free for the caller
+        uint8_t flags;
+    };
+
+    // Table of about bytes bytes (rounded down to a power of two buckets, at least one), every entry empty
+    explicit TranspositionTable(size_t bytes);
+
+    // Owns its entries
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    // Look up a state, returns false if nothing is stored for it
+    bool Probe(uint64_t hash, Entry& entry) const;
+    // Store what's known about a state
+    void Store(uint64_t hash, const Entry& entry);
+    // Empty every entry, not safe while other threads use the table
+    void Clear();
+
+    // Entries the table holds
+    size_t GetCapacity() const;
+
+private:
+    // Two entries of two words each
+    struct Bucket {
+        std::atomic<uint64_t> words[4];
+    };
+
+    std::unique_ptr<Bucket[]> buckets;
+    size_t mask;
+
+    static uint64_t pack(const Entry&);
+    static Entry unpack(uint64_t);
+};
+
+#endif // __ZOBRIST_INCLUDED__